@@ -0,0 +1,114 @@
+/*
+ * The scripts of every app control, see app_control_scripts in
+ * hid_app_control.h. Nothing here depends on the device: the host tests
+ * compile this same table.
+ */
+
+#include "hid_app_control.h"
+
+// GLOBAL VARIBLES
+
+static const command_code_t zoom_mobile_steps[ZOOM_CONTROL_MOBILE_NUM_SCRIPTS][ZOOM_CONTROL_MAX_STEPS + 1] = {
+    {ZOOM_CONTROL_MOBILE_TOGGLE_MIC_SCRIPT},
+    {ZOOM_CONTROL_MOBILE_TOGGLE_VID_SCRIPT},
+    {ZOOM_CONTROL_MOBILE_JOIN1_SCRIPT},
+    {ZOOM_CONTROL_MOBILE_OPEN_APP_SCRIPT},
+    {ZOOM_CONTROL_MOBILE_STILL_DECIDING_SCRIPT},
+};
+
+static const command_code_t zoom_pc_steps[ZOOM_CONTROL_PC_NUM_SCRIPTS][ZOOM_CONTROL_MAX_STEPS + 1] = {
+    {ZOOM_CONTROL_PC_TOGGLE_MIC_SCRIPT},
+    {ZOOM_CONTROL_PC_TOGGLE_VID_SCRIPT},
+    {ZOOM_CONTROL_PC_IMPROV_VID_SCRIPT},
+    {ZOOM_CONTROL_PC_OPEN_APP_SCRIPT},
+    {ZOOM_CONTROL_PC_STILL_DECIDING_SCRIPT},
+};
+
+static const command_code_t skype_mobile_steps[SKYPE_CONTROL_MOBILE_NUM_SCRIPTS][SKYPE_CONTROL_MAX_STEPS + 1] = {
+    {SKYPE_CONTROL_MOBILE_TOGGLE_MIC_SCRIPT},
+    {SKYPE_CONTROL_MOBILE_TOGGLE_VID_SCRIPT},
+    {SKYPE_CONTROL_MOBILE_IMPROV_VID_SCRIPT},
+    {SKYPE_CONTROL_MOBILE_OPEN_APP_SCRIPT},
+    {SKYPE_CONTROL_MOBILE_STILL_DECIDING_SCRIPT},
+};
+
+static const command_code_t skype_pc_steps[SKYPE_CONTROL_PC_NUM_SCRIPTS][SKYPE_CONTROL_MAX_STEPS + 1] = {
+    {SKYPE_CONTROL_PC_TOGGLE_MIC_SCRIPT},
+    {SKYPE_CONTROL_PC_TOGGLE_VID_SCRIPT},
+    {SKYPE_CONTROL_PC_IMPROV_VID_SCRIPT},
+    {SKYPE_CONTROL_PC_OPEN_APP_SCRIPT},
+    {SKYPE_CONTROL_PC_STILL_DECIDING_SCRIPT},
+};
+
+static const command_code_t meet_mobile_steps[MEET_CONTROL_MOBILE_NUM_SCRIPTS][MEET_CONTROL_MAX_STEPS + 1] = {
+    {MEET_CONTROL_MOBILE_TOGGLE_MIC_SCRIPT},
+    {MEET_CONTROL_MOBILE_TOGGLE_VID_SCRIPT},
+    {MEET_CONTROL_MOBILE_IMPROV_VID_SCRIPT},
+    {MEET_CONTROL_MOBILE_OPEN_APP_SCRIPT},
+    {MEET_CONTROL_MOBILE_STILL_DECIDING_SCRIPT},
+};
+
+static const command_code_t meet_pc_steps[MEET_CONTROL_PC_NUM_SCRIPTS][MEET_CONTROL_MAX_STEPS + 1] = {
+    {MEET_CONTROL_PC_TOGGLE_MIC_SCRIPT},
+    {MEET_CONTROL_PC_TOGGLE_VID_SCRIPT},
+    {MEET_CONTROL_PC_IMPROV_VID_SCRIPT},
+    {MEET_CONTROL_PC_OPEN_APP_SCRIPT},
+    {MEET_CONTROL_PC_STILL_DECIDING_SCRIPT},
+};
+
+static const app_control_script_row_t zoom_mobile_rows[ZOOM_CONTROL_MOBILE_NUM_SCRIPTS] = {
+    {"ZOOM_CONTROL_MOBILE_TOGGLE_MIC", zoom_mobile_steps[ZOOM_CONTROL_MOBILE_TOGGLE_MIC]},
+    {"ZOOM_CONTROL_MOBILE_TOGGLE_VID", zoom_mobile_steps[ZOOM_CONTROL_MOBILE_TOGGLE_VID]},
+    {"ZOOM_CONTROL_MOBILE_JOIN1", zoom_mobile_steps[ZOOM_CONTROL_MOBILE_JOIN1]},
+    {"ZOOM_CONTROL_MOBILE_OPEN_APP", zoom_mobile_steps[ZOOM_CONTROL_MOBILE_OPEN_APP]},
+    {"ZOOM_CONTROL_MOBILE_STILL_DECIDING", zoom_mobile_steps[ZOOM_CONTROL_MOBILE_STILL_DECIDING]},
+};
+
+static const app_control_script_row_t zoom_pc_rows[ZOOM_CONTROL_PC_NUM_SCRIPTS] = {
+    {"ZOOM_CONTROL_PC_TOGGLE_MIC", zoom_pc_steps[ZOOM_CONTROL_PC_TOGGLE_MIC]},
+    {"ZOOM_CONTROL_PC_TOGGLE_VID", zoom_pc_steps[ZOOM_CONTROL_PC_TOGGLE_VID]},
+    {"ZOOM_CONTROL_PC_IMPROV_VID", zoom_pc_steps[ZOOM_CONTROL_PC_IMPROV_VID]},
+    {"ZOOM_CONTROL_PC_OPEN_APP", zoom_pc_steps[ZOOM_CONTROL_PC_OPEN_APP]},
+    {"ZOOM_CONTROL_PC_STILL_DECIDING", zoom_pc_steps[ZOOM_CONTROL_PC_STILL_DECIDING]},
+};
+
+static const app_control_script_row_t skype_mobile_rows[SKYPE_CONTROL_MOBILE_NUM_SCRIPTS] = {
+    {"SKYPE_CONTROL_MOBILE_TOGGLE_MIC", skype_mobile_steps[SKYPE_CONTROL_MOBILE_TOGGLE_MIC]},
+    {"SKYPE_CONTROL_MOBILE_TOGGLE_VID", skype_mobile_steps[SKYPE_CONTROL_MOBILE_TOGGLE_VID]},
+    {"SKYPE_CONTROL_MOBILE_IMPROV_VID", skype_mobile_steps[SKYPE_CONTROL_MOBILE_IMPROV_VID]},
+    {"SKYPE_CONTROL_MOBILE_OPEN_APP", skype_mobile_steps[SKYPE_CONTROL_MOBILE_OPEN_APP]},
+    {"SKYPE_CONTROL_MOBILE_STILL_DECIDING", skype_mobile_steps[SKYPE_CONTROL_MOBILE_STILL_DECIDING]},
+};
+
+static const app_control_script_row_t skype_pc_rows[SKYPE_CONTROL_PC_NUM_SCRIPTS] = {
+    {"SKYPE_CONTROL_PC_TOGGLE_MIC", skype_pc_steps[SKYPE_CONTROL_PC_TOGGLE_MIC]},
+    {"SKYPE_CONTROL_PC_TOGGLE_VID", skype_pc_steps[SKYPE_CONTROL_PC_TOGGLE_VID]},
+    {"SKYPE_CONTROL_PC_IMPROV_VID", skype_pc_steps[SKYPE_CONTROL_PC_IMPROV_VID]},
+    {"SKYPE_CONTROL_PC_OPEN_APP", skype_pc_steps[SKYPE_CONTROL_PC_OPEN_APP]},
+    {"SKYPE_CONTROL_PC_STILL_DECIDING", skype_pc_steps[SKYPE_CONTROL_PC_STILL_DECIDING]},
+};
+
+static const app_control_script_row_t meet_mobile_rows[MEET_CONTROL_MOBILE_NUM_SCRIPTS] = {
+    {"MEET_CONTROL_MOBILE_TOGGLE_MIC", meet_mobile_steps[MEET_CONTROL_MOBILE_TOGGLE_MIC]},
+    {"MEET_CONTROL_MOBILE_TOGGLE_VID", meet_mobile_steps[MEET_CONTROL_MOBILE_TOGGLE_VID]},
+    {"MEET_CONTROL_MOBILE_IMPROV_VID", meet_mobile_steps[MEET_CONTROL_MOBILE_IMPROV_VID]},
+    {"MEET_CONTROL_MOBILE_OPEN_APP", meet_mobile_steps[MEET_CONTROL_MOBILE_OPEN_APP]},
+    {"MEET_CONTROL_MOBILE_STILL_DECIDING", meet_mobile_steps[MEET_CONTROL_MOBILE_STILL_DECIDING]},
+};
+
+static const app_control_script_row_t meet_pc_rows[MEET_CONTROL_PC_NUM_SCRIPTS] = {
+    {"MEET_CONTROL_PC_TOGGLE_MIC", meet_pc_steps[MEET_CONTROL_PC_TOGGLE_MIC]},
+    {"MEET_CONTROL_PC_TOGGLE_VID", meet_pc_steps[MEET_CONTROL_PC_TOGGLE_VID]},
+    {"MEET_CONTROL_PC_IMPROV_VID", meet_pc_steps[MEET_CONTROL_PC_IMPROV_VID]},
+    {"MEET_CONTROL_PC_OPEN_APP", meet_pc_steps[MEET_CONTROL_PC_OPEN_APP]},
+    {"MEET_CONTROL_PC_STILL_DECIDING", meet_pc_steps[MEET_CONTROL_PC_STILL_DECIDING]},
+};
+
+const app_control_scripts_t app_control_scripts[CONTROL_SCRIPTS_SETS] = {
+    {ZOOM_CONTROL_MOBILE_ID, ZOOM_CONTROL_MOBILE_NUM_SCRIPTS, ZOOM_CONTROL_MAX_STEPS, zoom_mobile_rows},
+    {ZOOM_CONTROL_PC_ID, ZOOM_CONTROL_PC_NUM_SCRIPTS, ZOOM_CONTROL_MAX_STEPS, zoom_pc_rows},
+    {SKYPE_CONTROL_MOBILE_ID, SKYPE_CONTROL_MOBILE_NUM_SCRIPTS, SKYPE_CONTROL_MAX_STEPS, skype_mobile_rows},
+    {SKYPE_CONTROL_PC_ID, SKYPE_CONTROL_PC_NUM_SCRIPTS, SKYPE_CONTROL_MAX_STEPS, skype_pc_rows},
+    {MEET_CONTROL_MOBILE_ID, MEET_CONTROL_MOBILE_NUM_SCRIPTS, MEET_CONTROL_MAX_STEPS, meet_mobile_rows},
+    {MEET_CONTROL_PC_ID, MEET_CONTROL_PC_NUM_SCRIPTS, MEET_CONTROL_MAX_STEPS, meet_pc_rows},
+};
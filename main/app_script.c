@@ -0,0 +1,290 @@
+/*
+ * Compiler for the app control scripts, see app_script.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "app_script.h"
+
+// one bit per byte of a script: where the instructions start
+#define APP_SCRIPT_MARK(marks, pc) ((marks)[(pc) >> 3] |= (1 << ((pc)&0x07)))
+#define APP_SCRIPT_MARKED(marks, pc) ((marks)[(pc) >> 3] & (1 << ((pc)&0x07)))
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static bool app_script_is_key(uint8_t key);
+
+// FUNCTION DEFINITIONS
+
+void app_script_image_reset(app_script_image_t *image)
+{
+    memset(image, 0, sizeof(app_script_image_t));
+}
+
+uint8_t app_script_op_length(const uint8_t *code, uint8_t remaining)
+{
+    uint8_t length;
+
+    if (!remaining)
+        return 0;
+
+    if (code[0] == APP_SCRIPT_OP_END)
+        return 0;
+    else if (code[0] == APP_SCRIPT_OP_SPECIAL)
+        length = 2; // opcode + special action index
+    else if (code[0] == APP_SCRIPT_OP_CONSUMER)
+        length = 2; // opcode + consumer usage
+    else if (code[0] == APP_SCRIPT_OP_PRESS || code[0] == APP_SCRIPT_OP_RELEASE)
+        length = 2; // opcode + key
+    else if (code[0] == APP_SCRIPT_OP_TYPE_STRING || code[0] == APP_SCRIPT_OP_CALL)
+        length = 2; // opcode + string or script id
+    else if (code[0] == APP_SCRIPT_OP_WAIT)
+        length = 3; // opcode + ms
+    else if (code[0] == APP_SCRIPT_OP_REPEAT || code[0] == APP_SCRIPT_OP_JUMP_IF_LED)
+        length = 3; // opcode + count or LED mask + bytes of the body or skipped
+    else if (code[0] == APP_SCRIPT_OP_MOUSE_MOVE)
+        length = 5; // opcode + X and Y
+    else if (code[0] == APP_SCRIPT_OP_TAP)
+        length = 3; // opcode + X and Y
+    else if (code[0] >= APP_SCRIPT_OP_COMBINE_BASE &&
+             code[0] <= APP_SCRIPT_OP_COMBINE_BASE + APP_SCRIPT_OP_COMBINE_MAX)
+    {
+        length = code[0] - APP_SCRIPT_OP_COMBINE_BASE;
+        if (length < APP_SCRIPT_OP_COMBINE_MIN)
+            return 0;
+        length += 1; // opcode + keys to combine
+    }
+    else
+        length = 1; // plain key or mouse button
+
+    return (length <= remaining) ? length : 0;
+}
+
+uint16_t app_script_compile(app_script_image_t *image,
+                            const int *steps, uint8_t num_steps)
+{
+    uint8_t row[256];
+    uint8_t i, k;
+    uint8_t length = 0;
+    uint8_t op_length;
+    uint16_t offset = image->used;
+
+    // the row is narrowed to bytes first, every opcode fits in a uint8_t
+    for (i = 1; i < num_steps; i++)
+    {
+        if (steps[i] < 0 || steps[i] > 0xFF)
+        {
+            printf("app_script: step %d out of range (%d)\n", i, steps[i]);
+            return APP_SCRIPT_INVALID_OFFSET;
+        }
+        row[i - 1] = (uint8_t)steps[i];
+    }
+
+    // strip the ACTION_NONE padding: the script ends at the first
+    // ACTION_NONE found where an opcode is expected (operands may be 0)
+    for (i = 0; i < num_steps - 1; i += op_length)
+    {
+        if (row[i] == APP_SCRIPT_OP_END)
+            break;
+
+        op_length = app_script_op_length(&row[i], num_steps - 1 - i);
+        if (!op_length)
+        {
+            printf("app_script: malformed opcode %d at step %d\n", row[i], i + 1);
+            return APP_SCRIPT_INVALID_OFFSET;
+        }
+        length += op_length;
+    }
+
+    if (!app_script_validate(row, length))
+        return APP_SCRIPT_INVALID_OFFSET;
+
+    if (offset + 1 + length > APP_SCRIPT_IMAGE_SIZE)
+    {
+        printf("app_script: image full, can't add %d bytes\n", length + 1);
+        return APP_SCRIPT_INVALID_OFFSET;
+    }
+
+    image->code[offset] = length;
+    for (k = 0; k < length; k++)
+        image->code[offset + 1 + k] = row[k];
+
+    image->used += 1 + length;
+
+    return offset;
+}
+
+const uint8_t *app_script_get(const app_script_image_t *image,
+                              uint16_t offset, uint8_t *length)
+{
+    if (offset >= image->used)
+    {
+        *length = 0;
+        return NULL;
+    }
+
+    *length = image->code[offset];
+    return &image->code[offset + 1];
+}
+
+bool app_script_validate(const uint8_t *code, uint8_t length)
+{
+    uint8_t starts[256 / 8] = {0};
+    uint16_t pc;
+    uint16_t target;
+    uint16_t repeat_end = 0; // end of the REPEAT body being checked, 0 if none
+    uint8_t op_length;
+
+    // first pass: where the instructions start, and their operands
+    for (pc = 0; pc < length; pc += op_length)
+    {
+        op_length = app_script_op_length(&code[pc], length - pc);
+        if (!op_length)
+        {
+            printf("app_script: malformed opcode %d at %d\n", code[pc], pc);
+            return false;
+        }
+        APP_SCRIPT_MARK(starts, pc);
+
+        if ((code[pc] == APP_SCRIPT_OP_PRESS && !app_script_is_key(code[pc + 1])) ||
+            (code[pc] == APP_SCRIPT_OP_RELEASE && code[pc + 1] != APP_SCRIPT_KEY_ALL &&
+             !app_script_is_key(code[pc + 1])))
+        {
+            printf("app_script: %d is not a key, at %d\n", code[pc + 1], pc);
+            return false;
+        }
+    }
+    APP_SCRIPT_MARK(starts, length); // jumping to the end is fine
+
+    // second pass: REPEAT bodies and jumps
+    for (pc = 0; pc < length; pc += app_script_op_length(&code[pc], length - pc))
+    {
+        if (repeat_end && pc >= repeat_end)
+            repeat_end = 0;
+
+        if (code[pc] != APP_SCRIPT_OP_REPEAT && code[pc] != APP_SCRIPT_OP_JUMP_IF_LED)
+            continue;
+
+        target = pc + 3 + code[pc + 2];
+        if (target > length || !APP_SCRIPT_MARKED(starts, target))
+        {
+            printf("app_script: %s at %d ends inside an instruction\n",
+                   (code[pc] == APP_SCRIPT_OP_REPEAT) ? "REPEAT" : "JUMP_IF_LED", pc);
+            return false;
+        }
+
+        if (code[pc] == APP_SCRIPT_OP_REPEAT)
+        {
+            if (repeat_end)
+            {
+                printf("app_script: nested REPEAT at %d\n", pc);
+                return false;
+            }
+            if (code[pc + 2] == 0)
+            {
+                printf("app_script: empty REPEAT at %d\n", pc);
+                return false;
+            }
+            repeat_end = target;
+        }
+        else if (repeat_end && target > repeat_end)
+        {
+            printf("app_script: JUMP_IF_LED at %d leaves the REPEAT body\n", pc);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void app_script_disassemble(const uint8_t *code, uint8_t length)
+{
+    uint16_t pc;
+    uint8_t op_length;
+    uint8_t op;
+    uint8_t i;
+
+    for (pc = 0; pc < length; pc += op_length)
+    {
+        op = code[pc];
+        op_length = app_script_op_length(&code[pc], length - pc);
+        if (!op_length)
+        {
+            printf("%3d: ??? %d\n", pc, op);
+            return;
+        }
+
+        printf("%3d: ", pc);
+        switch (op)
+        {
+        case APP_SCRIPT_OP_SPECIAL:
+            printf("SPECIAL %d\n", code[pc + 1]);
+            break;
+        case APP_SCRIPT_OP_CONSUMER:
+            printf("CONSUMER %d\n", code[pc + 1]);
+            break;
+        case APP_SCRIPT_OP_PRESS:
+            printf("PRESS %d\n", code[pc + 1]);
+            break;
+        case APP_SCRIPT_OP_RELEASE:
+            if (code[pc + 1] == APP_SCRIPT_KEY_ALL)
+                printf("RELEASE ALL\n");
+            else
+                printf("RELEASE %d\n", code[pc + 1]);
+            break;
+        case APP_SCRIPT_OP_WAIT:
+            printf("WAIT %d ms\n", code[pc + 1] | (code[pc + 2] << 8));
+            break;
+        case APP_SCRIPT_OP_REPEAT:
+            printf("REPEAT %d times up to %d\n", code[pc + 1], pc + 3 + code[pc + 2]);
+            break;
+        case APP_SCRIPT_OP_JUMP_IF_LED:
+            printf("JUMP_IF_LED 0x%02x to %d\n", code[pc + 1], pc + 3 + code[pc + 2]);
+            break;
+        case APP_SCRIPT_OP_TYPE_STRING:
+            printf("TYPE_STRING %d\n", code[pc + 1]);
+            break;
+        case APP_SCRIPT_OP_MOUSE_MOVE:
+            printf("MOUSE_MOVE %d, %d\n", (int16_t)(code[pc + 1] | (code[pc + 2] << 8)),
+                   (int16_t)(code[pc + 3] | (code[pc + 4] << 8)));
+            break;
+        case APP_SCRIPT_OP_TAP:
+            printf("TAP %d%%, %d%%\n", code[pc + 1], code[pc + 2]);
+            break;
+        case APP_SCRIPT_OP_CALL:
+            printf("CALL %d\n", code[pc + 1]);
+            break;
+        case APP_SCRIPT_OP_MOUSE_LEFT:
+            printf("CLICK LEFT\n");
+            break;
+        case APP_SCRIPT_OP_MOUSE_MIDDLE:
+            printf("CLICK MIDDLE\n");
+            break;
+        case APP_SCRIPT_OP_MOUSE_RIGHT:
+            printf("CLICK RIGHT\n");
+            break;
+        default:
+            if (op_length > 1) // combination
+            {
+                printf("COMBINE");
+                for (i = 1; i < op_length; i++)
+                    printf(" %d", code[pc + i]);
+                printf("\n");
+            }
+            else
+            {
+                printf("KEY %d\n", op);
+            }
+            break;
+        }
+    }
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+// a keyboard key or a modifier, not an opcode
+static bool app_script_is_key(uint8_t key)
+{
+    return key != APP_SCRIPT_OP_END && key <= APP_SCRIPT_KEY_MODIFIER_LAST;
+}
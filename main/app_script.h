@@ -0,0 +1,102 @@
+/*
+ * Compiler for the app control scripts.
+ *
+ * The scripts defined in hid_app_control.h are fixed-size rows padded
+ * with ACTION_NONE. At registration time every row is compiled into one
+ * contiguous, length-prefixed bytecode image:
+ *
+ *   image: [len][op][op]...[len][op]...
+ *
+ * Each app control keeps only the offsets of its scripts inside the
+ * image, so the interpreter can run straight through a script without
+ * padding steps, mallocs or pointer chasing.
+ *
+ * Every script is validated when it's compiled (operands, REPEAT bodies
+ * and jump targets), a malformed one is refused. Nothing here depends
+ * on the device: the compiler, the validator and the disassembler also
+ * build on a host, to check the scripts before flashing them.
+ */
+
+#ifndef APP_SCRIPT_H
+#define APP_SCRIPT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define APP_SCRIPT_IMAGE_SIZE 512      // bytes available for all the compiled scripts
+#define APP_SCRIPT_INVALID_OFFSET 0xFFFF
+
+// opcodes shared with the script definitions (see hid_app_control.h)
+#define APP_SCRIPT_OP_END 0             // same as ACTION_NONE
+#define APP_SCRIPT_OP_SPECIAL 232       // same as ACTION_SPECIAL, 1 operand
+#define APP_SCRIPT_OP_CONSUMER 233      // same as ACTION_CONSUMER, 1 operand: HID_CONSUMER_* usage
+#define APP_SCRIPT_OP_PRESS 234         // same as ACTION_PRESS, 1 operand: key, held until released
+#define APP_SCRIPT_OP_RELEASE 235       // same as ACTION_RELEASE, 1 operand: key, 0 releases all
+#define APP_SCRIPT_OP_WAIT 236          // same as ACTION_WAIT, 2 operands: ms (uint16, little endian)
+#define APP_SCRIPT_OP_REPEAT 237        // same as ACTION_REPEAT, 2 operands: count, bytes of the body
+#define APP_SCRIPT_OP_JUMP_IF_LED 238   // same as ACTION_JUMP_IF_LED, 2 operands: LED mask, bytes skipped
+#define APP_SCRIPT_OP_TYPE_STRING 239   // same as ACTION_TYPE_STRING, 1 operand: string id
+#define APP_SCRIPT_OP_COMBINE_BASE 240  // same as ACTION_COMBINE_KEYS_BASE_CODE, n operands
+#define APP_SCRIPT_OP_COMBINE_MIN 2
+#define APP_SCRIPT_OP_COMBINE_MAX 9
+#define APP_SCRIPT_OP_MOUSE_MOVE 250    // same as ACTION_MOUSE_MOVE, 4 operands: X, Y (int16, little endian)
+#define APP_SCRIPT_OP_TAP 251           // same as ACTION_TAP, 2 operands: X, Y (% of the screen)
+#define APP_SCRIPT_OP_CALL 252          // same as ACTION_CALL, 1 operand: script id of the same app control
+#define APP_SCRIPT_OP_MOUSE_LEFT 253    // same as HID_MOUSE_LEFT
+#define APP_SCRIPT_OP_MOUSE_MIDDLE 254  // same as HID_MOUSE_MIDDLE
+#define APP_SCRIPT_OP_MOUSE_RIGHT 255   // same as HID_MOUSE_RIGHT
+
+// modifier keys (HID_KEY_LEFT_CTRL..HID_KEY_RIGHT_GUI), in the same
+// order as the bits of the keyboard report modifier byte
+#define APP_SCRIPT_KEY_MODIFIER_FIRST 224
+#define APP_SCRIPT_KEY_MODIFIER_LAST 231
+#define APP_SCRIPT_KEY_MODIFIER_MASK(key) ((uint8_t)(1 << ((key) - APP_SCRIPT_KEY_MODIFIER_FIRST)))
+
+#define APP_SCRIPT_KEY_ALL 0 // RELEASE operand: every key held down
+
+// host keyboard LEDs for JUMP_IF_LED, the bits of the keyboard output report
+#define APP_SCRIPT_LED_NUM_LOCK 0x01
+#define APP_SCRIPT_LED_CAPS_LOCK 0x02
+#define APP_SCRIPT_LED_SCROLL_LOCK 0x04
+
+    typedef struct
+    {
+        uint8_t code[APP_SCRIPT_IMAGE_SIZE];
+        uint16_t used; // bytes already taken by compiled scripts
+    } app_script_image_t;
+
+    void app_script_image_reset(app_script_image_t *image);
+
+    // Compiles one padded script row (steps[0] is the script id and is
+    // not emitted). Returns the offset of the script inside the image or
+    // APP_SCRIPT_INVALID_OFFSET if the row is malformed or doesn't fit.
+    uint16_t app_script_compile(app_script_image_t *image,
+                                const int *steps, uint8_t num_steps);
+
+    // Returns the first opcode of the script at 'offset' and its length
+    const uint8_t *app_script_get(const app_script_image_t *image,
+                                  uint16_t offset, uint8_t *length);
+
+    // Number of bytes taken by the instruction starting at code[0]
+    // (opcode + operands), 0 if it's not a valid instruction
+    uint8_t app_script_op_length(const uint8_t *code, uint8_t remaining);
+
+    // Checks a compiled script: every instruction complete, PRESS and
+    // RELEASE given keys, REPEAT bodies not empty nor nested and ending
+    // on an instruction, jumps forward onto an instruction (or the end)
+    // and never out of a REPEAT body. Prints the first error found.
+    bool app_script_validate(const uint8_t *code, uint8_t length);
+
+    // Prints the script one instruction per line
+    void app_script_disassemble(const uint8_t *code, uint8_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_SCRIPT_H */
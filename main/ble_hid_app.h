@@ -13,9 +13,29 @@ extern "C" {
 #endif
 
 
+// kinds of host the app controls are written for, each one is served
+// by its own BLE connection
+typedef enum {
+    BLE_HID_HOST_MOBILE,
+    BLE_HID_HOST_PC,
+    BLE_HID_HOSTS, // keep last
+} ble_hid_host_t;
+
+#define BLE_HID_CONN_ID_NONE 0xFFFF
+
 // prototypes
 void ble_app_setup(); // probably it's not a task (to be checked)
 
+// connection serving the host, BLE_HID_CONN_ID_NONE if not connected
+uint16_t ble_hid_get_host_conn_id(ble_hid_host_t host);
+
+// swaps the connections of the mobile and PC hosts, for when a
+// connection got bound to the wrong one
+void ble_hid_swap_hosts(void);
+
+// compiled script of an app control (see app_script.h), NULL if there's none
+const uint8_t *ble_hid_get_script(uint8_t app, uint8_t script, uint8_t *length);
+
 
 #ifdef __cplusplus
 }
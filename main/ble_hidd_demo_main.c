@@ -30,7 +30,10 @@
 
 #include "ble_hid_app.h"
 #include "hid_app_control.h"
+#include "script_executor.h"
 #include "io_hardware.h"
+#include "event_bus.h"
+#include "conn_policy.h"
 
 /**
  * Brief:
@@ -53,7 +56,16 @@
 
 #define HID_DEMO_TAG "HID_TASK"
 
-static uint16_t hid_conn_id = 0;
+// what gets stored in the tag of a running script
+#define HID_SCRIPT_TAG(app, button) ((uint16_t)(((app) << 8) | (button)))
+#define HID_SCRIPT_TAG_APP(tag) ((uint8_t)((tag) >> 8))
+#define HID_SCRIPT_TAG_BUTTON(tag) ((uint8_t)((tag)&0xFF))
+
+// connection of every kind of host, written by the BTC task when a
+// central (dis)connects and read by the executor task for every report
+static uint16_t hid_host_conn_ids[BLE_HID_HOSTS] = {BLE_HID_CONN_ID_NONE, BLE_HID_CONN_ID_NONE};
+static portMUX_TYPE hid_host_mux = portMUX_INITIALIZER_UNLOCKED;
+
 static bool sec_conn = false;
 static bool send_volum_up = false;
 #define CHAR_DECLARATION_SIZE (sizeof(uint8_t))
@@ -86,8 +98,8 @@ static esp_ble_adv_data_t hidd_adv_data = {
     .set_scan_rsp = false,
     .include_name = true,
     .include_txpower = true,
-    .min_interval = 0x0006, //slave connection min interval, Time = min_interval * 1.25 msec
-    .max_interval = 0x00F0, //slave connection max interval, Time = max_interval * 1.25 msec
+    .min_interval = CONN_POLICY_FAST_MIN_INTERVAL, //slave connection min interval, Time = min_interval * 1.25 msec
+    .max_interval = CONN_POLICY_IDLE_MAX_INTERVAL, //slave connection max interval, Time = max_interval * 1.25 msec
     .appearance = 0x03c0,   //HID Generic,
     .manufacturer_len = 0,
     .p_manufacturer_data = NULL,
@@ -113,13 +125,29 @@ static esp_ble_adv_params_t hidd_adv_params = {
 //static uint8_t *notify_result;
 
 // Global variables for the app control implementation
-app_control_struct_t *zoom_control_mobile;
-app_control_struct_t *zoom_control_pc;
-app_control_struct_t *skype_control_mobile;
-app_control_struct_t *skype_control_pc;
-app_control_struct_t *meet_control_mobile;
-app_control_struct_t *meet_control_pc;
 app_control_struct_t *app_control_registered[CONTROL_SCRIPTS_SETS];
+app_script_image_t app_control_script_image;
+
+// What every button does for every app control, resolved once by
+// app_control_init() so a press is just two array lookups
+typedef enum
+{
+    APP_CONTROL_BUTTON_NONE,
+    APP_CONTROL_BUTTON_NEXT_APP, // switch to the next app control
+    APP_CONTROL_BUTTON_SCRIPT,
+} app_control_button_action_t;
+
+typedef struct
+{
+    app_control_button_action_t action;
+    const uint8_t *script; // compiled script, for APP_CONTROL_BUTTON_SCRIPT
+    uint8_t script_length;
+} app_control_button_t;
+
+static app_control_button_t app_control_buttons[CONTROL_SCRIPTS_SETS][GPIO_INPUT_NUMBER];
+// written by the io hardware task, hid_host_bind() reads it from the
+// BTC task: the accesses from other tasks are atomic
+static uint8_t app_control_selected = 0;
 
 // Global variable that relations the app_control implementation
 // with the I/O hardare management
@@ -197,32 +225,29 @@ uint32_t app_control_rgb_codes[CONTROL_SCRIPTS_SETS] = {
     LED_STATE_GREY,   // GOOGLE MEET PC
 };
 
-bool button_input_as_latch(uint8_t button_index)
-{
-    static uint8_t button_inputs_previous[GPIO_INPUT_NUMBER] = {0};
-    static uint8_t **button_inputs; // matrix where the current inputs values are stored
-    uint8_t i = button_index;
-
-    button_inputs = io_hardware_get_digital_inputs();
-
-    if (button_inputs[i][1] == 1)
-    {
-        if (button_inputs_previous[i] == 0) // update previous value only if different than the current
-        {
-            button_inputs_previous[i] = 1;
-            return true;
-        }
-    }
-    else if (button_inputs_previous[i] == 1)
-        button_inputs_previous[i] = 0;
+// host every app control is written for, its scripts go to that connection
+static const ble_hid_host_t app_control_hosts[CONTROL_SCRIPTS_SETS] = {
+    BLE_HID_HOST_MOBILE, // ZOOM MOBILE
+    BLE_HID_HOST_PC,     // ZOOM PC
+    BLE_HID_HOST_MOBILE, // SKYPE MOBILE
+    BLE_HID_HOST_PC,     // SKYPE PC
+    BLE_HID_HOST_MOBILE, // GOOGLE MEET MOBILE
+    BLE_HID_HOST_PC,     // GOOGLE MEET PC
+};
 
-    return false;
-}
+static void app_control_build_buttons(void);
+static void hid_button_event(const button_gesture_event_t *event);
+static void hid_host_bind(uint16_t conn_id);
+static void hid_host_unbind(uint16_t conn_id);
+static uint16_t hid_host_route(uint16_t tag);
 
 static void hidd_event_callback(esp_hidd_cb_event_t event, esp_hidd_cb_param_t *param)
 {
 
     uint8_t result; // for debugging
+    event_bus_event_t ble_state = {
+        .type = EVENT_BUS_BLE_STATE,
+    };
 
     switch (event)
     {
@@ -245,16 +270,20 @@ static void hidd_event_callback(esp_hidd_cb_event_t event, esp_hidd_cb_param_t *
     case ESP_HIDD_EVENT_BLE_CONNECT:
     {
         ESP_LOGI(HID_DEMO_TAG, "ESP_HIDD_EVENT_BLE_CONNECT");
-        hid_conn_id = param->connect.conn_id;
-        //TODO: Must optimize here, sending only the first byte should be enough
-        io_hardware_notify_data[0] = IO_HARDWARE_NOTIFY_BLE_CONNECT;
-        io_hardware_notify_data[1] = IO_HARDWARE_BLE_LED; // use the last led
-        io_hardware_notify_data[2] = LED_STATE_BLUE >> 16,
-        io_hardware_notify_data[3] = (LED_STATE_BLUE >> 8) & 0xFF,
-        io_hardware_notify_data[4] = LED_STATE_BLUE & 0xFF;
-
-        result = xQueueSend(io_hardware_get_queue(), &io_hardware_notify_data, 0);
-        //notify_result = io_hardware_notify_data;
+        hid_host_bind(param->connect.conn_id);
+        conn_policy_connected(param->connect.conn_id, param->connect.remote_bda);
+
+        // advertising stops on every connection, keep it going while
+        // another central can still connect
+        if (esp_hidd_get_num_connections() < ESP_HIDD_MAX_CONN)
+        {
+            esp_ble_gap_start_advertising(&hidd_adv_params);
+        }
+
+        ble_state.ble.connected = true;
+        ble_state.ble.conn_id = param->connect.conn_id;
+        ble_state.ble.connections = esp_hidd_get_num_connections();
+        result = event_bus_publish(&ble_state);
         printf("notifying hardware.. result: %d\n", result);
         //return_val = xTaskGetTickCount() * portTICK_RATE_MS;
 
@@ -264,18 +293,22 @@ static void hidd_event_callback(esp_hidd_cb_event_t event, esp_hidd_cb_param_t *
     case ESP_HIDD_EVENT_BLE_DISCONNECT:
     {
         sec_conn = false;
-        ESP_LOGI(HID_DEMO_TAG, "ESP_HIDD_EVENT_BLE_DISCONNECT");
-        esp_ble_gap_start_advertising(&hidd_adv_params);
-        //TODO: Must optimize here, sending only the first byte should be enough
-        io_hardware_notify_data[0] = IO_HARDWARE_NOTIFY_BLE_DISCONNECT;
-        io_hardware_notify_data[1] = IO_HARDWARE_BLE_LED; // use the last led
-        io_hardware_notify_data[2] = LED_STATE_BLUE >> 16,
-        io_hardware_notify_data[3] = (LED_STATE_BLUE >> 8) & 0xFF,
-        io_hardware_notify_data[4] = LED_STATE_BLUE & 0xFF;
-        //return_val = xTaskGetTickCount() * portTICK_RATE_MS;
-        result = xQueueSend(io_hardware_get_queue(), &io_hardware_notify_data, 0);
+        ESP_LOGI(HID_DEMO_TAG, "ESP_HIDD_EVENT_BLE_DISCONNECT conn_id %d, reason 0x%x",
+                 param->disconnect.conn_id, param->disconnect.reason);
+        hid_host_unbind(param->disconnect.conn_id);
+        conn_policy_disconnected(param->disconnect.conn_id);
+
+        // advertising is off only if every connection was taken
+        if (esp_hidd_get_num_connections() == ESP_HIDD_MAX_CONN - 1)
+        {
+            esp_ble_gap_start_advertising(&hidd_adv_params);
+        }
+
+        ble_state.ble.connected = false;
+        ble_state.ble.conn_id = param->disconnect.conn_id;
+        ble_state.ble.connections = esp_hidd_get_num_connections();
+        result = event_bus_publish(&ble_state);
         printf("notifying hardware.. result: %d\n", result);
-        //xQueueSend(external_tasks_evt_queue/*io_hardware_get_queue()*/, &notify_result, 0);
 
         //printf("return val: %d\n", return_val);
         break;
@@ -284,6 +317,12 @@ static void hidd_event_callback(esp_hidd_cb_event_t event, esp_hidd_cb_param_t *
     {
         ESP_LOGI(HID_DEMO_TAG, "%s, ESP_HIDD_EVENT_BLE_VENDOR_REPORT_WRITE_EVT", __func__);
         ESP_LOG_BUFFER_HEX(HID_DEMO_TAG, param->vendor_write.data, param->vendor_write.length);
+        break;
+    }
+    case ESP_HIDD_EVENT_BLE_LED_REPORT_WRITE_EVT:
+    {
+        ESP_LOGI(HID_DEMO_TAG, "Host LEDs on conn_id %d: 0x%02x", param->led_write.conn_id, param->led_write.leds);
+        break;
     }
     default:
         break;
@@ -293,6 +332,8 @@ static void hidd_event_callback(esp_hidd_cb_event_t event, esp_hidd_cb_param_t *
 
 static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
 {
+    conn_policy_gap_event(event, param);
+
     switch (event)
     {
     case ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT:
@@ -324,190 +365,272 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
     }
 }
 
-void hid_demo_task(void *pvParameters)
+// Script engine transport over the BLE HID profile, the reports go to
+// the connection of the app control that started the script
+static void hid_transport_send_keyboard(void *ctx, script_engine_t *engine, uint8_t modifiers,
+                                        uint8_t *keys, uint8_t num_keys)
 {
+    uint16_t conn_id = hid_host_route(engine->tag);
+
+    if (conn_id != BLE_HID_CONN_ID_NONE)
+        esp_hidd_send_keyboard_value(conn_id, modifiers, keys, num_keys);
+}
+
+static void hid_transport_send_mouse(void *ctx, script_engine_t *engine, uint8_t buttons,
+                                     int16_t x, int16_t y, int8_t wheel, int8_t pan)
+{
+    uint16_t conn_id = hid_host_route(engine->tag);
+
+    if (conn_id != BLE_HID_CONN_ID_NONE)
+        esp_hidd_send_mouse_report(conn_id, buttons, x, y, wheel, pan);
+}
+
+static void hid_transport_send_consumer(void *ctx, script_engine_t *engine, uint8_t usage, bool pressed)
+{
+    uint16_t conn_id = hid_host_route(engine->tag);
+
+    if (conn_id != BLE_HID_CONN_ID_NONE)
+        esp_hidd_send_consumer_value(conn_id, usage, pressed);
+}
+
+static void hid_transport_send_touch(void *ctx, script_engine_t *engine, bool touching,
+                                     uint16_t x, uint16_t y)
+{
+    uint16_t conn_id = hid_host_route(engine->tag);
+
+    if (conn_id != BLE_HID_CONN_ID_NONE)
+        esp_hidd_send_touch(conn_id, touching, x, y);
+}
+
+// the app control that started the script is in the engine tag
+static script_engine_special_result_t hid_transport_run_special(void *ctx, script_engine_t *engine,
+                                                                uint8_t special_index, const uint8_t *script)
+{
+    uint8_t app_selection = HID_SCRIPT_TAG_APP(engine->tag);
+    const app_control_special_script_t *special_action;
+    app_control_special_args_t args;
+
+    printf("Special Action Detected!\n");
+
+    if (app_selection >= CONTROL_SCRIPTS_SPECIAL_ACTIONS_TOTAL ||
+        app_control_special_actions[app_selection] == NULL)
+    {
+        printf("No special actions registered for app control %d\n", app_selection);
+        return SCRIPT_ENGINE_SPECIAL_STOP;
+    }
+
+    // the index comes straight from the script bytecode
+    if (app_selection >= CONTROL_SCRIPTS_SETS ||
+        special_index >= app_control_special_actions_count[app_selection])
+    {
+        printf("Special action %d not registered for app control %d\n", special_index, app_selection);
+        return SCRIPT_ENGINE_SPECIAL_STOP;
+    }
+
+    special_action = &app_control_special_actions[app_selection][special_index];
+    args.arg1 = special_action->arg1;
+    args.arg2 = special_action->arg2;
+    args.host_script = script;
+    args.hid_conn_id = hid_host_route(engine->tag);
+    args.engine = engine;
+
+    switch (special_action->pfunction(&args))
+    {
+    case SPECIAL_ACTION_RETURN_CODE_END_SCRIPT:
+    case SPECIAL_ACTION_RETURN_CODE_FAIL:
+        return SCRIPT_ENGINE_SPECIAL_STOP;
+    case SPECIAL_ACTION_RETURN_CODE_SKIP_NEXT:
+        return SCRIPT_ENGINE_SPECIAL_SKIP_NEXT;
+    default:
+        return SCRIPT_ENGINE_SPECIAL_CONTINUE;
+    }
+}
+
+// what the host of the running script shows, in the same bits as APP_SCRIPT_LED_*
+static uint8_t hid_transport_get_leds(void *ctx, script_engine_t *engine)
+{
+    uint16_t conn_id = hid_host_route(engine->tag);
+
+    return (conn_id != BLE_HID_CONN_ID_NONE) ? esp_hidd_get_keyboard_leds(conn_id) : 0;
+}
+
+static const char *hid_transport_get_string(void *ctx, script_engine_t *engine, uint8_t id, uint8_t *length)
+{
+    if (id >= APP_CONTROL_STRINGS)
+        return NULL;
+
+    *length = strlen(app_control_strings[id]);
+    return app_control_strings[id];
+}
+
+// CALL stays inside the app control of the running script
+static const uint8_t *hid_transport_get_script(void *ctx, script_engine_t *engine, uint8_t id, uint8_t *length)
+{
+    return ble_hid_get_script(HID_SCRIPT_TAG_APP(engine->tag), id, length);
+}
+
+// Called by the script executor task once the last report has been sent
+static void hid_transport_finished(void *ctx, script_engine_t *engine)
+{
+    uint8_t button = HID_SCRIPT_TAG_BUTTON(engine->tag);
+
+    printf("Command executed: %d reports, %d ms\n",
+           engine->stats.reports_sent, engine->stats.last_script_ms);
+
+    // Turn off the corresponding LED
+    set_led_state(io_hardware_buttons_rgbCodes[button - 1][0], LED_STATE_OFF);
+}
 
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
+static const script_engine_transport_t hid_transport = {
+    .send_keyboard = hid_transport_send_keyboard,
+    .send_mouse = hid_transport_send_mouse,
+    .send_consumer = hid_transport_send_consumer,
+    .send_touch = hid_transport_send_touch,
+    .run_special = hid_transport_run_special,
+    .get_leds = hid_transport_get_leds,
+    .get_string = hid_transport_get_string,
+    .get_script = hid_transport_get_script,
+    .finished = hid_transport_finished,
+    .ctx = NULL,
+};
 
-    //static uint32_t prev_notify_result = 0;
-    uint8_t result;                     // for debugging
-    uint8_t user_app_selection = 0;     // default app selection value
-    uint8_t user_command_selection = 1; // default command selection value
+// Called by the io hardware task on every button change
+static void hid_button_event(const button_gesture_event_t *event)
+{
+    const app_control_button_t *entry;
+    uint8_t button = event->button;
+
+    if (event->type != BUTTON_GESTURE_PRESS) // only presses do something for now
+    {
+        printf("Button %d gesture %d (held 0x%02x)\n", button, event->type, event->buttons);
+        return;
+    }
 
-    uint8_t command_selected = 0;
-    uint8_t mouse_button_value = 0;
-    uint8_t gpio_num_detected = 0; // just a starting value;
-    uint8_t i, k;
-    /*app_control_rgb_codes[0] = LED_STATE_BLUE;   // ZOOM MOBILE
-    app_control_rgb_codes[1] = LED_STATE_CYAN;   // ZOOM PC
-    app_control_rgb_codes[2] = LED_STATE_YELLOW; // SKYPE MOBILE
-    app_control_rgb_codes[3] = LED_STATE_RED;    // SKYPE PC*/
+    entry = &app_control_buttons[app_control_selected][button];
 
-    while (1)
+    switch (entry->action)
     {
+    case APP_CONTROL_BUTTON_NEXT_APP:
+        printf("Changing app control selection!\n");
+        __atomic_store_n(&app_control_selected,
+                         ((app_control_selected + 1) >= CONTROL_SCRIPTS_SETS) ? 0 : app_control_selected + 1,
+                         __ATOMIC_RELAXED);
+        set_led_state(IO_HARDWARE_APP_LED, app_control_rgb_codes[app_control_selected]);
+        break;
 
-        printf("hid_task is executing!\n");
-        set_led_state(IO_HARDWARE_APP_LED, app_control_rgb_codes[user_app_selection]);
-        //vTaskDelay(1000);
-        while (!command_selected)
+    case APP_CONTROL_BUTTON_SCRIPT:
+        // the reports only go to the host the app control is written for
+        if (ble_hid_get_host_conn_id(app_control_hosts[app_control_selected]) == BLE_HID_CONN_ID_NONE)
         {
-            vTaskDelay(10); // put this to let other tasks run correctly
+            printf("%s host not connected, command ignored\n",
+                   app_control_hosts[app_control_selected] == BLE_HID_HOST_PC ? "PC" : "Mobile");
+            break;
+        }
 
-            // check all GPIO
-            for (i = 0; i < GPIO_INPUT_NUMBER; i++)
-            {
-                //TODO: put a validating function in the if statement
-                if (button_input_as_latch(i))
-                { // if a button is pressed
-                    user_command_selection = (app_control_io_hardware_scripts[user_app_selection][(i != 0) ? (i - 1) : i][1]);
-                    command_selected = 1;
-                    printf("Command Found!\n");
-                    gpio_num_detected = i; // save gpio index found
-
-                    if (i == 0) // the first button will not trigger any script
-                    {
-                        command_selected = 0;
-                        printf("Changing app control selection!\n");
-                        user_app_selection = ((user_app_selection + 1) >= CONTROL_SCRIPTS_SETS) ? 0 : user_app_selection + 1;
-                        set_led_state(IO_HARDWARE_APP_LED, app_control_rgb_codes[user_app_selection]);
-                    }
-
-                    i = GPIO_INPUT_NUMBER; // end the for loop
-                }
-            }
+        // Turn on the corresponding LED
+        set_led_state(io_hardware_buttons_rgbCodes[button - 1][0],
+                      io_hardware_buttons_rgbCodes[button - 1][1]);
+
+        // the script runs in the background, the LED is turned off
+        // by hid_transport_finished() once it's done
+        printf("Executing command\n");
+        if (!script_executor_submit(entry->script, entry->script_length,
+                                    HID_SCRIPT_TAG(app_control_selected, button), event->time_us))
+        {
+            printf("Script executor busy, command ignored\n");
+            set_led_state(io_hardware_buttons_rgbCodes[button - 1][0], LED_STATE_OFF);
         }
+        break;
 
-        // If the program gets here, it means that a specific command has been selected
+    default:
+        break;
+    }
+}
 
-        // Turn on the corresponding LED
-        set_led_state(io_hardware_buttons_rgbCodes[gpio_num_detected - 1][0],
-                      io_hardware_buttons_rgbCodes[gpio_num_detected - 1][1]);
+uint16_t ble_hid_get_host_conn_id(ble_hid_host_t host)
+{
+    if (host >= BLE_HID_HOSTS)
+        return BLE_HID_CONN_ID_NONE;
 
-        uint8_t key_value = 0;
-        uint8_t key_combination_current_value;
-        uint8_t key_comb_mask = 0x00; // key combination mask
-        uint8_t key_combo_flag = 1;   // 1 must be the default value
+    return __atomic_load_n(&hid_host_conn_ids[host], __ATOMIC_RELAXED);
+}
 
-        for (i = 1;
-             i < app_control_registered[user_app_selection]->scripts_max_steps;
-             i++)
-        {
-            key_value = app_control_registered[user_app_selection]->scripts[user_command_selection][i];
-            switch (key_value)
-            {
-            case ACTION_NONE:
-                i = app_control_registered[user_app_selection]->scripts_max_steps;
-                break;
+void ble_hid_swap_hosts(void)
+{
+    uint16_t conn_id;
 
-            case ACTION_SPECIAL:
-                printf("Special Action Detected!\n");
-                key_value = app_control_registered[user_app_selection]
-                                ->scripts[user_command_selection][i + 1]; // get the special function index
-                app_control_special_actions[user_app_selection][key_value].host_script = app_control_registered[user_app_selection]
-                                                                                             ->scripts[user_command_selection];
-                app_control_special_actions[user_app_selection][key_value].hid_conn_id = hid_conn_id;
-                app_control_special_actions[user_app_selection][key_value]
-                    .pfunction(&app_control_special_actions[user_app_selection][key_value]);
-
-                switch (app_control_special_actions[user_app_selection][key_value].returnCode[0])
-                {
-                case SPECIAL_ACTION_RETURN_CODE_END_SCRIPT:
-                    i = app_control_registered[user_app_selection]->scripts_max_steps;
-                    break;
-                case SPECIAL_ACTION_RETURN_CODE_FAIL:
-                    i = app_control_registered[user_app_selection]->scripts_max_steps;
-                    break;
-                case SPECIAL_ACTION_RETURN_CODE_SKIP_NEXT:
-                    break;
-                default:
-                    break;
-                }
+    portENTER_CRITICAL(&hid_host_mux);
+    conn_id = hid_host_conn_ids[BLE_HID_HOST_MOBILE];
+    __atomic_store_n(&hid_host_conn_ids[BLE_HID_HOST_MOBILE], hid_host_conn_ids[BLE_HID_HOST_PC], __ATOMIC_RELAXED);
+    __atomic_store_n(&hid_host_conn_ids[BLE_HID_HOST_PC], conn_id, __ATOMIC_RELAXED);
+    portEXIT_CRITICAL(&hid_host_mux);
+}
 
-                break;
+const uint8_t *ble_hid_get_script(uint8_t app, uint8_t script, uint8_t *length)
+{
+    *length = 0;
 
-            default:
-
-                printf("Executing command\n");
-
-                if ((int)(key_value / 10) == (ACTION_COMBINE_KEYS_BASE_CODE / 10))
-                {
-                    i++;
-                    printf("i: %d, keyvalue: %d, no. of actions: %d\n", i, key_value, key_value - ACTION_COMBINE_KEYS_BASE_CODE);
-
-                    for (int kj = 0; kj < 2; kj++)
-                    {
-                        for (int j = 0; j < (key_value - ACTION_COMBINE_KEYS_BASE_CODE); j++)
-                        {
-                            key_combination_current_value = app_control_registered[user_app_selection]->scripts[user_command_selection][i + j];
-                            switch (key_combination_current_value)
-                            {
-                            case HID_KEY_RIGHT_ALT:
-                                key_comb_mask = (key_combo_flag) ? (key_comb_mask | RIGHT_ALT_KEY_MASK) : (key_comb_mask & ~RIGHT_ALT_KEY_MASK);
-                                break;
-                            case HID_KEY_LEFT_ALT:
-                                key_comb_mask = (key_combo_flag) ? (key_comb_mask | LEFT_ALT_KEY_MASK) : (key_comb_mask & ~LEFT_ALT_KEY_MASK);
-                                break;
-                            case HID_KEY_RIGHT_CTRL:
-                                key_comb_mask = (key_combo_flag) ? (key_comb_mask | RIGHT_CONTROL_KEY_MASK) : (key_comb_mask & ~RIGHT_CONTROL_KEY_MASK);
-                                break;
-                            case HID_KEY_LEFT_CTRL:
-                                key_comb_mask = (key_combo_flag) ? (key_comb_mask | LEFT_CONTROL_KEY_MASK) : (key_comb_mask & ~LEFT_CONTROL_KEY_MASK);
-                                break;
-                            case HID_KEY_RIGHT_GUI:
-                                key_comb_mask = (key_combo_flag) ? (key_comb_mask | RIGHT_GUI_KEY_MASK) : (key_comb_mask & ~RIGHT_GUI_KEY_MASK);
-                                break;
-                            case HID_KEY_LEFT_GUI:
-                                key_comb_mask = (key_combo_flag) ? (key_comb_mask | LEFT_GUI_KEY_MASK) : (key_comb_mask & ~LEFT_GUI_KEY_MASK);
-                                break;
-                            case HID_KEY_RIGHT_SHIFT:
-                                key_comb_mask = (key_combo_flag) ? (key_comb_mask | RIGHT_SHIFT_KEY_MASK) : (key_comb_mask & ~RIGHT_SHIFT_KEY_MASK);
-                                break;
-                            case HID_KEY_LEFT_SHIFT:
-                                key_comb_mask = (key_combo_flag) ? (key_comb_mask | LEFT_SHIFT_KEY_MASK) : (key_comb_mask & ~LEFT_SHIFT_KEY_MASK);
-                                break;
-
-                            default:
-                                break;
-                            }
-                            esp_hidd_send_keyboard_value(
-                                hid_conn_id, key_comb_mask,
-                                &(app_control_registered[user_app_selection]->scripts[user_command_selection][i + j]), key_combo_flag);
-                            printf("hid value: %d, state: %d\n", app_control_registered[user_app_selection]->scripts[user_command_selection][i + j], key_combo_flag);
-                            vTaskDelay(10 / portTICK_PERIOD_MS);
-                        }
-                        key_combo_flag = ~key_combo_flag & 1;
-                    }
-                    i += (key_value - ACTION_COMBINE_KEYS_BASE_CODE - 1);
-                    key_combo_flag = 1;
-                    break;
-                }
-
-                if (key_value > 250)
-                {
-                    mouse_button_value = (key_value == 253) ? 0x01 : 0x02;
-                    // Simulate a short 'click'
-                    esp_hidd_send_mouse_value(hid_conn_id, mouse_button_value, 0, 0);
-                    vTaskDelay(50 / portTICK_PERIOD_MS);
-                    esp_hidd_send_mouse_value(hid_conn_id, 0x00, 0, 0);
-                }
-                else
-                {
-                    esp_hidd_send_keyboard_value(hid_conn_id, 0, &key_value, 1);
-                    vTaskDelay(100 / portTICK_PERIOD_MS);
-
-                    esp_hidd_send_keyboard_value(hid_conn_id, 0, &key_value, 0);
-                }
-                break;
-            }
+    if (app >= CONTROL_SCRIPTS_SETS || app_control_registered[app] == NULL ||
+        script >= app_control_registered[app]->num_of_scripts)
+        return NULL;
+
+    return app_script_get(&app_control_script_image,
+                          app_control_registered[app]->scripts_offset[script], length);
+}
+
+// A new connection serves the host of the selected app control, or the
+// other one if that's already connected. Pick the app control before
+// connecting a host to bind it the right way (or swap them later).
+static void hid_host_bind(uint16_t conn_id)
+{
+    ble_hid_host_t host = app_control_hosts[__atomic_load_n(&app_control_selected, __ATOMIC_RELAXED)];
+    ble_hid_host_t other;
 
-            command_selected = 0;
-            //vTaskDelay(10 / portTICK_PERIOD_MS);
+    portENTER_CRITICAL(&hid_host_mux);
+    if (hid_host_conn_ids[host] != BLE_HID_CONN_ID_NONE)
+    {
+        for (other = 0; other < BLE_HID_HOSTS; other++)
+        {
+            if (hid_host_conn_ids[other] == BLE_HID_CONN_ID_NONE)
+                break;
         }
+        host = other;
+    }
+    if (host < BLE_HID_HOSTS)
+        __atomic_store_n(&hid_host_conn_ids[host], conn_id, __ATOMIC_RELAXED);
+    portEXIT_CRITICAL(&hid_host_mux);
+
+    if (host < BLE_HID_HOSTS)
+        printf("conn_id %d serves the %s app controls\n", conn_id, host == BLE_HID_HOST_PC ? "PC" : "mobile");
+    else
+        printf("conn_id %d: every host is already connected\n", conn_id);
+}
+
+static void hid_host_unbind(uint16_t conn_id)
+{
+    ble_hid_host_t host;
 
-        // Turn off the corresponding LED
-        set_led_state(io_hardware_buttons_rgbCodes[gpio_num_detected - 1][0],
-                      LED_STATE_OFF);
+    portENTER_CRITICAL(&hid_host_mux);
+    for (host = 0; host < BLE_HID_HOSTS; host++)
+    {
+        if (hid_host_conn_ids[host] == conn_id)
+            __atomic_store_n(&hid_host_conn_ids[host], BLE_HID_CONN_ID_NONE, __ATOMIC_RELAXED);
     }
+    portEXIT_CRITICAL(&hid_host_mux);
+}
+
+// Connection for the reports of a script: the one of its app control
+// host, none if that host isn't connected (a PC shortcut must never be
+// typed on the phone). The script is refused before it starts, this
+// drops the reports of a host that disconnects while it's running.
+static uint16_t hid_host_route(uint16_t tag)
+{
+    uint8_t app = HID_SCRIPT_TAG_APP(tag);
+
+    if (app >= CONTROL_SCRIPTS_SETS)
+        return BLE_HID_CONN_ID_NONE;
+
+    return __atomic_load_n(&hid_host_conn_ids[app_control_hosts[app]], __ATOMIC_RELAXED);
 }
 
 // This functions will setup the BLE functionalities and it's task. Remember to
@@ -562,6 +685,9 @@ void ble_app_setup()
         ESP_LOGE(HID_DEMO_TAG, "%s init bluedroid failed\n", __func__);
     }
 
+    // before any connection can show up
+    conn_policy_init(hid_host_route);
+
     ///register the callback function to the gap module
     esp_ble_gap_register_callback(gap_event_handler);
     esp_hidd_register_callbacks(hidd_event_callback);
@@ -584,125 +710,90 @@ void ble_app_setup()
 
     app_control_init(app_control_registered);
 
-    xTaskCreate(&hid_demo_task, "hid_task", 2048, NULL, 7, NULL);
+    script_executor_init(&hid_transport);
+
+    set_led_state(IO_HARDWARE_APP_LED, app_control_rgb_codes[app_control_selected]);
+    io_hardware_set_button_handler(hid_button_event);
 }
 
 void app_control_init(app_control_struct_t **app_control_register)
 {
-    zoom_control_mobile = app_control_setup_new(ZOOM_CONTROL_MOBILE_ID,
-                                                ZOOM_CONTROL_MOBILE_NUM_SCRIPTS,
-                                                ZOOM_CONTROL_MAX_STEPS,
-
-                                                ZOOM_CONTROL_MOBILE_TOGGLE_MIC_SCRIPT,
-                                                ZOOM_CONTROL_MOBILE_TOGGLE_VID_SCRIPT,
-                                                ZOOM_CONTROL_MOBILE_JOIN1_SCRIPT,
-                                                ZOOM_CONTROL_MOBILE_OPEN_APP_SCRIPT,
-                                                ZOOM_CONTROL_MOBILE_STILL_DECIDING_SCRIPT);
-
-    zoom_control_pc = app_control_setup_new(ZOOM_CONTROL_PC_ID,
-                                            ZOOM_CONTROL_PC_NUM_SCRIPTS,
-                                            ZOOM_CONTROL_MAX_STEPS,
-
-                                            ZOOM_CONTROL_PC_TOGGLE_MIC_SCRIPT,
-                                            ZOOM_CONTROL_PC_TOGGLE_VID_SCRIPT,
-                                            ZOOM_CONTROL_PC_IMPROV_VID_SCRIPT,
-                                            ZOOM_CONTROL_PC_OPEN_APP_SCRIPT,
-                                            ZOOM_CONTROL_PC_STILL_DECIDING_SCRIPT);
-
-    skype_control_mobile = app_control_setup_new(SKYPE_CONTROL_MOBILE_ID,
-                                                 SKYPE_CONTROL_MOBILE_NUM_SCRIPTS,
-                                                 SKYPE_CONTROL_MAX_STEPS,
-
-                                                 SKYPE_CONTROL_MOBILE_TOGGLE_MIC_SCRIPT,
-                                                 SKYPE_CONTROL_MOBILE_TOGGLE_VID_SCRIPT,
-                                                 SKYPE_CONTROL_MOBILE_IMPROV_VID_SCRIPT,
-                                                 SKYPE_CONTROL_MOBILE_OPEN_APP_SCRIPT,
-                                                 SKYPE_CONTROL_MOBILE_STILL_DECIDING_SCRIPT);
-
-    skype_control_pc = app_control_setup_new(SKYPE_CONTROL_PC_ID,
-                                             SKYPE_CONTROL_PC_NUM_SCRIPTS,
-                                             SKYPE_CONTROL_MAX_STEPS,
-
-                                             SKYPE_CONTROL_PC_TOGGLE_MIC_SCRIPT,
-                                             SKYPE_CONTROL_PC_TOGGLE_VID_SCRIPT,
-                                             SKYPE_CONTROL_PC_IMPROV_VID_SCRIPT,
-                                             SKYPE_CONTROL_PC_OPEN_APP_SCRIPT,
-                                             SKYPE_CONTROL_PC_STILL_DECIDING_SCRIPT);
-
-    meet_control_mobile = app_control_setup_new(MEET_CONTROL_MOBILE_ID,
-                                                MEET_CONTROL_MOBILE_NUM_SCRIPTS,
-                                                MEET_CONTROL_MAX_STEPS,
-
-                                                MEET_CONTROL_MOBILE_TOGGLE_MIC_SCRIPT,
-                                                MEET_CONTROL_MOBILE_TOGGLE_VID_SCRIPT,
-                                                MEET_CONTROL_MOBILE_IMPROV_VID_SCRIPT,
-                                                MEET_CONTROL_MOBILE_OPEN_APP_SCRIPT,
-                                                MEET_CONTROL_MOBILE_STILL_DECIDING_SCRIPT);
-
-    meet_control_pc = app_control_setup_new(MEET_CONTROL_PC_ID,
-                                            MEET_CONTROL_PC_NUM_SCRIPTS,
-                                            MEET_CONTROL_MAX_STEPS,
-
-                                            MEET_CONTROL_PC_TOGGLE_MIC_SCRIPT,
-                                            MEET_CONTROL_PC_TOGGLE_VID_SCRIPT,
-                                            MEET_CONTROL_PC_IMPROV_VID_SCRIPT,
-                                            MEET_CONTROL_PC_OPEN_APP_SCRIPT,
-                                            MEET_CONTROL_PC_STILL_DECIDING_SCRIPT);
-
-    app_control_register[0] = zoom_control_mobile;
-    app_control_register[1] = zoom_control_pc;
-    app_control_register[2] = skype_control_mobile;
-    app_control_register[3] = skype_control_pc;
-    app_control_register[4] = meet_control_mobile;
-    app_control_register[5] = meet_control_pc;
+    uint8_t i;
+
+    app_script_image_reset(&app_control_script_image);
+
+    for (i = 0; i < CONTROL_SCRIPTS_SETS; i++)
+        app_control_register[i] = app_control_setup_new(&app_control_scripts[i]);
+
+    printf("App control scripts compiled: %d/%d bytes\n",
+           app_control_script_image.used, APP_SCRIPT_IMAGE_SIZE);
+
+    app_control_build_buttons();
 }
 
-app_control_struct_t *app_control_setup_new(uint8_t app_id,
-                                            uint8_t num_of_scripts,
-                                            uint8_t max_steps_per_script, ...)
+// Resolves app_control_io_hardware_scripts into app_control_buttons
+static void app_control_build_buttons(void)
 {
-    static app_control_struct_t available_structs[CONTROL_SCRIPTS_MAX_SETS];
-    static uint8_t current_available_index = 0;
-    int i, k;
+    app_control_button_t *entry;
+    int8_t button;
+    uint8_t script_id;
+    uint8_t app, i;
+
+    memset(app_control_buttons, 0, sizeof(app_control_buttons));
 
-    if (current_available_index >= CONTROL_SCRIPTS_MAX_SETS)
+    for (app = 0; app < CONTROL_SCRIPTS_SETS; app++)
     {
-        return 0; // return a null pointer
-    }
+        // the first button will not trigger any script
+        app_control_buttons[app][0].action = APP_CONTROL_BUTTON_NEXT_APP;
 
-    command_code_t **scripts_commands;
-    scripts_commands = (command_code_t **)malloc(sizeof(command_code_t **) *
-                                                 num_of_scripts);
+        if (app_control_registered[app] == NULL)
+            continue;
 
-    for (i = 0; i < num_of_scripts; i++)
-    {
+        for (i = 0; i < GPIO_INPUT_NUMBER - 1; i++)
+        {
+            button = io_hardware_get_button_index(app_control_io_hardware_scripts[app][i][0]);
+            script_id = app_control_io_hardware_scripts[app][i][1];
 
-        command_code_t *scripts_commands_steps; // + 1 below for the id of the command
-        scripts_commands_steps = (command_code_t *)malloc(sizeof(command_code_t) *
-                                                          (max_steps_per_script + 1));
+            if (button <= 0 || script_id >= app_control_registered[app]->num_of_scripts)
+            {
+                printf("App control %d: can't bind script %d to GPIO %d\n",
+                       app, script_id, app_control_io_hardware_scripts[app][i][0]);
+                continue;
+            }
 
-        scripts_commands[i] = scripts_commands_steps;
+            entry = &app_control_buttons[app][button];
+            entry->script = app_script_get(&app_control_script_image,
+                                           app_control_registered[app]->scripts_offset[script_id],
+                                           &entry->script_length);
+            entry->action = (entry->script != NULL) ? APP_CONTROL_BUTTON_SCRIPT : APP_CONTROL_BUTTON_NONE;
+        }
     }
+}
 
-    available_structs[current_available_index].app_control_id = app_id;
-    available_structs[current_available_index].num_of_scripts = num_of_scripts;
-    available_structs[current_available_index].scripts = scripts_commands;
-    available_structs[current_available_index].scripts_max_steps = max_steps_per_script;
-
-    va_list commands_codes;
-    va_start(commands_codes, (int)max_steps_per_script);
+app_control_struct_t *app_control_setup_new(const app_control_scripts_t *scripts)
+{
+    static app_control_struct_t available_structs[CONTROL_SCRIPTS_MAX_SETS];
+    static uint8_t current_available_index = 0;
+    int i;
 
-    for (i = 0; i < num_of_scripts; i++)
+    if (current_available_index >= CONTROL_SCRIPTS_MAX_SETS ||
+        scripts->num_of_scripts > CONTROL_SCRIPTS_MAX_SCRIPTS)
     {
-        ;
-        for (k = 0; k < max_steps_per_script + 1; k++)
-        {
+        return 0; // return a null pointer
+    }
 
-            available_structs[current_available_index].scripts[i][k] = ((command_code_t)va_arg(commands_codes, int));
-        }
+    available_structs[current_available_index].app_control_id = scripts->app_control_id;
+    available_structs[current_available_index].num_of_scripts = scripts->num_of_scripts;
+    available_structs[current_available_index].scripts_max_steps = scripts->max_steps_per_script;
+
+    // every padded row gets compiled straight into the image
+    for (i = 0; i < scripts->num_of_scripts; i++)
+    {
+        available_structs[current_available_index].scripts_offset[i] =
+            app_script_compile(&app_control_script_image, scripts->rows[i].steps,
+                               scripts->max_steps_per_script + 1); // + 1 for the id of the command
     }
 
-    va_end(commands_codes);
     current_available_index++;
 
     return &(available_structs[current_available_index - 1]);
@@ -0,0 +1,183 @@
+/*
+ * Button debouncer and gesture classifier, see button_gesture.h
+ *
+ * Debouncing works by lockout: the first edge of a button is taken at
+ * once (no added latency), then the button is ignored for debounce_ms.
+ * When the window ends the last level seen is compared with the
+ * debounced one, so a release that happened inside the window isn't lost.
+ */
+
+#include <string.h>
+
+#include "button_gesture.h"
+
+#define BIT(button) ((uint8_t)(1 << (button)))
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void button_gesture_emit(button_gesture_t *gesture, button_gesture_type_t type,
+                                uint8_t button, uint32_t now_us);
+static void button_gesture_change(button_gesture_t *gesture, uint8_t button, uint32_t now_us);
+
+// FUNCTION DEFINITIONS
+
+void button_gesture_init(button_gesture_t *gesture, uint8_t num_buttons, uint8_t levels,
+                         button_gesture_callback_t callback, void *ctx)
+{
+    memset(gesture, 0, sizeof(*gesture));
+
+    gesture->config.debounce_ms = BUTTON_GESTURE_DEBOUNCE_MS;
+    gesture->config.long_press_ms = BUTTON_GESTURE_LONG_PRESS_MS;
+    gesture->config.double_press_ms = BUTTON_GESTURE_DOUBLE_PRESS_MS;
+    gesture->callback = callback;
+    gesture->ctx = ctx;
+    gesture->num_buttons = (num_buttons > BUTTON_GESTURE_MAX_BUTTONS) ? BUTTON_GESTURE_MAX_BUTTONS : num_buttons;
+
+    // buttons held at boot don't count as pressed until they're released
+    gesture->raw = levels;
+    gesture->stable = levels;
+}
+
+void button_gesture_set_config(button_gesture_t *gesture, const button_gesture_config_t *config)
+{
+    gesture->config = *config;
+}
+
+void button_gesture_input(button_gesture_t *gesture, uint8_t button, uint8_t level, uint32_t now_us)
+{
+    if (button >= gesture->num_buttons)
+        return;
+
+    if (level)
+        gesture->raw |= BIT(button);
+    else
+        gesture->raw &= ~BIT(button);
+
+    // bounces inside the window only update the raw level
+    if (gesture->settling & BIT(button))
+        return;
+
+    if ((gesture->raw ^ gesture->stable) & BIT(button))
+        button_gesture_change(gesture, button, now_us);
+}
+
+void button_gesture_poll(button_gesture_t *gesture, uint32_t now_us)
+{
+    uint8_t button;
+
+    for (button = 0; button < gesture->num_buttons; button++)
+    {
+        if ((gesture->settling & BIT(button)) &&
+            now_us - gesture->changed_us[button] >= (uint32_t)gesture->config.debounce_ms * 1000)
+        {
+            gesture->settling &= ~BIT(button);
+
+            // the button moved again while it was settling
+            if ((gesture->raw ^ gesture->stable) & BIT(button))
+                button_gesture_change(gesture, button, now_us);
+        }
+
+        if ((gesture->long_pending & BIT(button)) &&
+            now_us - gesture->changed_us[button] >= (uint32_t)gesture->config.long_press_ms * 1000)
+        {
+            gesture->long_pending &= ~BIT(button);
+            button_gesture_emit(gesture, BUTTON_GESTURE_LONG_PRESS, button, now_us);
+        }
+    }
+}
+
+uint32_t button_gesture_timeout_us(const button_gesture_t *gesture, uint32_t now_us)
+{
+    uint32_t timeout_us = BUTTON_GESTURE_NO_TIMEOUT;
+    uint32_t elapsed_us;
+    uint32_t limit_us;
+    uint8_t button;
+
+    for (button = 0; button < gesture->num_buttons; button++)
+    {
+        elapsed_us = now_us - gesture->changed_us[button];
+
+        if (gesture->settling & BIT(button))
+        {
+            limit_us = (uint32_t)gesture->config.debounce_ms * 1000;
+            if (elapsed_us >= limit_us)
+                return 0;
+            if (limit_us - elapsed_us < timeout_us)
+                timeout_us = limit_us - elapsed_us;
+        }
+
+        if (gesture->long_pending & BIT(button))
+        {
+            limit_us = (uint32_t)gesture->config.long_press_ms * 1000;
+            if (elapsed_us >= limit_us)
+                return 0;
+            if (limit_us - elapsed_us < timeout_us)
+                timeout_us = limit_us - elapsed_us;
+        }
+    }
+
+    return timeout_us;
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static void button_gesture_emit(button_gesture_t *gesture, button_gesture_type_t type,
+                                uint8_t button, uint32_t now_us)
+{
+    button_gesture_event_t event = {
+        .type = type,
+        .button = button,
+        .buttons = gesture->stable,
+        .time_us = now_us,
+    };
+
+    if (gesture->callback)
+        gesture->callback(gesture->ctx, &event);
+}
+
+// The debounced level of 'button' follows the raw one
+static void button_gesture_change(button_gesture_t *gesture, uint8_t button, uint32_t now_us)
+{
+    gesture->stable ^= BIT(button);
+    gesture->settling |= BIT(button);
+    gesture->changed_us[button] = now_us;
+
+    if (gesture->stable & BIT(button))
+    {
+        gesture->long_pending |= BIT(button);
+        button_gesture_emit(gesture, BUTTON_GESTURE_PRESS, button, now_us);
+
+        if (gesture->stable & ~BIT(button))
+        {
+            // every button held down is part of the chord
+            gesture->chorded |= gesture->stable;
+            gesture->double_armed &= ~gesture->stable;
+            button_gesture_emit(gesture, BUTTON_GESTURE_CHORD, button, now_us);
+        }
+        else if ((gesture->double_armed & BIT(button)) &&
+                 now_us - gesture->released_us[button] < (uint32_t)gesture->config.double_press_ms * 1000)
+        {
+            // a third press starts counting again
+            gesture->double_armed &= ~BIT(button);
+            gesture->chorded |= BIT(button); // its release doesn't arm another double
+            button_gesture_emit(gesture, BUTTON_GESTURE_DOUBLE_PRESS, button, now_us);
+        }
+    }
+    else
+    {
+        // only a short press on its own can be the first of a double press
+        if ((gesture->long_pending & BIT(button)) && !(gesture->chorded & BIT(button)))
+        {
+            gesture->double_armed |= BIT(button);
+            gesture->released_us[button] = now_us;
+        }
+        else
+        {
+            gesture->double_armed &= ~BIT(button);
+        }
+
+        gesture->long_pending &= ~BIT(button);
+        gesture->chorded &= ~BIT(button);
+        button_gesture_emit(gesture, BUTTON_GESTURE_RELEASE, button, now_us);
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * Debouncer and gesture classifier for the box buttons.
+ *
+ * The raw levels seen by the io hardware task go in (with the time they
+ * were seen at), debounced gestures come out through a callback:
+ *
+ *   PRESS        the button went down, sent on the first edge so a
+ *                script can start right away
+ *   RELEASE      the button went up
+ *   LONG_PRESS   the button has been held for long_press_ms
+ *   DOUBLE_PRESS second short press within double_press_ms of the
+ *                previous release (sent after its PRESS)
+ *   CHORD        the button went down while others were held, 'buttons'
+ *                has all of them (sent after its PRESS)
+ *
+ * Like script_engine.h it doesn't know about GPIOs or FreeRTOS, all the
+ * times are in microseconds of whatever clock the caller uses.
+ */
+
+#ifndef BUTTON_GESTURE_H
+#define BUTTON_GESTURE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BUTTON_GESTURE_MAX_BUTTONS 8 // one bit each in the masks
+
+// Default timings (in ms)
+#define BUTTON_GESTURE_DEBOUNCE_MS 20      // changes closer than this are bounces
+#define BUTTON_GESTURE_LONG_PRESS_MS 600   // held for this long is a long press
+#define BUTTON_GESTURE_DOUBLE_PRESS_MS 300 // from a release to the next press
+
+#define BUTTON_GESTURE_NO_TIMEOUT UINT32_MAX
+
+    typedef enum
+    {
+        BUTTON_GESTURE_PRESS,
+        BUTTON_GESTURE_RELEASE,
+        BUTTON_GESTURE_LONG_PRESS,
+        BUTTON_GESTURE_DOUBLE_PRESS,
+        BUTTON_GESTURE_CHORD,
+    } button_gesture_type_t;
+
+    typedef struct
+    {
+        button_gesture_type_t type;
+        uint8_t button;  // index of the button that caused the gesture
+        uint8_t buttons; // mask of the buttons held down after the gesture
+        uint32_t time_us; // when the edge (or the timeout) was seen
+    } button_gesture_event_t;
+
+    typedef void (*button_gesture_callback_t)(void *ctx, const button_gesture_event_t *event);
+
+    typedef struct
+    {
+        uint16_t debounce_ms;
+        uint16_t long_press_ms;
+        uint16_t double_press_ms;
+    } button_gesture_config_t;
+
+    typedef struct
+    {
+        button_gesture_config_t config;
+        button_gesture_callback_t callback;
+        void *ctx;
+        uint8_t num_buttons;
+
+        uint8_t raw;          // last level seen for every button (bit mask)
+        uint8_t stable;       // debounced levels
+        uint8_t settling;     // buttons inside their debounce window
+        uint8_t long_pending; // held buttons that haven't sent LONG_PRESS yet
+        uint8_t double_armed; // released buttons a press would make a double press
+        uint8_t chorded;      // buttons that took part in a chord since pressed
+        uint32_t changed_us[BUTTON_GESTURE_MAX_BUTTONS];  // last debounced change
+        uint32_t released_us[BUTTON_GESTURE_MAX_BUTTONS]; // last short release
+    } button_gesture_t;
+
+    // 'levels' is the mask of the buttons already down at 'now_us'
+    void button_gesture_init(button_gesture_t *gesture, uint8_t num_buttons, uint8_t levels,
+                             button_gesture_callback_t callback, void *ctx);
+
+    void button_gesture_set_config(button_gesture_t *gesture, const button_gesture_config_t *config);
+
+    // A button has been seen at 'level' (1 pressed), may send gestures
+    void button_gesture_input(button_gesture_t *gesture, uint8_t button, uint8_t level, uint32_t now_us);
+
+    // Sends the gestures that depend on time (end of the debounce windows,
+    // long presses), call it when the timeout below expires
+    void button_gesture_poll(button_gesture_t *gesture, uint32_t now_us);
+
+    // Microseconds until button_gesture_poll() has something to do,
+    // BUTTON_GESTURE_NO_TIMEOUT if nothing is pending
+    uint32_t button_gesture_timeout_us(const button_gesture_t *gesture, uint32_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUTTON_GESTURE_H */
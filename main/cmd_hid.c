@@ -0,0 +1,428 @@
+/* Console commands of the HID side of the box
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_console.h"
+#include "argtable3/argtable3.h"
+
+#include "script_executor.h"
+#include "app_script.h"
+#include "hid_keymap.h"
+#include "led_framebuffer.h"
+#include "ble_hid_app.h"
+#include "hid_dev.h"
+#include "event_bus.h"
+#include "cmd_hid.h"
+
+#define SCRIPT_TIMING_MAX_MS 1000 // same range as the timings in menuconfig
+
+static void register_script_timing(void);
+static void register_keyboard_layout(void);
+static void register_latency(void);
+static void register_leds(void);
+static void register_hosts(void);
+static void register_reports(void);
+static void register_events(void);
+static void register_script(void);
+
+void register_hid(void)
+{
+    register_script_timing();
+    register_keyboard_layout();
+    register_latency();
+    register_leds();
+    register_hosts();
+    register_reports();
+    register_events();
+    register_script();
+}
+
+/** Arguments used by 'script_timing' function */
+static struct {
+    struct arg_int *press;
+    struct arg_int *release;
+    struct arg_int *combo;
+    struct arg_int *click;
+    struct arg_int *rollover;
+    struct arg_end *end;
+} script_timing_args;
+
+/* Takes a timing option if given, false if it's out of range */
+static bool script_timing_ms(const struct arg_int *arg, const char *name, uint16_t *ms)
+{
+    if (arg->count == 0) {
+        return true;
+    }
+    if (arg->ival[0] < 0 || arg->ival[0] > SCRIPT_TIMING_MAX_MS) {
+        printf("%s must be between 0 and %d ms\n", name, SCRIPT_TIMING_MAX_MS);
+        return false;
+    }
+    *ms = arg->ival[0];
+    return true;
+}
+
+/* 'script_timing' command */
+static int script_timing(int argc, char **argv)
+{
+    script_engine_config_t config;
+
+    int nerrors = arg_parse(argc, argv, (void **) &script_timing_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, script_timing_args.end, argv[0]);
+        return 1;
+    }
+
+    script_executor_get_config(&config);
+
+    if (!script_timing_ms(script_timing_args.press, "Key press", &config.key_press_ms) ||
+        !script_timing_ms(script_timing_args.release, "Key release", &config.key_release_ms) ||
+        !script_timing_ms(script_timing_args.combo, "Combination", &config.combo_key_ms) ||
+        !script_timing_ms(script_timing_args.click, "Mouse click", &config.mouse_click_ms)) {
+        return 1;
+    }
+    if (script_timing_args.rollover->count) {
+        if (script_timing_args.rollover->ival[0] < 1 ||
+            script_timing_args.rollover->ival[0] > SCRIPT_ENGINE_MAX_ROLLOVER_KEYS) {
+            printf("Rollover keys must be between 1 and %d\n", SCRIPT_ENGINE_MAX_ROLLOVER_KEYS);
+            return 1;
+        }
+        config.rollover_keys = script_timing_args.rollover->ival[0];
+    }
+
+    if (!script_executor_set_config(&config)) {
+        printf("Script executor not ready\n");
+        return 1;
+    }
+
+    printf("Key press: %d ms, key release: %d ms, combination: %d ms, mouse click: %d ms\n",
+        config.key_press_ms, config.key_release_ms, config.combo_key_ms, config.mouse_click_ms);
+    printf("Keys held down together while typing: %d\n", config.rollover_keys);
+
+    return 0;
+}
+
+static void register_script_timing(void)
+{
+    script_timing_args.press = arg_int0("p", "press", "<ms>", "Key press time");
+    script_timing_args.release = arg_int0("r", "release", "<ms>", "Pause after a key release");
+    script_timing_args.combo = arg_int0("c", "combo", "<ms>", "Pause between the keys of a combination");
+    script_timing_args.click = arg_int0("m", "click", "<ms>", "Mouse click time");
+    script_timing_args.rollover = arg_int0("k", "rollover", "<keys>", "Keys held down together while typing (1 = one at a time)");
+    script_timing_args.end = arg_end(5);
+
+    const esp_console_cmd_t cmd = {
+        .command = "script_timing",
+        .help = "Show or change the timings used by the HID scripts (lost on reboot)",
+        .hint = NULL,
+        .func = &script_timing,
+        .argtable = &script_timing_args
+    };
+    ESP_ERROR_CHECK( esp_console_cmd_register(&cmd) );
+}
+
+/** Arguments used by 'keyboard_layout' function */
+static struct {
+    struct arg_str *layout;
+    struct arg_end *end;
+} keyboard_layout_args;
+
+/* 'keyboard_layout' command */
+static int keyboard_layout(int argc, char **argv)
+{
+    hid_keymap_layout_t layout;
+    uint8_t i;
+
+    int nerrors = arg_parse(argc, argv, (void **) &keyboard_layout_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, keyboard_layout_args.end, argv[0]);
+        return 1;
+    }
+
+    if (keyboard_layout_args.layout->count) {
+        layout = hid_keymap_from_name(keyboard_layout_args.layout->sval[0]);
+        if (layout == HID_KEYMAP_LAYOUTS) {
+            printf("Unknown layout, available:");
+            for (i = 0; i < HID_KEYMAP_LAYOUTS; i++) {
+                printf(" %s", hid_keymap_name((hid_keymap_layout_t)i));
+            }
+            printf("\n");
+            return 1;
+        }
+        hid_keymap_select(layout);
+    }
+
+    printf("Keyboard layout: %s\n", hid_keymap_name(hid_keymap_selected()));
+
+    return 0;
+}
+
+static void register_keyboard_layout(void)
+{
+    keyboard_layout_args.layout = arg_str0(NULL, NULL, "<us|it|de>", "Layout configured on the host");
+    keyboard_layout_args.end = arg_end(1);
+
+    const esp_console_cmd_t cmd = {
+        .command = "keyboard_layout",
+        .help = "Show or change the keyboard layout used to type text (lost on reboot)",
+        .hint = NULL,
+        .func = &keyboard_layout,
+        .argtable = &keyboard_layout_args
+    };
+    ESP_ERROR_CHECK( esp_console_cmd_register(&cmd) );
+}
+
+/** Arguments used by 'latency' function */
+static struct {
+    struct arg_lit *reset;
+    struct arg_end *end;
+} latency_args;
+
+/* 'latency' command */
+static int latency(int argc, char **argv)
+{
+    static const uint16_t limits_ms[SCRIPT_EXECUTOR_LATENCY_BUCKETS - 1] = SCRIPT_EXECUTOR_LATENCY_BUCKETS_MS;
+    script_executor_latency_t stats;
+    uint8_t i;
+
+    int nerrors = arg_parse(argc, argv, (void **) &latency_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, latency_args.end, argv[0]);
+        return 1;
+    }
+
+    script_executor_get_latency(&stats);
+
+    printf("Button press to first report, %u scripts\n", stats.count);
+    if (stats.count) {
+        printf("min %u us, avg %u us, max %u us\n", stats.min_us,
+               (uint32_t)(stats.total_us / stats.count), stats.max_us);
+        for (i = 0; i < SCRIPT_EXECUTOR_LATENCY_BUCKETS; i++) {
+            if (i < SCRIPT_EXECUTOR_LATENCY_BUCKETS - 1) {
+                printf("  < %3u ms: %u\n", limits_ms[i], stats.buckets[i]);
+            } else {
+                printf("  >=%3u ms: %u\n", limits_ms[i - 1], stats.buckets[i]);
+            }
+        }
+    }
+
+    if (latency_args.reset->count) {
+        script_executor_reset_latency();
+    }
+
+    return 0;
+}
+
+static void register_latency(void)
+{
+    latency_args.reset = arg_lit0("r", "reset", "Clear the histogram after printing it");
+    latency_args.end = arg_end(1);
+
+    const esp_console_cmd_t cmd = {
+        .command = "latency",
+        .help = "Show the histogram of the button press to HID report latency",
+        .hint = NULL,
+        .func = &latency,
+        .argtable = &latency_args
+    };
+    ESP_ERROR_CHECK( esp_console_cmd_register(&cmd) );
+}
+
+/** Arguments used by 'leds' function */
+static struct {
+    struct arg_int *brightness;
+    struct arg_end *end;
+} leds_args;
+
+/* 'leds' command */
+static int leds(int argc, char **argv)
+{
+    led_framebuffer_stats_t stats;
+
+    int nerrors = arg_parse(argc, argv, (void **) &leds_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, leds_args.end, argv[0]);
+        return 1;
+    }
+
+    if (leds_args.brightness->count) {
+        if (leds_args.brightness->ival[0] < 0 || leds_args.brightness->ival[0] > 100) {
+            printf("Brightness must be between 0 and 100\n");
+            return 1;
+        }
+        led_framebuffer_set_brightness(leds_args.brightness->ival[0] * 255 / 100);
+    }
+
+    led_framebuffer_get_stats(&stats);
+
+    printf("LED brightness: %d%%\n", led_framebuffer_get_brightness() * 100 / 255);
+    printf("LED updates requested: %u, applied: %u, frames sent: %u\n",
+           stats.updates_requested, stats.updates_applied, stats.frames_sent);
+
+    return 0;
+}
+
+static void register_leds(void)
+{
+    leds_args.brightness = arg_int0("b", "brightness", "<0-100>", "Brightness of all the LEDs (lost on reboot)");
+    leds_args.end = arg_end(1);
+
+    const esp_console_cmd_t cmd = {
+        .command = "leds",
+        .help = "Show the LED framebuffer counters or dim the LEDs",
+        .hint = NULL,
+        .func = &leds,
+        .argtable = &leds_args
+    };
+    ESP_ERROR_CHECK( esp_console_cmd_register(&cmd) );
+}
+
+/** Arguments used by 'hosts' function */
+static struct {
+    struct arg_lit *swap;
+    struct arg_end *end;
+} hosts_args;
+
+/* 'hosts' command */
+static int hosts(int argc, char **argv)
+{
+    static const char *names[BLE_HID_HOSTS] = {"mobile", "PC"};
+    uint16_t conn_id;
+    uint8_t i;
+
+    int nerrors = arg_parse(argc, argv, (void **) &hosts_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, hosts_args.end, argv[0]);
+        return 1;
+    }
+
+    if (hosts_args.swap->count) {
+        ble_hid_swap_hosts();
+    }
+
+    for (i = 0; i < BLE_HID_HOSTS; i++) {
+        conn_id = ble_hid_get_host_conn_id(i);
+        if (conn_id == BLE_HID_CONN_ID_NONE) {
+            printf("%-6s: not connected\n", names[i]);
+        } else {
+            printf("%-6s: conn_id %u\n", names[i], conn_id);
+        }
+    }
+
+    return 0;
+}
+
+static void register_hosts(void)
+{
+    hosts_args.swap = arg_lit0("s", "swap", "Swap the connections of the mobile and PC app controls");
+    hosts_args.end = arg_end(1);
+
+    const esp_console_cmd_t cmd = {
+        .command = "hosts",
+        .help = "Show which BLE connection serves the mobile and the PC app controls",
+        .hint = NULL,
+        .func = &hosts,
+        .argtable = &hosts_args
+    };
+    ESP_ERROR_CHECK( esp_console_cmd_register(&cmd) );
+}
+
+/* 'reports' command */
+static int reports(int argc, char **argv)
+{
+    hid_dev_tx_stats_t stats;
+
+    hid_dev_get_tx_stats(&stats);
+
+    printf("HID reports sent: %u, coalesced: %u, retried: %u, dropped: %u\n",
+           stats.sent, stats.coalesced, stats.retried, stats.dropped);
+
+    return 0;
+}
+
+static void register_reports(void)
+{
+    const esp_console_cmd_t cmd = {
+        .command = "reports",
+        .help = "Show the counters of the HID report TX queues",
+        .hint = NULL,
+        .func = &reports,
+    };
+    ESP_ERROR_CHECK( esp_console_cmd_register(&cmd) );
+}
+
+/* 'events' command */
+static int events(int argc, char **argv)
+{
+    event_bus_stats_t stats;
+
+    event_bus_get_stats(&stats);
+
+    printf("Events published: %u, delivered: %u, dropped: %u, without subscribers: %u\n",
+           stats.published, stats.delivered, stats.dropped, stats.skipped);
+
+    return 0;
+}
+
+static void register_events(void)
+{
+    const esp_console_cmd_t cmd = {
+        .command = "events",
+        .help = "Show the counters of the event bus",
+        .hint = NULL,
+        .func = &events,
+    };
+    ESP_ERROR_CHECK( esp_console_cmd_register(&cmd) );
+}
+
+/** Arguments used by 'script' function */
+static struct {
+    struct arg_int *app;
+    struct arg_int *script;
+    struct arg_end *end;
+} script_args;
+
+/* 'script' command */
+static int script(int argc, char **argv)
+{
+    const uint8_t *code;
+    uint8_t length;
+
+    int nerrors = arg_parse(argc, argv, (void **) &script_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, script_args.end, argv[0]);
+        return 1;
+    }
+
+    code = ble_hid_get_script(script_args.app->ival[0], script_args.script->ival[0], &length);
+    if (code == NULL) {
+        printf("No script %d for app control %d\n", script_args.script->ival[0], script_args.app->ival[0]);
+        return 1;
+    }
+
+    printf("%d bytes\n", length);
+    app_script_disassemble(code, length);
+
+    return 0;
+}
+
+static void register_script(void)
+{
+    script_args.app = arg_int1(NULL, NULL, "<app>", "App control, from 0");
+    script_args.script = arg_int1(NULL, NULL, "<script>", "Script of the app control, from 0");
+    script_args.end = arg_end(2);
+
+    const esp_console_cmd_t cmd = {
+        .command = "script",
+        .help = "Disassemble a compiled app control script",
+        .hint = NULL,
+        .func = &script,
+        .argtable = &script_args
+    };
+    ESP_ERROR_CHECK( esp_console_cmd_register(&cmd) );
+}
@@ -0,0 +1,18 @@
+/* Console commands of the HID side of the box
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Register HID functions
+void register_hid(void);
+
+#ifdef __cplusplus
+}
+#endif
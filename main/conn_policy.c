@@ -0,0 +1,280 @@
+/*
+ * Connection parameters policy, see conn_policy.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+#include "esp_hidd_prf_api.h"
+#include "conn_policy.h"
+#include "event_bus.h"
+#include "script_executor.h"
+
+#define CONN_POLICY_CONN_ID_NONE 0xFFFF
+
+typedef struct
+{
+    bool in_use;
+    bool encrypted;
+    bool fast;       // the last request was for the fast parameters
+    uint8_t scripts; // running scripts that send to this connection
+    uint16_t conn_id;
+    esp_bd_addr_t bda;
+    esp_timer_handle_t idle_timer;
+} conn_policy_link_t;
+
+// used by the BTC task, the event bus task and the idle timers
+static conn_policy_link_t conn_policy_links[ESP_HIDD_MAX_CONN];
+static portMUX_TYPE conn_policy_mux = portMUX_INITIALIZER_UNLOCKED;
+static conn_policy_route_t conn_policy_route = NULL;
+
+// connection every running engine was routed to when its script started:
+// the route may change before it finishes (hosts swapped or reconnected)
+// and the same link has to be released
+static uint16_t conn_policy_script_conn_ids[SCRIPT_EXECUTOR_MAX_RUNNING];
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static conn_policy_link_t *conn_policy_find(uint16_t conn_id);
+static conn_policy_link_t *conn_policy_find_bda(const uint8_t *bda);
+static void conn_policy_request(const esp_bd_addr_t bda, bool fast);
+static void conn_policy_script_event(void *ctx, const event_bus_event_t *event);
+static void conn_policy_idle(void *arg);
+
+// FUNCTION DEFINITIONS
+
+void conn_policy_init(conn_policy_route_t route)
+{
+    esp_timer_create_args_t timer_args = {
+        .callback = conn_policy_idle,
+        .name = "conn_idle",
+    };
+    uint8_t i;
+
+    conn_policy_route = route;
+
+    for (i = 0; i < ESP_HIDD_MAX_CONN; i++)
+    {
+        timer_args.arg = &conn_policy_links[i];
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &conn_policy_links[i].idle_timer));
+    }
+
+    for (i = 0; i < SCRIPT_EXECUTOR_MAX_RUNNING; i++)
+        conn_policy_script_conn_ids[i] = CONN_POLICY_CONN_ID_NONE;
+
+    event_bus_subscribe(EVENT_BUS_MASK(EVENT_BUS_SCRIPT_STARTED) | EVENT_BUS_MASK(EVENT_BUS_SCRIPT_FINISHED),
+                        conn_policy_script_event, NULL);
+}
+
+void conn_policy_connected(uint16_t conn_id, const esp_bd_addr_t bda)
+{
+    uint8_t i;
+
+    portENTER_CRITICAL(&conn_policy_mux);
+    for (i = 0; i < ESP_HIDD_MAX_CONN; i++)
+    {
+        if (!conn_policy_links[i].in_use)
+        {
+            conn_policy_links[i].in_use = true;
+            conn_policy_links[i].encrypted = false;
+            conn_policy_links[i].fast = false;
+            conn_policy_links[i].scripts = 0;
+            conn_policy_links[i].conn_id = conn_id;
+            memcpy(conn_policy_links[i].bda, bda, sizeof(esp_bd_addr_t));
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&conn_policy_mux);
+}
+
+void conn_policy_disconnected(uint16_t conn_id)
+{
+    conn_policy_link_t *link = conn_policy_find(conn_id);
+    uint8_t i;
+
+    if (link == NULL)
+        return;
+
+    esp_timer_stop(link->idle_timer);
+
+    portENTER_CRITICAL(&conn_policy_mux);
+    link->in_use = false;
+    // a new link may get the same conn_id, its scripts aren't these
+    for (i = 0; i < SCRIPT_EXECUTOR_MAX_RUNNING; i++)
+    {
+        if (conn_policy_script_conn_ids[i] == conn_id)
+            conn_policy_script_conn_ids[i] = CONN_POLICY_CONN_ID_NONE;
+    }
+    portEXIT_CRITICAL(&conn_policy_mux);
+}
+
+void conn_policy_gap_event(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
+{
+    conn_policy_link_t *link;
+    esp_bd_addr_t bda;
+    bool fast;
+
+    switch (event)
+    {
+    case ESP_GAP_BLE_AUTH_CMPL_EVT:
+        if (!param->ble_security.auth_cmpl.success)
+            break;
+
+        link = conn_policy_find_bda(param->ble_security.auth_cmpl.bd_addr);
+        if (link == NULL)
+            break;
+
+        // nothing was requested before the encryption, catch up now
+        portENTER_CRITICAL(&conn_policy_mux);
+        link->encrypted = true;
+        link->fast = (link->scripts > 0);
+        fast = link->fast;
+        memcpy(bda, link->bda, sizeof(esp_bd_addr_t));
+        portEXIT_CRITICAL(&conn_policy_mux);
+
+        conn_policy_request(bda, fast);
+        break;
+
+    case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+        link = conn_policy_find_bda(param->update_conn_params.bda);
+
+        // conn_int is in units of 1.25 ms, timeout in units of 10 ms
+        printf("conn_policy: conn_id %d, status %d, interval %u.%02u ms, latency %u, timeout %u ms\n",
+               link ? link->conn_id : -1, param->update_conn_params.status,
+               param->update_conn_params.conn_int * 125 / 100, param->update_conn_params.conn_int * 125 % 100,
+               param->update_conn_params.latency, param->update_conn_params.timeout * 10);
+        break;
+
+    default:
+        break;
+    }
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static conn_policy_link_t *conn_policy_find(uint16_t conn_id)
+{
+    uint8_t i;
+
+    for (i = 0; i < ESP_HIDD_MAX_CONN; i++)
+    {
+        if (conn_policy_links[i].in_use && conn_policy_links[i].conn_id == conn_id)
+            return &conn_policy_links[i];
+    }
+
+    return NULL;
+}
+
+static conn_policy_link_t *conn_policy_find_bda(const uint8_t *bda)
+{
+    uint8_t i;
+
+    for (i = 0; i < ESP_HIDD_MAX_CONN; i++)
+    {
+        if (conn_policy_links[i].in_use && memcmp(conn_policy_links[i].bda, bda, sizeof(esp_bd_addr_t)) == 0)
+            return &conn_policy_links[i];
+    }
+
+    return NULL;
+}
+
+static void conn_policy_request(const esp_bd_addr_t bda, bool fast)
+{
+    esp_ble_conn_update_params_t params;
+
+    memcpy(params.bda, bda, sizeof(esp_bd_addr_t));
+    if (fast)
+    {
+        params.min_int = CONN_POLICY_FAST_MIN_INTERVAL;
+        params.max_int = CONN_POLICY_FAST_MAX_INTERVAL;
+        params.latency = CONN_POLICY_FAST_LATENCY;
+        params.timeout = CONN_POLICY_FAST_TIMEOUT;
+    }
+    else
+    {
+        params.min_int = CONN_POLICY_IDLE_MIN_INTERVAL;
+        params.max_int = CONN_POLICY_IDLE_MAX_INTERVAL;
+        params.latency = CONN_POLICY_IDLE_LATENCY;
+        params.timeout = CONN_POLICY_IDLE_TIMEOUT;
+    }
+
+    if (esp_ble_gap_update_conn_params(&params) != ESP_OK)
+        printf("conn_policy: %s parameters not requested\n", fast ? "fast" : "idle");
+}
+
+// A connection is fast from the start of a script sending to it until
+// it has had no script for CONN_POLICY_IDLE_MS. The script is routed
+// once, when it starts, and finishes on that same connection.
+static void conn_policy_script_event(void *ctx, const event_bus_event_t *event)
+{
+    conn_policy_link_t *link;
+    uint16_t conn_id = CONN_POLICY_CONN_ID_NONE;
+    esp_bd_addr_t bda;
+    bool request = false;
+    bool idle = false;
+
+    if (event->script.engine >= SCRIPT_EXECUTOR_MAX_RUNNING)
+        return;
+
+    if (event->type == EVENT_BUS_SCRIPT_STARTED && conn_policy_route != NULL)
+        conn_id = conn_policy_route(event->script.tag);
+
+    portENTER_CRITICAL(&conn_policy_mux);
+    if (event->type == EVENT_BUS_SCRIPT_STARTED)
+    {
+        conn_policy_script_conn_ids[event->script.engine] = conn_id;
+    }
+    else
+    {
+        conn_id = conn_policy_script_conn_ids[event->script.engine];
+        conn_policy_script_conn_ids[event->script.engine] = CONN_POLICY_CONN_ID_NONE;
+    }
+
+    link = conn_policy_find(conn_id);
+    if (link != NULL)
+    {
+        if (event->type == EVENT_BUS_SCRIPT_STARTED)
+        {
+            link->scripts++;
+            request = link->encrypted && !link->fast;
+            link->fast = link->fast || request;
+        }
+        else if (link->scripts > 0)
+        {
+            link->scripts--;
+            idle = (link->scripts == 0);
+        }
+        memcpy(bda, link->bda, sizeof(esp_bd_addr_t));
+    }
+    portEXIT_CRITICAL(&conn_policy_mux);
+
+    if (link == NULL)
+        return;
+
+    esp_timer_stop(link->idle_timer);
+    if (idle)
+        esp_timer_start_once(link->idle_timer, CONN_POLICY_IDLE_MS * 1000ULL);
+
+    if (request)
+        conn_policy_request(bda, true);
+}
+
+static void conn_policy_idle(void *arg)
+{
+    conn_policy_link_t *link = (conn_policy_link_t *)arg;
+    esp_bd_addr_t bda;
+    bool request;
+
+    portENTER_CRITICAL(&conn_policy_mux);
+    request = link->in_use && link->fast && link->scripts == 0;
+    if (request)
+        link->fast = false;
+    memcpy(bda, link->bda, sizeof(esp_bd_addr_t));
+    portEXIT_CRITICAL(&conn_policy_mux);
+
+    if (request)
+        conn_policy_request(bda, false);
+}
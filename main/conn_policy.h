@@ -0,0 +1,59 @@
+/*
+ * Connection parameters policy.
+ *
+ * The host picks the connection interval when a central connects, often
+ * a slow one, and the report latency follows. This module asks every
+ * connection for a short interval without slave latency while a script
+ * is sending reports to it, and for power saving parameters once the
+ * connection has been idle for CONN_POLICY_IDLE_MS. Requests are made
+ * only once the link is encrypted: some hosts (iOS) refuse parameter
+ * updates during the encryption. The parameters the host actually
+ * chooses are logged for every connection.
+ */
+
+#ifndef CONN_POLICY_H
+#define CONN_POLICY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_gap_ble_api.h"
+
+// intervals in units of 1.25 ms, supervision timeout in units of 10 ms
+// iOS takes 11.25 ms as the minimum from HID devices only, and wants the
+// maximum at least 15 ms above the minimum (or both at 15 ms)
+#define CONN_POLICY_FAST_MIN_INTERVAL 0x09 // 11.25 ms
+#define CONN_POLICY_FAST_MAX_INTERVAL 0x18 // 30 ms
+#define CONN_POLICY_FAST_LATENCY 0
+#define CONN_POLICY_FAST_TIMEOUT 400       // 4 s
+
+#define CONN_POLICY_IDLE_MIN_INTERVAL 0x18 // 30 ms
+#define CONN_POLICY_IDLE_MAX_INTERVAL 0x30 // 60 ms
+#define CONN_POLICY_IDLE_LATENCY 4         // the device may skip 4 events in a row
+#define CONN_POLICY_IDLE_TIMEOUT 600       // 6 s
+
+#define CONN_POLICY_IDLE_MS 5000 // without scripts before relaxing the connection
+
+    // Connection the reports of the script with this tag go to, 0xFFFF if none
+    typedef uint16_t (*conn_policy_route_t)(uint16_t tag);
+
+    // Subscribes to the script events, after event_bus_init()
+    void conn_policy_init(conn_policy_route_t route);
+
+    // From the HID profile callbacks (BTC task)
+    void conn_policy_connected(uint16_t conn_id, const esp_bd_addr_t bda);
+    void conn_policy_disconnected(uint16_t conn_id);
+
+    // From the GAP callback, follows the encryption and the parameter updates
+    void conn_policy_gap_event(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONN_POLICY_H */
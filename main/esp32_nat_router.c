@@ -44,6 +44,7 @@
 #include "string.h"
 
 #include "io_hardware.h"
+#include "event_bus.h"
 
 #define FIRMWARE_VERSION 0.82
 #define UPDATE_OTA_JSON_URL "https://github.com/Live4win/HID_Control_WIFI_receiver/raw/main/OTA_info.json"
@@ -94,7 +95,8 @@ static void initialize_filesystem(void)
 }
 #endif // CONFIG_STORE_HISTORY
 
-static void update_wifi_led(void);
+static void publish_wifi_state(event_bus_wifi_state_t state);
+static void publish_wifi_link_state(void);
 
 static void initialize_nvs(void)
 {
@@ -176,14 +178,14 @@ static esp_err_t wifi_event_handler(void *ctx, system_event_t *event)
         break;
     case SYSTEM_EVENT_STA_GOT_IP:
         ap_connect = true;
-        update_wifi_led();
+        publish_wifi_link_state();
         ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->event_info.got_ip.ip_info.ip));
         xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
         break;
     case SYSTEM_EVENT_STA_DISCONNECTED:
         ESP_LOGI(TAG, "disconnected - retry to connect to the AP");
         ap_connect = false;
-        update_wifi_led();
+        publish_wifi_link_state();
         esp_wifi_connect();
         xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT);
         break;
@@ -192,13 +194,13 @@ static esp_err_t wifi_event_handler(void *ctx, system_event_t *event)
         ESP_LOGI(TAG, "%d. station connected", connect_count);
         if (ap_connect)
         {
-            set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_BLUE);
+            publish_wifi_state(EVENT_BUS_WIFI_STATION_JOINED);
         }
         break;
     case SYSTEM_EVENT_AP_STADISCONNECTED:
         connect_count--;
         ESP_LOGI(TAG, "station disconnected - %d remain", connect_count);
-        update_wifi_led();
+        publish_wifi_link_state();
         break;
     default:
         break;
@@ -211,7 +213,7 @@ const int CONNECTED_BIT = BIT0;
 
 void wifi_init(const char *ssid, const char *passwd, const char *ap_ssid, const char *ap_passwd)
 {
-    set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_RED);
+    publish_wifi_state(EVENT_BUS_WIFI_STARTING);
     ip_addr_t dnsserver;
     //tcpip_adapter_dns_info_t dnsinfo;
 
@@ -357,8 +359,9 @@ void wifi_app_main(void) // was 'wifi_app_main'
     register_system();
     register_nvs();
     register_router();
+    register_hid();
 
-    update_wifi_led();
+    publish_wifi_link_state();
 
     /* Prompt to be printed before each line.
      * This can be customized, made dynamic, etc.
@@ -417,12 +420,12 @@ void wifi_app_main(void) // was 'wifi_app_main'
 
         // wait for the connection to be established
         vTaskDelay(5000 / portTICK_PERIOD_MS);
-        set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_OFF); // should turn off the led
+        publish_wifi_state(EVENT_BUS_WIFI_WAITING); // should turn off the led
         check_OTA_update();                                 // Control for new OTA updates if possible..
         OTA_check_timeout_counter++;
     } while (!ap_connect && (OTA_check_timeout_counter < UPDATE_MAX_RETRIES)); // while the wifi is unconfigured..
 
-    set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_GREEN); // the device is ready to be used
+    publish_wifi_state(EVENT_BUS_WIFI_READY); // the device is ready to be used
 
     /* Main loop */
     while (true)
@@ -467,18 +470,32 @@ void wifi_app_main(void) // was 'wifi_app_main'
     }
 }
 
-static void update_wifi_led(void)
+static void publish_wifi_state(event_bus_wifi_state_t state)
 {
-    if (ap_connect)
-    {
-        set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_GREEN); // was 5 (testing)
-        printf("Updating wifi led..\n");
-    }
-    else
-    {
-        set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_RED); // was 5 (testing)
-        printf("Updating wifi led..\n");
-    }
+    event_bus_event_t event = {
+        .type = EVENT_BUS_WIFI_STATE,
+        .wifi.state = state,
+        .wifi.stations = connect_count,
+    };
+
+    event_bus_publish(&event);
+}
+
+static void publish_wifi_link_state(void)
+{
+    publish_wifi_state(ap_connect ? EVENT_BUS_WIFI_CONNECTED : EVENT_BUS_WIFI_DISCONNECTED);
+    printf("Updating wifi led..\n");
+}
+
+static void publish_ota_state(event_bus_ota_state_t state, uint8_t percent)
+{
+    event_bus_event_t event = {
+        .type = EVENT_BUS_OTA,
+        .ota.state = state,
+        .ota.percent = percent,
+    };
+
+    event_bus_publish(&event);
 }
 
 // receive buffer
@@ -552,7 +569,7 @@ void check_OTA_update(void)
                     printf("current firmware version (%.2f) is different than the available one (%.2f), updating...\n", FIRMWARE_VERSION, new_version);
 
                     // notify the user via the wifi led
-                    set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_YELLOW);
+                    publish_ota_state(EVENT_BUS_OTA_STARTED, 0);
 
                     if (cJSON_IsString(file) && (file->valuestring != NULL))
                     {
@@ -569,11 +586,13 @@ void check_OTA_update(void)
                         if (ret == ESP_OK)
                         {
                             printf("OTA OK, restarting...\n");
+                            publish_ota_state(EVENT_BUS_OTA_DONE, 100);
                             esp_restart();
                         }
                         else
                         {
                             printf("OTA failed...\n");
+                            publish_ota_state(EVENT_BUS_OTA_FAILED, 0);
                         }
                     }
                     else
@@ -22,15 +22,18 @@
 // HID keyboard input report length
 #define HID_KEYBOARD_IN_RPT_LEN     8
 
-// HID LED output report length
-#define HID_LED_OUT_RPT_LEN         1
-
 // HID mouse input report length
-#define HID_MOUSE_IN_RPT_LEN        5
+#define HID_MOUSE_IN_RPT_LEN        7
+
+// HID boot mouse input report length (buttons, X, Y)
+#define HID_BOOT_MOUSE_IN_RPT_LEN   3
 
 // HID consumer control input report length
 #define HID_CC_IN_RPT_LEN           2
 
+// HID touch screen input report length (touching and in range bits, X, Y)
+#define HID_TOUCH_IN_RPT_LEN        5
+
 esp_err_t esp_hidd_register_callbacks(esp_hidd_event_cb_t callbacks)
 {
     esp_err_t hidd_status;
@@ -63,6 +66,7 @@ esp_err_t esp_hidd_profile_init(void)
     // Reset the hid device target environment
     memset(&hidd_le_env, 0, sizeof(hidd_le_env_t));
     hidd_le_env.enabled = true;
+    hid_dev_tx_init();
     return ESP_OK;
 }
 
@@ -92,6 +96,25 @@ uint16_t esp_hidd_get_version(void)
 	return HIDD_VERSION;
 }
 
+uint8_t esp_hidd_get_num_connections(void)
+{
+    uint8_t num = 0;
+
+    for (uint8_t i = 0; i < HID_MAX_APPS; i++) {
+        if (hidd_le_env.hidd_clcb[i].in_use) {
+            num++;
+        }
+    }
+    return num;
+}
+
+uint8_t esp_hidd_get_keyboard_leds(uint16_t conn_id)
+{
+    hidd_clcb_t *p_clcb = hidd_clcb_find(conn_id);
+
+    return (p_clcb != NULL) ? __atomic_load_n(&p_clcb->leds, __ATOMIC_RELAXED) : 0;
+}
+
 void esp_hidd_send_consumer_value(uint16_t conn_id, uint8_t key_cmd, bool key_pressed)
 {
     uint8_t buffer[HID_CC_IN_RPT_LEN] = {0, 0};
@@ -127,19 +150,68 @@ void esp_hidd_send_keyboard_value(uint16_t conn_id, key_mask_t special_key_mask,
 }
 
 void esp_hidd_send_mouse_value(uint16_t conn_id, uint8_t mouse_button, int8_t mickeys_x, int8_t mickeys_y)
+{
+    esp_hidd_send_mouse_report(conn_id, mouse_button, mickeys_x, mickeys_y, 0, 0);
+}
+
+static int8_t hidd_clamp_int8(int16_t value)
+{
+    return (value < -127) ? -127 : (value > 127) ? 127 : value;
+}
+
+void esp_hidd_send_mouse_report(uint16_t conn_id, uint8_t mouse_button, int16_t mickeys_x, int16_t mickeys_y,
+                                int8_t wheel, int8_t pan)
 {
     uint8_t buffer[HID_MOUSE_IN_RPT_LEN];
-    
-    buffer[0] = mouse_button;   // Buttons
-    buffer[1] = mickeys_x;           // X
-    buffer[2] = mickeys_y;           // Y
-    buffer[3] = 0;           // Wheel
-    buffer[4] = 0;           // AC Pan
+
+    // the boot protocol report has 3 buttons and 8 bit X and Y only
+    if (hid_dev_get_protocol_mode(conn_id) == HID_PROTOCOL_MODE_BOOT) {
+        buffer[0] = mouse_button & 0x07;
+        buffer[1] = hidd_clamp_int8(mickeys_x);
+        buffer[2] = hidd_clamp_int8(mickeys_y);
+        hid_dev_send_report(hidd_le_env.gatt_if, conn_id,
+                            HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT, HID_BOOT_MOUSE_IN_RPT_LEN, buffer);
+        return;
+    }
+
+    buffer[0] = mouse_button & 0x1F;            // Buttons
+    buffer[1] = mickeys_x & 0xFF;               // X
+    buffer[2] = (mickeys_x >> 8) & 0xFF;
+    buffer[3] = mickeys_y & 0xFF;               // Y
+    buffer[4] = (mickeys_y >> 8) & 0xFF;
+    buffer[5] = wheel;                          // Wheel
+    buffer[6] = pan;                            // AC Pan
 
     hid_dev_send_report(hidd_le_env.gatt_if, conn_id,
                         HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT, HID_MOUSE_IN_RPT_LEN, buffer);
     return;
 }
 
+void esp_hidd_send_touch(uint16_t conn_id, bool touching, uint16_t x, uint16_t y)
+{
+    uint8_t buffer[HID_TOUCH_IN_RPT_LEN];
+
+    // there's no touch screen in the boot protocol
+    if (hid_dev_get_protocol_mode(conn_id) == HID_PROTOCOL_MODE_BOOT) {
+        return;
+    }
+
+    if (x > ESP_HIDD_TOUCH_MAX) {
+        x = ESP_HIDD_TOUCH_MAX;
+    }
+    if (y > ESP_HIDD_TOUCH_MAX) {
+        y = ESP_HIDD_TOUCH_MAX;
+    }
+
+    buffer[0] = touching ? 0x03 : 0x02;         // Tip switch, in range
+    buffer[1] = x & 0xFF;                       // X
+    buffer[2] = (x >> 8) & 0xFF;
+    buffer[3] = y & 0xFF;                       // Y
+    buffer[4] = (y >> 8) & 0xFF;
+
+    hid_dev_send_report(hidd_le_env.gatt_if, conn_id,
+                        HID_RPT_ID_TOUCH_IN, HID_REPORT_TYPE_INPUT, HID_TOUCH_IN_RPT_LEN, buffer);
+}
+
 
 
@@ -23,6 +23,12 @@
 extern "C" {
 #endif
 
+/// Centrals served at the same time (e.g. a phone and a PC), must not exceed CONFIG_BTDM_CTRL_BLE_MAX_CONN
+#define ESP_HIDD_MAX_CONN            2
+
+/// Touch screen coordinates go from 0 to this, in 0.01% of the screen width or height
+#define ESP_HIDD_TOUCH_MAX           10000
+
 typedef enum {
     ESP_HIDD_EVENT_REG_FINISH = 0,                     
     ESP_BAT_EVENT_REG,
@@ -30,6 +36,7 @@ typedef enum {
     ESP_HIDD_EVENT_BLE_CONNECT,                         
     ESP_HIDD_EVENT_BLE_DISCONNECT,
     ESP_HIDD_EVENT_BLE_VENDOR_REPORT_WRITE_EVT,
+    ESP_HIDD_EVENT_BLE_LED_REPORT_WRITE_EVT,
 } esp_hidd_cb_event_t;
 
 /// HID config status
@@ -59,6 +66,11 @@ typedef enum {
 #define RIGHT_ALT_KEY_MASK           (1 << 6)
 #define RIGHT_GUI_KEY_MASK           (1 << 7)
 
+/// Host keyboard LEDs, as in the keyboard output report
+#define ESP_HIDD_LED_NUM_LOCK        (1 << 0)
+#define ESP_HIDD_LED_CAPS_LOCK       (1 << 1)
+#define ESP_HIDD_LED_SCROLL_LOCK     (1 << 2)
+
 typedef uint8_t key_mask_t;
 /**
  * @brief HIDD callback parameters union 
@@ -91,7 +103,9 @@ typedef union {
      * @brief ESP_HIDD_EVENT_DISCONNECT
 	 */
     struct hidd_disconnect_evt_param {
+        uint16_t conn_id;                           /*!< HID connection index */
         esp_bd_addr_t remote_bda;                   /*!< HID Remote bluetooth device address */
+        uint8_t reason;                             /*!< esp_gatt_conn_reason_t */
     } disconnect;									/*!< HID callback param of ESP_HIDD_EVENT_DISCONNECT */
 
     /**
@@ -104,6 +118,14 @@ typedef union {
         uint8_t  *data;                             /*!< The pointer to the data */
     } vendor_write;									/*!< HID callback param of ESP_HIDD_EVENT_BLE_VENDOR_REPORT_WRITE_EVT */
 
+    /**
+     * @brief ESP_HIDD_EVENT_BLE_LED_REPORT_WRITE_EVT
+	 */
+    struct hidd_led_write_evt_param {
+        uint16_t conn_id;                           /*!< HID connection index */
+        uint8_t  leds;                              /*!< ESP_HIDD_LED_* bits */
+    } led_write;									/*!< HID callback param of ESP_HIDD_EVENT_BLE_LED_REPORT_WRITE_EVT */
+
 } esp_hidd_cb_param_t;
 
 
@@ -154,12 +176,46 @@ esp_err_t esp_hidd_profile_deinit(void);
  */
 uint16_t esp_hidd_get_version(void);
 
+/**
+ *
+ * @brief           Number of centrals currently connected (up to ESP_HIDD_MAX_CONN)
+ *
+ */
+uint8_t esp_hidd_get_num_connections(void);
+
+/**
+ *
+ * @brief           Keyboard LEDs (ESP_HIDD_LED_*) the host last wrote on the connection,
+ *                  all off until it writes the output report.
+ *
+ */
+uint8_t esp_hidd_get_keyboard_leds(uint16_t conn_id);
+
 void esp_hidd_send_consumer_value(uint16_t conn_id, uint8_t key_cmd, bool key_pressed);
 
 void esp_hidd_send_keyboard_value(uint16_t conn_id, key_mask_t special_key_mask, uint8_t *keyboard_cmd, uint8_t num_key);
 
 void esp_hidd_send_mouse_value(uint16_t conn_id, uint8_t mouse_button, int8_t mickeys_x, int8_t mickeys_y);
 
+/**
+ *
+ * @brief           Sends the whole mouse report: 5 buttons (bit 0 is the left one), 16 bit
+ *                  relative X and Y (-32767..32767), wheel and horizontal pan (-127..127).
+ *                  In boot protocol mode only 3 buttons and X, Y clamped to 8 bit go out.
+ *
+ */
+void esp_hidd_send_mouse_report(uint16_t conn_id, uint8_t mouse_button, int16_t mickeys_x, int16_t mickeys_y,
+                                int8_t wheel, int8_t pan);
+
+/**
+ *
+ * @brief           Sends the touch screen report: a finger touching (or just lifted) at the
+ *                  absolute position X, Y, from 0 (left, top) to ESP_HIDD_TOUCH_MAX (right,
+ *                  bottom) whatever the resolution of the host screen. Report protocol only.
+ *
+ */
+void esp_hidd_send_touch(uint16_t conn_id, bool touching, uint16_t x, uint16_t y);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,133 @@
+/*
+ * System event bus, see event_bus.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "event_bus.h"
+
+typedef struct
+{
+    uint32_t types;
+    event_bus_handler_t handler;
+    void *ctx;
+} event_bus_subscriber_t;
+
+// the pool, allocated once by event_bus_init()
+static QueueHandle_t event_bus_queue = NULL;
+
+// filled under the spinlock, a slot is visible to the dispatcher once
+// event_bus_subscribers_count covers it
+static event_bus_subscriber_t event_bus_subscribers[EVENT_BUS_MAX_SUBSCRIBERS];
+static uint8_t event_bus_subscribers_count = 0;
+// union of the subscribed types, checked before taking a slot
+static uint32_t event_bus_subscribed_types = 0;
+static portMUX_TYPE event_bus_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t event_bus_published = 0;
+static uint32_t event_bus_dropped = 0;
+static uint32_t event_bus_skipped = 0;
+static uint32_t event_bus_delivered = 0;
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void event_bus_task(void *pvParameters);
+
+// FUNCTION DEFINITIONS
+
+void event_bus_init(void)
+{
+    event_bus_queue = xQueueCreate(EVENT_BUS_POOL_SIZE, sizeof(event_bus_event_t));
+    if (event_bus_queue == NULL)
+    {
+        printf("event_bus: pool not allocated!\n");
+        return;
+    }
+
+    xTaskCreate(event_bus_task, "event_bus_task", 2560, NULL, 6, NULL);
+}
+
+bool event_bus_subscribe(uint32_t types, event_bus_handler_t handler, void *ctx)
+{
+    bool added = false;
+    uint8_t count;
+
+    portENTER_CRITICAL(&event_bus_mux);
+    count = event_bus_subscribers_count;
+    if (count < EVENT_BUS_MAX_SUBSCRIBERS)
+    {
+        event_bus_subscribers[count].types = types;
+        event_bus_subscribers[count].handler = handler;
+        event_bus_subscribers[count].ctx = ctx;
+        __atomic_store_n(&event_bus_subscribers_count, count + 1, __ATOMIC_RELEASE);
+        __atomic_fetch_or(&event_bus_subscribed_types, types, __ATOMIC_RELAXED);
+        added = true;
+    }
+    portEXIT_CRITICAL(&event_bus_mux);
+
+    if (!added)
+        printf("event_bus: no room for another subscriber\n");
+
+    return added;
+}
+
+bool event_bus_publish(event_bus_event_t *event)
+{
+    if (event_bus_queue == NULL)
+        return false;
+
+    if (!(__atomic_load_n(&event_bus_subscribed_types, __ATOMIC_RELAXED) & EVENT_BUS_MASK(event->type)))
+    {
+        __atomic_fetch_add(&event_bus_skipped, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    event->time_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+
+    if (xQueueSend(event_bus_queue, event, 0) != pdTRUE)
+    {
+        __atomic_fetch_add(&event_bus_dropped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    __atomic_fetch_add(&event_bus_published, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+void event_bus_get_stats(event_bus_stats_t *stats)
+{
+    stats->published = __atomic_load_n(&event_bus_published, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&event_bus_dropped, __ATOMIC_RELAXED);
+    stats->skipped = __atomic_load_n(&event_bus_skipped, __ATOMIC_RELAXED);
+    stats->delivered = __atomic_load_n(&event_bus_delivered, __ATOMIC_RELAXED);
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static void event_bus_task(void *pvParameters)
+{
+    event_bus_event_t event;
+    uint8_t count;
+    uint8_t i;
+
+    while (1)
+    {
+        if (xQueueReceive(event_bus_queue, &event, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        count = __atomic_load_n(&event_bus_subscribers_count, __ATOMIC_ACQUIRE);
+        for (i = 0; i < count; i++)
+        {
+            if (event_bus_subscribers[i].types & EVENT_BUS_MASK(event.type))
+            {
+                event_bus_subscribers[i].handler(event_bus_subscribers[i].ctx, &event);
+                __atomic_fetch_add(&event_bus_delivered, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
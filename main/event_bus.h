@@ -0,0 +1,121 @@
+/*
+ * System event bus.
+ *
+ * Subsystems publish small typed events (BLE and WiFi state, OTA,
+ * scripts, buttons) instead of writing shared globals. Every event is
+ * copied into a pool of fixed-size slots allocated once at init (a
+ * FreeRTOS queue), so publishing never allocates and is safe from any
+ * task. One dispatcher task hands each event to the subscribers of its
+ * type, in publishing order. Handlers run in that task: they must not
+ * block. Events of a type nobody subscribes to are skipped at publish
+ * time and never take a slot.
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "button_gesture.h"
+
+#define EVENT_BUS_POOL_SIZE 16      // events waiting for the dispatcher
+#define EVENT_BUS_MAX_SUBSCRIBERS 8
+
+    typedef enum
+    {
+        EVENT_BUS_BLE_STATE,
+        EVENT_BUS_WIFI_STATE,
+        EVENT_BUS_OTA,
+        EVENT_BUS_SCRIPT_STARTED,
+        EVENT_BUS_SCRIPT_FINISHED,
+        EVENT_BUS_INPUT,
+        EVENT_BUS_TYPES, // keep last
+    } event_bus_type_t;
+
+#define EVENT_BUS_MASK(type) (1UL << (type))
+#define EVENT_BUS_ALL ((1UL << EVENT_BUS_TYPES) - 1)
+
+    typedef enum
+    {
+        EVENT_BUS_WIFI_STARTING,      // the router is being configured
+        EVENT_BUS_WIFI_WAITING,       // looking for the upstream network
+        EVENT_BUS_WIFI_CONNECTED,     // got an IP from the upstream network
+        EVENT_BUS_WIFI_DISCONNECTED,  // no upstream network
+        EVENT_BUS_WIFI_STATION_JOINED, // a station connected to our AP
+        EVENT_BUS_WIFI_READY,         // setup done, the router is running
+    } event_bus_wifi_state_t;
+
+    typedef enum
+    {
+        EVENT_BUS_OTA_STARTED,
+        EVENT_BUS_OTA_FAILED,
+        EVENT_BUS_OTA_DONE, // the device is about to restart
+    } event_bus_ota_state_t;
+
+    typedef struct
+    {
+        event_bus_type_t type;
+        uint32_t time_ms; // set by event_bus_publish()
+        union
+        {
+            struct
+            {
+                bool connected; // this connection
+                uint16_t conn_id;
+                uint8_t connections; // centrals connected after this event
+            } ble;
+            struct
+            {
+                event_bus_wifi_state_t state;
+                uint16_t stations; // connected to our AP
+            } wifi;
+            struct
+            {
+                event_bus_ota_state_t state;
+                uint8_t percent;
+            } ota;
+            struct
+            {
+                uint16_t tag;   // see script_executor_submit()
+                uint8_t engine; // the one running it, 0..SCRIPT_EXECUTOR_MAX_RUNNING - 1
+                uint32_t reports_sent;
+                uint32_t duration_ms;
+            } script;
+            button_gesture_event_t input;
+        };
+    } event_bus_event_t;
+
+    typedef void (*event_bus_handler_t)(void *ctx, const event_bus_event_t *event);
+
+    typedef struct
+    {
+        uint32_t published;
+        uint32_t dropped; // pool full
+        uint32_t skipped; // no subscriber for the type
+        uint32_t delivered;
+    } event_bus_stats_t;
+
+    // Creates the pool and the dispatcher, before anything else publishes
+    void event_bus_init(void);
+
+    // 'types' is a mask of EVENT_BUS_MASK(), returns false if the table is full
+    bool event_bus_subscribe(uint32_t types, event_bus_handler_t handler, void *ctx);
+
+    // Copies the event in the pool, doesn't block (not from an ISR).
+    // Returns false if the pool is full and the event has been dropped,
+    // true if nobody subscribes to its type (nothing to deliver).
+    bool event_bus_publish(event_bus_event_t *event);
+
+    void event_bus_get_stats(event_bus_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_BUS_H */
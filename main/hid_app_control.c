@@ -33,171 +33,80 @@
 
 // LOCAL FUNCTIONS PROTOTYPES
 
-static void type_and_connect_meeting(void *pData);
-static void type_and_connect_meeting2(void *pData); // for testing
-static char *convert_ASCII_to_HID(char *string, uint8_t lenght);
-static void type_HID_text(char *string, uint8_t lenght, uint16_t hid_conn_id);
+static special_actions_return_codes_t type_and_connect_meeting(const app_control_special_args_t *args);
+static special_actions_return_codes_t type_and_connect_meeting2(const app_control_special_args_t *args); // for testing
 
 // GLOBAL VARIBLES
 
 // setting up zoom mobile's special scripts (only one for now)
-static app_control_special_script_t
+static const app_control_special_script_t
     zoom_mobile_special_scripts[ZOOM_CONTROL_MOBILE_SPECIAL_ACTIONS] =
         {
-            {.pfunction = (void *)type_and_connect_meeting,
-             .arg1 = (uint8_t *)MEETING1_ID,
-             .arg2 = (uint8_t *)MEETING1_PASSCODE},
-            {.pfunction = (void *)type_and_connect_meeting2,
-             .arg1 = (uint8_t *)MEETING1_ID,
-             .arg2 = (uint8_t *)MEETING1_PASSCODE}};
+            {.pfunction = type_and_connect_meeting,
+             .arg1 = MEETING1_ID,
+             .arg2 = MEETING1_PASSCODE},
+            {.pfunction = type_and_connect_meeting2,
+             .arg1 = MEETING1_ID,
+             .arg2 = MEETING1_PASSCODE}};
 
 //static app_control_special_script_t zoom_pc_special_scripts[ZOOM_CONTROL_PC_SPECIAL_ACTIONS];
 
 // registering the special scripts of zoom mobile only
-app_control_special_script_t *
-    app_control_special_actions[CONTROL_SCRIPTS_SPECIAL_ACTIONS_TOTAL] = {
-        (void *)&zoom_mobile_special_scripts, // zoom mobile
-                                              //(void *)&zoom_pc_special_scripts,     // zoom pc
+const app_control_special_script_t
+    *const app_control_special_actions[CONTROL_SCRIPTS_SPECIAL_ACTIONS_TOTAL] = {
+        zoom_mobile_special_scripts, // zoom mobile
+                                     //zoom_pc_special_scripts,     // zoom pc
 };
 
-// LOCAL FUNCTION DEFINITIONS
-// ALL THE FUNCTIONS MUST A HAVE A STATIC RETURN CODE DEFINED!
-
-static void type_and_connect_meeting(void *pData)
-{
-    static uint8_t returnCode = SPECIAL_ACTION_RETURN_CODE_OK; // MUST BE STATIC
-    app_control_special_script_t *received = (app_control_special_script_t *)pData;
-
-    uint16_t hid_id = (uint16_t)received->hid_conn_id;
-    // these two will be treated like matrixes! [char_code, shift_key_bit]
-    char *meeting_id = malloc(sizeof(char) * strlen((char *)received->arg1) * 2);
-    char *meeting_passcode = malloc(sizeof(char) * strlen((char *)received->arg2) * 2);
+const uint8_t app_control_special_actions_count[CONTROL_SCRIPTS_SETS] = {
+    [ZOOM_CONTROL_MOBILE_ID] = ZOOM_CONTROL_MOBILE_SPECIAL_ACTIONS,
+    [ZOOM_CONTROL_PC_ID] = ZOOM_CONTROL_PC_SPECIAL_ACTIONS,
+    [SKYPE_CONTROL_MOBILE_ID] = SKYPE_CONTROL_MOBILE_SPECIAL_ACTIONS,
+    [SKYPE_CONTROL_PC_ID] = SKYPE_CONTROL_PC_SPECIAL_ACTIONS,
+    [MEET_CONTROL_MOBILE_ID] = MEET_CONTROL_MOBILE_SPECIAL_ACTIONS,
+    [MEET_CONTROL_PC_ID] = MEET_CONTROL_PC_SPECIAL_ACTIONS,
+};
 
-    strcpy(meeting_id, (char *)received->arg1);
-    strcpy(meeting_passcode, (char *)received->arg2);
+const char *const app_control_strings[APP_CONTROL_STRINGS] = {
+    [APP_CONTROL_STRING_MEETING1_ID] = MEETING1_ID,
+    [APP_CONTROL_STRING_MEETING1_PASSCODE] = MEETING1_PASSCODE,
+};
 
-    type_HID_text(meeting_id, strlen((char *)received->arg1), hid_id);
-    printf("---------------------------\n");
-    type_HID_text(meeting_passcode, strlen((char *)received->arg2), hid_id);
+// LOCAL FUNCTION DEFINITIONS
+// The functions only get borrowed pointers and return their status, they
+// must not keep 'args' (or anything in it) after returning.
 
-    free(meeting_id);
-    free(meeting_passcode);
+static special_actions_return_codes_t type_and_connect_meeting(const app_control_special_args_t *args)
+{
+    // the text is typed by the engine in the background, right after
+    // this action returns (arg1 and arg2 are string literals)
+    if (!script_engine_type_text(args->engine, args->arg1, strlen(args->arg1)) ||
+        !script_engine_type_text(args->engine, args->arg2, strlen(args->arg2)))
+    {
+        printf("Can't queue the meeting id and passcode!\n");
+        return SPECIAL_ACTION_RETURN_CODE_FAIL;
+    }
 
-    received->returnCode = &returnCode;
+    return SPECIAL_ACTION_RETURN_CODE_OK;
 }
 
-static void type_and_connect_meeting2(void *pData)
+static special_actions_return_codes_t type_and_connect_meeting2(const app_control_special_args_t *args)
 {
-    static uint8_t returnCode = SPECIAL_ACTION_RETURN_CODE_OK; // MUST BE STATIC
-
-    app_control_special_script_t *received = (app_control_special_script_t *)pData;
-
-    char *meeting_id = (char *)received->arg1;
-    char *meeting_passcode = (char *)received->arg2;
-
-    printf("%s, %s\n", meeting_id, meeting_passcode);
+    printf("%s, %s\n", args->arg1, args->arg2);
     printf("DoSFDSDFSDFSne!\n");
 
-    received->returnCode = &returnCode;
+    return SPECIAL_ACTION_RETURN_CODE_OK;
 }
 
 // zoom pc special scripts functions
-static void send_keyboard_shortcut(void *pData)
+static special_actions_return_codes_t send_keyboard_shortcut(const app_control_special_args_t *args)
 {
-    app_control_special_script_t *received = (app_control_special_script_t *)pData;
-
-    command_code_t *hostScript = received->host_script;
+    const uint8_t *hostScript = args->host_script;
 
     bool special_code_found = false;
 
     // TODO: Must find out how to comunicate & interpret a shorcut's data
-}
-
-// general purpose functions used by special scripts
-// WARNING: string parameter is treated as a 2d array
-static void type_HID_text(char *string, uint8_t lenght, uint16_t hid_conn_id)
-{
-
-    char shift_key_prev = 0; // treated like a bool value
-    uint8_t index = 0;
-    uint8_t key_value = 0;
-    uint8_t key_mask = 0;
-
-    convert_ASCII_to_HID(string, lenght);
 
-    printf("%s || %d\n", string, lenght);
-
-    printf("Disabling caps lock..\n");
-    key_value = HID_KEY_CAPS_LOCK;
-    esp_hidd_send_keyboard_value(hid_conn_id, 0, &key_value, 0);
-
-    for (int i = 0; i < lenght; i++)
-    {
-
-        index = (1 * lenght) + i;
-
-        if (string[index])
-        {
-            if (!shift_key_prev)
-            { // must press shift
-                printf("SHIFT KEY PRESSED!\n");
-                key_mask = LEFT_SHIFT_KEY_MASK;
-                shift_key_prev = 1;
-            }
-            // leave as it is (with shift pressed)
-        }
-        else
-        {
-            if (shift_key_prev)
-            { // must release shift
-                printf("SHIFT KEY UNPRESSED!\n");
-                key_mask = 0x00;
-                shift_key_prev = 0;
-            }
-            // leave as it is (with shift unpressed)
-        }
-        index = (0 * lenght) + i;
-        printf("'Executing' this value: %d\n", string[index]);
-        key_value = string[index];
-        esp_hidd_send_keyboard_value(hid_conn_id, key_mask, &key_value, 1);
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-        esp_hidd_send_keyboard_value(hid_conn_id, key_mask, &key_value, 0);
-    }
+    return SPECIAL_ACTION_RETURN_CODE_FAIL;
 }
 
-// WARNING: string parameter is treated as a 2d array
-static char *convert_ASCII_to_HID(char *string, uint8_t lenght)
-{
-
-    // the function will treat the string array like a matrix
-    // with one dimension being 2 and the other being 'lenght'
-
-    uint8_t index = 0;
-
-    for (int i = 0; i < lenght; i++)
-    { // for each row..
-
-        index = (0 * lenght) + i; // (row_selected * cols_total) + col_selected
-
-        if ((string[index] >= 'a' && string[index] <= 'z') ||
-            (string[index] >= 'A' && string[index] <= 'Z'))
-        {
-            // shift key bits row first, so that we can check the char before it
-            // gets converted
-            string[(1 * lenght) + i] = (string[index] >= 'a') ? 0x00 : 0x01;
-            string[index] -= ((string[index] >= 'a') ? 0x5D : 0x3D);
-        }
-        else if (string[index] >= '0' && string[index] <= '9')
-        {
-            // writing on the second row
-            string[(1 * lenght) + i] = 0x00;
-            string[index] -= ((string[index] == '0') ? 0x09 : 0x13);
-        }
-        else
-        {
-            // There's a special character!
-        }
-    }
-
-    return string;
-}
\ No newline at end of file
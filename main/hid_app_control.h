@@ -25,22 +25,21 @@
  *    follow the scheme found in the other scripts definitions for the
  *    already present app controls
  * 
- * 9. INSIDE THE ble_hidd_demo_main.c FILE!
+ * 9. INSIDE THE app_control_scripts.c FILE!
  * 
- * 10. Define 'n' global variables for the app control imlementation (app_control_struct_t *)
- *     you can define them before the 'app_control_registered' array
- * 11. Add 'n' arrays of button-script relationships inside the 
+ * 10. Add 'n' tables of script steps and 'n' tables of rows (name and
+ *     steps of every script), then add 'n' entries to app_control_scripts
+ *     in the order of the IDs. app_control_init() registers them all
+ *     and the host tests compile the same table
+ * 
+ * 11. INSIDE THE ble_hidd_demo_main.c FILE!
+ * 
+ * 12. Add 'n' arrays of button-script relationships inside the 
  *     app_control_io_hardware_scripts 3d array
- * 12. Add 'n' RGB color codes in the app_control_rgb_codes array
- * 13. Add 'n' initializations of the global variables in step 10 inside the
- *     app_control_init function definition using the 'app_control_setup_new()'
- *     function. Remember to put all the correct parameters! See already
- *     present definitions for reference!
- * 14. Add 'n' initializations of 'app_control_registered' array elements 
- *     (mentioned id step 10) by following the correct indexing order after
- *     the already present initializations
+ * 13. Add 'n' RGB color codes in the app_control_rgb_codes array
+ *     and 'n' hosts in the app_control_hosts array
  * 
- * 15. Make a final check for all steps, and you should be ready to go :)
+ * 14. Make a final check for all steps, and you should be ready to go :)
  * 
  * ##########################################################################
  */
@@ -68,10 +67,13 @@ extern "C"
 #include <stdarg.h>
 
 #include "hid_dev.h"
+#include "app_script.h"
+#include "script_engine.h"
 
     // DEFINES
 
 #define CONTROL_SCRIPTS_MAX_SETS 10
+#define CONTROL_SCRIPTS_MAX_SCRIPTS 8 // max scripts for every app control
 #define CONTROL_SCRIPTS_SETS 6 // usually 2 for every app
 #define CONTROL_SCRIPTS_NUM_ATTRIBUTES 3
 
@@ -113,7 +115,41 @@ extern "C"
 
 #define ACTION_NONE 0
 #define ACTION_SPECIAL 232
+#define ACTION_CONSUMER 233
+    // presses and releases a consumer control key, 'usage' is one of HID_CONSUMER_*
+#define ACTION_CONSUMER_KEY(usage) ACTION_CONSUMER, (usage)
+    // PRESS and RELEASE don't wait after their report, the timing is up to
+    // WAIT. Keys still held when the script ends are released.
+#define ACTION_PRESS 234
+#define ACTION_PRESS_KEY(key) ACTION_PRESS, (key)
+#define ACTION_RELEASE 235
+#define ACTION_RELEASE_KEY(key) ACTION_RELEASE, (key)
+#define ACTION_RELEASE_ALL ACTION_RELEASE, APP_SCRIPT_KEY_ALL
+#define ACTION_WAIT 236
+    // 'ms' up to 65535
+#define ACTION_WAIT_MS(ms) ACTION_WAIT, ((ms)&0xFF), (((ms) >> 8) & 0xFF)
+#define ACTION_REPEAT 237
+    // runs the steps that follow, 'bytes' of them (operands count too),
+    // 'count' times; they can't contain another REPEAT
+#define ACTION_REPEAT_NEXT(count, bytes) ACTION_REPEAT, (count), (bytes)
+#define ACTION_JUMP_IF_LED 238
+    // skips the next 'bytes' steps if any of 'leds' (APP_SCRIPT_LED_*) is on at the host
+#define ACTION_JUMP_IF_LED_ON(leds, bytes) ACTION_JUMP_IF_LED, (leds), (bytes)
+#define ACTION_TYPE_STRING 239
+    // types app_control_strings[id]
+#define ACTION_TYPE_STRING_ID(id) ACTION_TYPE_STRING, (id)
 #define ACTION_COMBINE_KEYS_BASE_CODE 240
+#define ACTION_MOUSE_MOVE 250
+    // moves the pointer by dx, dy (-32767..32767) with a single report
+#define ACTION_MOUSE_MOVE_BY(dx, dy) ACTION_MOUSE_MOVE,           \
+                                     ((dx)&0xFF), (((dx) >> 8) & 0xFF), \
+                                     ((dy)&0xFF), (((dy) >> 8) & 0xFF)
+#define ACTION_TAP 251
+    // touches the screen at x%, y% (0..100, from the top left corner) and lifts the finger
+#define ACTION_TAP_AT(x, y) ACTION_TAP, (x), (y)
+#define ACTION_CALL 252
+    // runs the script 'id' of the same app control, then goes on
+#define ACTION_CALL_SCRIPT(id) ACTION_CALL, (id)
     // 'n' must not be higher than 9
 #define ACTION_COMBINE_NEXT_KEYS(n) ((n < 2 || n > 9)  \
                                          ? ACTION_NONE \
@@ -525,6 +561,14 @@ extern "C"
 #define MEETING1_ID "12345670"
 #define MEETING1_PASSCODE "coMeValavita"
 
+    // strings the scripts can type with ACTION_TYPE_STRING_ID()
+    typedef enum
+    {
+        APP_CONTROL_STRING_MEETING1_ID,
+        APP_CONTROL_STRING_MEETING1_PASSCODE,
+        APP_CONTROL_STRINGS, // keep last
+    } app_control_string_id_t;
+
     // TYPEDEFS
 
     typedef int command_code_t; // 'int' because of the use of the va_arg function
@@ -534,11 +578,28 @@ extern "C"
 
         uint8_t app_control_id;
         uint8_t num_of_scripts;
-        command_code_t **scripts;
         uint8_t scripts_max_steps;
+        // where every script starts inside the compiled image
+        uint16_t scripts_offset[CONTROL_SCRIPTS_MAX_SCRIPTS];
 
     } app_control_struct_t;
 
+    // A script of an app control: one padded row of steps, see the
+    // *_SCRIPT defines below
+    typedef struct
+    {
+        const char *name;            // e.g. "ZOOM_CONTROL_MOBILE_TOGGLE_MIC"
+        const command_code_t *steps; // max_steps_per_script + 1 codes
+    } app_control_script_row_t;
+
+    typedef struct
+    {
+        uint8_t app_control_id;
+        uint8_t num_of_scripts;
+        uint8_t max_steps_per_script;
+        const app_control_script_row_t *rows; // num_of_scripts rows
+    } app_control_scripts_t;
+
     typedef enum
     {
 
@@ -609,7 +670,6 @@ extern "C"
 
     typedef enum
     {
-        // These can be chained together in an array for extendend return codes
         SPECIAL_ACTION_RETURN_CODE_OK,
         SPECIAL_ACTION_RETURN_CODE_FAIL,
         SPECIAL_ACTION_RETURN_CODE_SKIP_NEXT,
@@ -619,26 +679,48 @@ extern "C"
 
     // VARIABLES
 
+    // What a special action gets when it's called. It lives on the stack
+    // of the caller and only borrows pointers, nothing to allocate or free.
     typedef struct
     {
-        void (*pfunction)(void *);
-        uint8_t *arg1;
-        uint8_t *arg2;
-        command_code_t *host_script; // script where the special script will be referred to
+        const char *arg1;
+        const char *arg2;
+        const uint8_t *host_script; // compiled script where the special script will be referred to
         uint16_t hid_conn_id;
-        uint8_t *returnCode; // can be an array, see 'special_actions_return_codes_t' enum
+        script_engine_t *engine; // engine running the host script, e.g. for typing text
+    } app_control_special_args_t;
+
+    typedef special_actions_return_codes_t (*app_control_special_function_t)(const app_control_special_args_t *args);
+
+    typedef struct
+    {
+        app_control_special_function_t pfunction;
+        const char *arg1; // string literals, handed to pfunction as they are
+        const char *arg2;
     } app_control_special_script_t;
 
+    // All the scripts of the registered app controls, compiled
+    extern app_script_image_t app_control_script_image;
+
+    // Indexed by app_control_string_id_t
+    extern const char *const app_control_strings[APP_CONTROL_STRINGS];
+
+    // The scripts of every app control, indexed by the *_CONTROL_*_ID
+    // (app_control_scripts.c, compiled by the host tests too)
+    extern const app_control_scripts_t app_control_scripts[CONTROL_SCRIPTS_SETS];
+
     // All apps special functions will be registered here
-    extern app_control_special_script_t
-        *app_control_special_actions[CONTROL_SCRIPTS_SPECIAL_ACTIONS_TOTAL];
+    extern const app_control_special_script_t
+        *const app_control_special_actions[CONTROL_SCRIPTS_SPECIAL_ACTIONS_TOTAL];
+
+    // Special actions registered for every app control (ACTION_SPECIAL
+    // indexes from 0 up to this count, excluded)
+    extern const uint8_t app_control_special_actions_count[CONTROL_SCRIPTS_SETS];
 
     // FUNCTION PROTOTYPES
     void app_control_init(app_control_struct_t **app_control_register);
 
-    app_control_struct_t *app_control_setup_new(uint8_t app_id,
-                                                uint8_t num_of_scripts,
-                                                uint8_t max_steps_per_script, ...);
+    app_control_struct_t *app_control_setup_new(const app_control_scripts_t *scripts);
 
     app_control_struct_t **app_control_register_new(uint8_t num_of_apps_registered, ...);
 
@@ -17,43 +17,274 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 #include "esp_log.h"
 
+// A report waiting for the controller
+typedef struct {
+    uint16_t handle;
+    uint8_t  length;
+    bool     deferred;      // already counted in hid_dev_tx_stats.retried
+    uint8_t  data[HID_DEV_TX_REPORT_LEN];
+} hid_dev_tx_report_t;
+
+// Reports of a connection, sent in order. A report goes out at once if
+// the link has TX credits and isn't congested, otherwise it waits for
+// the end of the congestion or for the retry timer.
+typedef struct {
+    bool          in_use;
+    bool          congested;
+    uint16_t      conn_id;
+    esp_gatt_if_t gatts_if;
+    uint8_t       head;
+    uint8_t       count;
+    hid_dev_tx_report_t reports[HID_DEV_TX_QUEUE_LEN];
+    // last input report accepted for every report id, repeats are skipped
+    uint8_t       last_length[HID_DEV_MAX_REPORT_ID + 1];
+    uint8_t       last_data[HID_DEV_MAX_REPORT_ID + 1][HID_DEV_TX_REPORT_LEN];
+} hid_dev_tx_queue_t;
+
+// the queues are used by the sender (the script executor), the BTC task
+// on (dis)connection and congestion, and the retry timer
+static hid_dev_tx_queue_t hid_dev_tx_queues[HID_MAX_APPS];
+static hid_dev_tx_stats_t hid_dev_tx_stats;
+static SemaphoreHandle_t hid_dev_tx_lock = NULL;
+static esp_timer_handle_t hid_dev_tx_timer = NULL;
+
 static hid_report_map_t *hid_dev_rpt_tbl;
 static uint8_t hid_dev_rpt_tbl_Len;
 
-static hid_report_map_t *hid_dev_rpt_by_id(uint8_t id, uint8_t type)
+// Attribute handle of every (report id, type) in each protocol mode, 0 if
+// there is no such report. Resolved from hid_dev_rpt_tbl when the reports
+// are registered, so sending a report only has to pick the table of the
+// connection's protocol mode.
+static uint16_t hid_dev_rpt_handles[HID_PROTOCOL_MODE_REPORT + 1][HID_DEV_MAX_REPORT_ID + 1][HID_TYPE_FEATURE];
+
+static void hid_dev_resolve_reports(void)
 {
     hid_report_map_t *rpt = hid_dev_rpt_tbl;
 
+    memset(hid_dev_rpt_handles, 0, sizeof(hid_dev_rpt_handles));
+
     for (uint8_t i = hid_dev_rpt_tbl_Len; i > 0; i--, rpt++) {
-        if (rpt->id == id && rpt->type == type && rpt->mode == hidProtocolMode) {
-            return rpt;
+        if (rpt->mode != HID_PROTOCOL_MODE_BOOT && rpt->mode != HID_PROTOCOL_MODE_REPORT) {
+            continue;
+        }
+        if (rpt->id > HID_DEV_MAX_REPORT_ID || rpt->type < HID_TYPE_INPUT || rpt->type > HID_TYPE_FEATURE) {
+            ESP_LOGE(HID_LE_PRF_TAG, "%s(), report id %d type %d can't be cached", __func__, rpt->id, rpt->type);
+            continue;
+        }
+        // the first match wins, as the table search did
+        if (hid_dev_rpt_handles[rpt->mode][rpt->id][rpt->type - 1] == 0) {
+            hid_dev_rpt_handles[rpt->mode][rpt->id][rpt->type - 1] = rpt->handle;
         }
     }
-
-    return NULL;
 }
 
 void hid_dev_register_reports(uint8_t num_reports, hid_report_map_t *p_report)
 {
     hid_dev_rpt_tbl = p_report;
     hid_dev_rpt_tbl_Len = num_reports;
+    hid_dev_resolve_reports();
     return;
 }
 
+void hid_dev_set_protocol_mode(uint16_t conn_id, uint8_t mode)
+{
+    hidd_clcb_t *p_clcb = hidd_clcb_find(conn_id);
+
+    if (p_clcb == NULL || (mode != HID_PROTOCOL_MODE_BOOT && mode != HID_PROTOCOL_MODE_REPORT)) {
+        return;
+    }
+
+    // read by the senders without the BTC task
+    __atomic_store_n(&p_clcb->proto_mode, mode, __ATOMIC_RELAXED);
+}
+
+uint8_t hid_dev_get_protocol_mode(uint16_t conn_id)
+{
+    hidd_clcb_t *p_clcb = hidd_clcb_find(conn_id);
+
+    return (p_clcb != NULL) ? __atomic_load_n(&p_clcb->proto_mode, __ATOMIC_RELAXED) : HID_PROTOCOL_MODE_REPORT;
+}
+
+static hid_dev_tx_queue_t *hid_dev_tx_find(uint16_t conn_id)
+{
+    for (uint8_t i = 0; i < HID_MAX_APPS; i++) {
+        if (hid_dev_tx_queues[i].in_use && hid_dev_tx_queues[i].conn_id == conn_id) {
+            return &hid_dev_tx_queues[i];
+        }
+    }
+    return NULL;
+}
+
+// Keyboard and consumer reports carry the whole state of the keys, sending
+// the same one twice does nothing. Mouse reports carry relative motion,
+// only the ones without motion are states.
+static bool hid_dev_tx_is_repeat(hid_dev_tx_queue_t *queue, uint8_t id, uint8_t length, const uint8_t *data)
+{
+    if (id == HID_RPT_ID_MOUSE_IN) {
+        for (uint8_t i = 1; i < length; i++) {
+            if (data[i] != 0) {
+                return false;
+            }
+        }
+    }
+
+    return queue->last_length[id] == length && memcmp(queue->last_data[id], data, length) == 0;
+}
+
+// Sends the queued reports while the link takes them, with the lock held
+static void hid_dev_tx_flush(hid_dev_tx_queue_t *queue)
+{
+    hid_dev_tx_report_t *report;
+    uint16_t credits = 0;
+
+    if (!queue->congested) {
+        credits = esp_ble_get_cur_sendable_packets_num(queue->conn_id);
+    }
+
+    while (queue->count > 0) {
+        report = &queue->reports[queue->head];
+
+        if (credits == 0 ||
+            esp_ble_gatts_send_indicate(queue->gatts_if, queue->conn_id, report->handle,
+                                        report->length, report->data, false) != ESP_OK) {
+            if (!report->deferred) {
+                report->deferred = true;
+                hid_dev_tx_stats.retried++;
+            }
+            // fails harmlessly if it's already running
+            esp_timer_start_once(hid_dev_tx_timer, HID_DEV_TX_RETRY_MS * 1000);
+            return;
+        }
+
+        credits--;
+        hid_dev_tx_stats.sent++;
+        queue->head = (queue->head + 1) % HID_DEV_TX_QUEUE_LEN;
+        queue->count--;
+    }
+}
+
+static void hid_dev_tx_retry(void *arg)
+{
+    xSemaphoreTake(hid_dev_tx_lock, portMAX_DELAY);
+    for (uint8_t i = 0; i < HID_MAX_APPS; i++) {
+        if (hid_dev_tx_queues[i].in_use) {
+            hid_dev_tx_flush(&hid_dev_tx_queues[i]);
+        }
+    }
+    xSemaphoreGive(hid_dev_tx_lock);
+}
+
+void hid_dev_tx_init(void)
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback = hid_dev_tx_retry,
+        .name = "hid_tx_retry",
+    };
+
+    if (hid_dev_tx_lock != NULL) {
+        return;
+    }
+
+    hid_dev_tx_lock = xSemaphoreCreateMutex();
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &hid_dev_tx_timer));
+}
+
+void hid_dev_tx_open(uint16_t conn_id)
+{
+    xSemaphoreTake(hid_dev_tx_lock, portMAX_DELAY);
+    for (uint8_t i = 0; i < HID_MAX_APPS; i++) {
+        if (!hid_dev_tx_queues[i].in_use) {
+            memset(&hid_dev_tx_queues[i], 0, sizeof(hid_dev_tx_queue_t));
+            hid_dev_tx_queues[i].in_use = true;
+            hid_dev_tx_queues[i].conn_id = conn_id;
+            break;
+        }
+    }
+    xSemaphoreGive(hid_dev_tx_lock);
+}
+
+void hid_dev_tx_close(uint16_t conn_id)
+{
+    hid_dev_tx_queue_t *queue;
+
+    xSemaphoreTake(hid_dev_tx_lock, portMAX_DELAY);
+    if ((queue = hid_dev_tx_find(conn_id)) != NULL) {
+        hid_dev_tx_stats.dropped += queue->count;
+        queue->in_use = false;
+    }
+    xSemaphoreGive(hid_dev_tx_lock);
+}
+
+void hid_dev_tx_set_congested(uint16_t conn_id, bool congested)
+{
+    hid_dev_tx_queue_t *queue;
+
+    xSemaphoreTake(hid_dev_tx_lock, portMAX_DELAY);
+    if ((queue = hid_dev_tx_find(conn_id)) != NULL) {
+        queue->congested = congested;
+        if (!congested) {
+            hid_dev_tx_flush(queue);
+        }
+    }
+    xSemaphoreGive(hid_dev_tx_lock);
+}
+
+void hid_dev_get_tx_stats(hid_dev_tx_stats_t *stats)
+{
+    xSemaphoreTake(hid_dev_tx_lock, portMAX_DELAY);
+    *stats = hid_dev_tx_stats;
+    xSemaphoreGive(hid_dev_tx_lock);
+}
+
 void hid_dev_send_report(esp_gatt_if_t gatts_if, uint16_t conn_id,
                                     uint8_t id, uint8_t type, uint8_t length, uint8_t *data)
 {
-    hid_report_map_t *p_rpt;
+    hid_dev_tx_queue_t *queue;
+    hid_dev_tx_report_t *report;
+    uint16_t handle;
 
-    // get att handle for report
-    if ((p_rpt = hid_dev_rpt_by_id(id, type)) != NULL) {
-        // if notifications are enabled
-        ESP_LOGD(HID_LE_PRF_TAG, "%s(), send the report, handle = %d", __func__, p_rpt->handle);
-        esp_ble_gatts_send_indicate(gatts_if, conn_id, p_rpt->handle, length, data, false);
+    if (id > HID_DEV_MAX_REPORT_ID || type < HID_TYPE_INPUT || type > HID_TYPE_FEATURE ||
+        length > HID_DEV_TX_REPORT_LEN || hid_dev_tx_lock == NULL) {
+        return;
     }
-    
+
+    // get att handle for report, in the protocol mode of this host
+    handle = hid_dev_rpt_handles[hid_dev_get_protocol_mode(conn_id)][id][type - 1];
+    if (handle == 0) {
+        return;
+    }
+
+    xSemaphoreTake(hid_dev_tx_lock, portMAX_DELAY);
+
+    queue = hid_dev_tx_find(conn_id);
+    if (queue == NULL || queue->count == HID_DEV_TX_QUEUE_LEN) {
+        hid_dev_tx_stats.dropped++;
+    } else if (type == HID_TYPE_INPUT && hid_dev_tx_is_repeat(queue, id, length, data)) {
+        hid_dev_tx_stats.coalesced++;
+    } else {
+        ESP_LOGD(HID_LE_PRF_TAG, "%s(), queue the report, handle = %d", __func__, handle);
+        report = &queue->reports[(queue->head + queue->count) % HID_DEV_TX_QUEUE_LEN];
+        report->handle = handle;
+        report->length = length;
+        report->deferred = false;
+        memcpy(report->data, data, length);
+        queue->count++;
+        queue->gatts_if = gatts_if;
+
+        if (type == HID_TYPE_INPUT) {
+            queue->last_length[id] = length;
+            memcpy(queue->last_data[id], data, length);
+        }
+
+        hid_dev_tx_flush(queue);
+    }
+
+    xSemaphoreGive(hid_dev_tx_lock);
     return;
 }
 
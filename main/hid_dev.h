@@ -27,6 +27,15 @@ extern "C" {
 #define HID_TYPE_OUTPUT      2
 #define HID_TYPE_FEATURE     3
 
+// Highest report ID hid_dev_send_report() can send
+#define HID_DEV_MAX_REPORT_ID 7
+
+// Reports queued per connection while the link is congested or out of
+// TX credits, and how often the queues are flushed again meanwhile
+#define HID_DEV_TX_QUEUE_LEN  16
+#define HID_DEV_TX_REPORT_LEN 8    // the longest report (keyboard input)
+#define HID_DEV_TX_RETRY_MS   5
+
 // HID Keyboard/Keypad Usage IDs (subset of the codes available in the USB HID Usage Tables spec)
 #define HID_KEY_RESERVED       0    // No event inidicated
 #define HID_KEY_A              4    // Keyboard a and A
@@ -241,8 +250,35 @@ typedef struct
 
 } hid_dev_cfg_t;
 
+// Counters of the report TX queues
+typedef struct
+{
+  uint32_t    sent;
+  uint32_t    coalesced;        // input reports equal to the previous one, not sent
+  uint32_t    retried;          // reports that couldn't go out at the first attempt
+  uint32_t    dropped;          // queue full, no connection or connection lost
+} hid_dev_tx_stats_t;
+
 void hid_dev_register_reports(uint8_t num_reports, hid_report_map_t *p_report);
 
+// Called when a host writes the Protocol Mode characteristic, every
+// connection has its own (report mode from the connection on)
+void hid_dev_set_protocol_mode(uint16_t conn_id, uint8_t mode);
+
+// HID_PROTOCOL_MODE_* of the connection, report mode if unknown
+uint8_t hid_dev_get_protocol_mode(uint16_t conn_id);
+
+// Report TX queues: created once, then one per connection
+void hid_dev_tx_init(void);
+void hid_dev_tx_open(uint16_t conn_id);
+void hid_dev_tx_close(uint16_t conn_id);
+
+// From ESP_GATTS_CONGEST_EVT, the queue is flushed when the congestion ends
+void hid_dev_tx_set_congested(uint16_t conn_id, bool congested);
+
+void hid_dev_get_tx_stats(hid_dev_tx_stats_t *stats);
+
+// Queues the report and sends it as soon as the link takes it, doesn't block
 void hid_dev_send_report(esp_gatt_if_t gatts_if, uint16_t conn_id,
                                     uint8_t id, uint8_t type, uint8_t length, uint8_t *data);
 
@@ -45,24 +45,33 @@ static const uint8_t hidReportMap[] = {
     0xA1, 0x00,  //   Collection (Physical)
     0x05, 0x09,  //     Usage Page (Buttons)
     0x19, 0x01,  //     Usage Minimum (01) - Button 1
-    0x29, 0x03,  //     Usage Maximum (03) - Button 3
+    0x29, 0x05,  //     Usage Maximum (05) - Button 5
     0x15, 0x00,  //     Logical Minimum (0)
     0x25, 0x01,  //     Logical Maximum (1)
     0x75, 0x01,  //     Report Size (1)
-    0x95, 0x03,  //     Report Count (3)
+    0x95, 0x05,  //     Report Count (5)
     0x81, 0x02,  //     Input (Data, Variable, Absolute) - Button states
-    0x75, 0x05,  //     Report Size (5)
+    0x75, 0x03,  //     Report Size (3)
     0x95, 0x01,  //     Report Count (1)
     0x81, 0x01,  //     Input (Constant) - Padding or Reserved bits
     0x05, 0x01,  //     Usage Page (Generic Desktop)
     0x09, 0x30,  //     Usage (X)
     0x09, 0x31,  //     Usage (Y)
+    0x16, 0x01, 0x80, //    Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F, //    Logical Maximum (32767)
+    0x75, 0x10,  //     Report Size (16)
+    0x95, 0x02,  //     Report Count (2)
+    0x81, 0x06,  //     Input (Data, Variable, Relative) - X & Y coordinate
     0x09, 0x38,  //     Usage (Wheel)
     0x15, 0x81,  //     Logical Minimum (-127)
     0x25, 0x7F,  //     Logical Maximum (127)
     0x75, 0x08,  //     Report Size (8)
-    0x95, 0x03,  //     Report Count (3)
-    0x81, 0x06,  //     Input (Data, Variable, Relative) - X & Y coordinate
+    0x95, 0x01,  //     Report Count (1)
+    0x81, 0x06,  //     Input (Data, Variable, Relative) - Wheel
+    0x05, 0x0C,  //     Usage Page (Consumer Devices)
+    0x0A, 0x38, 0x02, //    Usage (AC Pan)
+    0x95, 0x01,  //     Report Count (1)
+    0x81, 0x06,  //     Input (Data, Variable, Relative) - Horizontal scroll
     0xC0,        //   End Collection
     0xC0,        // End Collection
 
@@ -170,6 +179,31 @@ static const uint8_t hidReportMap[] = {
     0x81, 0x03,   //   Input (Const, Var, Abs)
     0xC0,            // End Collectionq
 
+    0x05, 0x0D,  // Usage Page (Digitizer)
+    0x09, 0x04,  // Usage (Touch Screen)
+    0xA1, 0x01,  // Collection (Application)
+    0x85, 0x05,  // Report Id (5)
+    0x09, 0x22,  //   Usage (Finger)
+    0xA1, 0x02,  //   Collection (Logical)
+    0x09, 0x42,  //     Usage (Tip Switch)
+    0x09, 0x32,  //     Usage (In Range)
+    0x15, 0x00,  //     Logical Minimum (0)
+    0x25, 0x01,  //     Logical Maximum (1)
+    0x75, 0x01,  //     Report Size (1)
+    0x95, 0x02,  //     Report Count (2)
+    0x81, 0x02,  //     Input (Data, Variable, Absolute) - Touching, in range
+    0x95, 0x06,  //     Report Count (6)
+    0x81, 0x03,  //     Input (Constant) - Padding
+    0x05, 0x01,  //     Usage Page (Generic Desktop)
+    0x09, 0x30,  //     Usage (X)
+    0x09, 0x31,  //     Usage (Y)
+    0x26, 0x10, 0x27, //    Logical Maximum (10000) - 0.01% of the screen
+    0x75, 0x10,  //     Report Size (16)
+    0x95, 0x02,  //     Report Count (2)
+    0x81, 0x02,  //     Input (Data, Variable, Absolute) - X & Y position
+    0xC0,        //   End Collection
+    0xC0,        // End Collection
+
 #if (SUPPORT_REPORT_VENDOR == true)
     0x06, 0xFF, 0xFF, // Usage Page(Vendor defined)
     0x09, 0xA5,       // Usage(Vendor Defined)
@@ -213,8 +247,10 @@ struct gatts_profile_inst {
 hidd_le_env_t hidd_le_env;
 
 // HID report map length
-uint8_t hidReportMapLen = sizeof(hidReportMap);
-uint8_t hidProtocolMode = HID_PROTOCOL_MODE_REPORT;
+uint16_t hidReportMapLen = sizeof(hidReportMap);
+// Protocol Mode characteristic: every connection has its own (hidd_clcb_t),
+// this is only the value the attribute is created with
+static const uint8_t hidDefaultProtocolMode = HID_PROTOCOL_MODE_REPORT;
 
 // HID report mapping table
 //static hidRptMap_t  hidRptMap[HID_NUM_REPORTS];
@@ -257,6 +293,10 @@ static uint8_t hidReportRefFeature[HID_REPORT_REF_LEN] =
 static uint8_t hidReportRefCCIn[HID_REPORT_REF_LEN] =
              { HID_RPT_ID_CC_IN, HID_REPORT_TYPE_INPUT };
 
+// HID Report Reference characteristic descriptor, touch screen input
+static uint8_t hidReportRefTouchIn[HID_REPORT_REF_LEN] =
+             { HID_RPT_ID_TOUCH_IN, HID_REPORT_TYPE_INPUT };
+
 
 /*
  *  Heart Rate PROFILE ATTRIBUTES
@@ -384,10 +424,10 @@ static esp_gatts_attr_db_t hidd_le_gatt_db[HIDD_LE_IDX_NB] =
                                                                         CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE,
                                                                         (uint8_t *)&char_prop_read_write}},
     // Protocol Mode Characteristic Value
-    [HIDD_LE_IDX_PROTO_MODE_VAL]               = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&hid_proto_mode_uuid,
+    [HIDD_LE_IDX_PROTO_MODE_VAL]               = {{ESP_GATT_RSP_BY_APP}, {ESP_UUID_LEN_16, (uint8_t *)&hid_proto_mode_uuid,
                                                                         (ESP_GATT_PERM_READ|ESP_GATT_PERM_WRITE),
-                                                                        sizeof(uint8_t), sizeof(hidProtocolMode),
-                                                                        (uint8_t *)&hidProtocolMode}},
+                                                                        sizeof(uint8_t), sizeof(hidDefaultProtocolMode),
+                                                                        (uint8_t *)&hidDefaultProtocolMode}},
 
     [HIDD_LE_IDX_REPORT_MOUSE_IN_CHAR]       = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid,
                                                                          ESP_GATT_PERM_READ,
@@ -479,6 +519,27 @@ static esp_gatts_attr_db_t hidd_le_gatt_db[HIDD_LE_IDX_NB] =
                                                                        sizeof(hidReportRefCCIn), sizeof(hidReportRefCCIn),
                                                                        hidReportRefCCIn}},
 
+    // Report Characteristic Declaration
+    [HIDD_LE_IDX_REPORT_TOUCH_IN_CHAR]      = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid,
+                                                                         ESP_GATT_PERM_READ,
+                                                                         CHAR_DECLARATION_SIZE, CHAR_DECLARATION_SIZE,
+                                                                         (uint8_t *)&char_prop_read_notify}},
+    // Report Characteristic Value
+    [HIDD_LE_IDX_REPORT_TOUCH_IN_VAL]         = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&hid_report_uuid,
+                                                                       ESP_GATT_PERM_READ,
+                                                                       HIDD_LE_REPORT_MAX_LEN, 0,
+                                                                       NULL}},
+    // Report TOUCH INPUT Characteristic - Client Characteristic Configuration Descriptor
+    [HIDD_LE_IDX_REPORT_TOUCH_IN_CCC]         = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_client_config_uuid,
+                                                                      (ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE_ENCRYPTED),
+                                                                      sizeof(uint16_t), 0,
+                                                                      NULL}},
+    // Report Characteristic - Report Reference Descriptor
+    [HIDD_LE_IDX_REPORT_TOUCH_IN_REP_REF]     = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&hid_report_ref_descr_uuid,
+                                                                       ESP_GATT_PERM_READ,
+                                                                       sizeof(hidReportRefTouchIn), sizeof(hidReportRefTouchIn),
+                                                                       hidReportRefTouchIn}},
+
     // Boot Keyboard Input Report Characteristic Declaration
     [HIDD_LE_IDX_BOOT_KB_IN_REPORT_CHAR] = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_declaration_uuid,
                                                                         ESP_GATT_PERM_READ,
@@ -576,7 +637,13 @@ void esp_hidd_prf_cb_hdl(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
 			ESP_LOGI(HID_LE_PRF_TAG, "HID connection establish, conn_id = %x",param->connect.conn_id);
 			memcpy(cb_param.connect.remote_bda, param->connect.remote_bda, sizeof(esp_bd_addr_t));
             cb_param.connect.conn_id = param->connect.conn_id;
-            hidd_clcb_alloc(param->connect.conn_id, param->connect.remote_bda);
+            if (!hidd_clcb_alloc(param->connect.conn_id, param->connect.remote_bda)) {
+                // the controller allows more links than we serve
+                ESP_LOGW(HID_LE_PRF_TAG, "no free connection link, closing conn_id = %x", param->connect.conn_id);
+                esp_ble_gatts_close(gatts_if, param->connect.conn_id);
+                break;
+            }
+            hid_dev_tx_open(param->connect.conn_id);
             esp_ble_set_encryption(param->connect.remote_bda, ESP_BLE_SEC_ENCRYPT_NO_MITM);
             if(hidd_le_env.hidd_cb != NULL) {
                 (hidd_le_env.hidd_cb)(ESP_HIDD_EVENT_BLE_CONNECT, &cb_param);
@@ -584,15 +651,64 @@ void esp_hidd_prf_cb_hdl(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
             break;
         }
         case ESP_GATTS_DISCONNECT_EVT: {
-			 if(hidd_le_env.hidd_cb != NULL) {
-                    (hidd_le_env.hidd_cb)(ESP_HIDD_EVENT_BLE_DISCONNECT, NULL);
-             }
-            hidd_clcb_dealloc(param->disconnect.conn_id);
+            esp_hidd_cb_param_t cb_param = {0};
+            // a link we refused at connection has nothing to report
+            if (!hidd_clcb_dealloc(param->disconnect.conn_id)) {
+                break;
+            }
+            hid_dev_tx_close(param->disconnect.conn_id);
+            cb_param.disconnect.conn_id = param->disconnect.conn_id;
+            memcpy(cb_param.disconnect.remote_bda, param->disconnect.remote_bda, sizeof(esp_bd_addr_t));
+            cb_param.disconnect.reason = param->disconnect.reason;
+            if(hidd_le_env.hidd_cb != NULL) {
+                (hidd_le_env.hidd_cb)(ESP_HIDD_EVENT_BLE_DISCONNECT, &cb_param);
+            }
             break;
         }
         case ESP_GATTS_CLOSE_EVT:
             break;
+        case ESP_GATTS_CONGEST_EVT:
+            hid_dev_tx_set_congested(param->congest.conn_id, param->congest.congested);
+            break;
+        case ESP_GATTS_READ_EVT: {
+            // the Protocol Mode is answered here, from the connection reading it
+            if (param->read.handle == hidd_le_env.hidd_inst.att_tbl[HIDD_LE_IDX_PROTO_MODE_VAL] &&
+                param->read.need_rsp) {
+                esp_gatt_rsp_t rsp = {0};
+                rsp.attr_value.handle = param->read.handle;
+                rsp.attr_value.len = HID_PROTOCOL_MODE_LEN;
+                rsp.attr_value.value[0] = hid_dev_get_protocol_mode(param->read.conn_id);
+                esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id,
+                                            ESP_GATT_OK, &rsp);
+            }
+            break;
+        }
         case ESP_GATTS_WRITE_EVT: {
+            if (param->write.handle == hidd_le_env.hidd_inst.att_tbl[HIDD_LE_IDX_PROTO_MODE_VAL]) {
+                if (param->write.len == HID_PROTOCOL_MODE_LEN) {
+                    hid_dev_set_protocol_mode(param->write.conn_id, param->write.value[0]);
+                }
+                if (param->write.need_rsp) {
+                    esp_ble_gatts_send_response(gatts_if, param->write.conn_id, param->write.trans_id,
+                                                (param->write.len == HID_PROTOCOL_MODE_LEN) ?
+                                                ESP_GATT_OK : ESP_GATT_INVALID_ATTR_LEN, NULL);
+                }
+            }
+            // the host keyboard LEDs, in report or boot protocol mode
+            if ((param->write.handle == hidd_le_env.hidd_inst.att_tbl[HIDD_LE_IDX_REPORT_LED_OUT_VAL] ||
+                 param->write.handle == hidd_le_env.hidd_inst.att_tbl[HIDD_LE_IDX_BOOT_KB_OUT_REPORT_VAL]) &&
+                param->write.len >= HID_LED_OUT_RPT_LEN && !param->write.is_prep) {
+                hidd_clcb_t *p_clcb = hidd_clcb_find(param->write.conn_id);
+                if (p_clcb != NULL) {
+                    __atomic_store_n(&p_clcb->leds, param->write.value[0], __ATOMIC_RELAXED);
+                    if (hidd_le_env.hidd_cb != NULL) {
+                        esp_hidd_cb_param_t led_param = {0};
+                        led_param.led_write.conn_id = param->write.conn_id;
+                        led_param.led_write.leds = param->write.value[0];
+                        (hidd_le_env.hidd_cb)(ESP_HIDD_EVENT_BLE_LED_REPORT_WRITE_EVT, &led_param);
+                    }
+                }
+            }
 #if (SUPPORT_REPORT_VENDOR == true)
             esp_hidd_cb_param_t cb_param = {0};
             if (param->write.handle == hidd_le_env.hidd_inst.att_tbl[HIDD_LE_IDX_REPORT_VENDOR_OUT_VAL] &&
@@ -649,7 +765,7 @@ void hidd_le_init(void)
     memset(&hidd_le_env, 0, sizeof(hidd_le_env_t));
 }
 
-void hidd_clcb_alloc (uint16_t conn_id, esp_bd_addr_t bda)
+bool hidd_clcb_alloc (uint16_t conn_id, esp_bd_addr_t bda)
 {
     uint8_t                   i_clcb = 0;
     hidd_clcb_t      *p_clcb = NULL;
@@ -659,11 +775,13 @@ void hidd_clcb_alloc (uint16_t conn_id, esp_bd_addr_t bda)
             p_clcb->in_use      = true;
             p_clcb->conn_id     = conn_id;
             p_clcb->connected   = true;
+            p_clcb->leds        = 0;
+            p_clcb->proto_mode  = HID_PROTOCOL_MODE_REPORT;  // until the host selects the boot one
             memcpy (p_clcb->remote_bda, bda, ESP_BD_ADDR_LEN);
-            break;
+            return true;
         }
     }
-    return;
+    return false;
 }
 
 bool hidd_clcb_dealloc (uint16_t conn_id)
@@ -672,13 +790,26 @@ bool hidd_clcb_dealloc (uint16_t conn_id)
     hidd_clcb_t      *p_clcb = NULL;
 
     for (i_clcb = 0, p_clcb= hidd_le_env.hidd_clcb; i_clcb < HID_MAX_APPS; i_clcb++, p_clcb++) {
+        if (p_clcb->in_use && p_clcb->conn_id == conn_id) {
             memset(p_clcb, 0, sizeof(hidd_clcb_t));
             return true;
+        }
     }
 
     return false;
 }
 
+hidd_clcb_t *hidd_clcb_find (uint16_t conn_id)
+{
+    for (uint8_t i_clcb = 0; i_clcb < HID_MAX_APPS; i_clcb++) {
+        if (hidd_le_env.hidd_clcb[i_clcb].in_use && hidd_le_env.hidd_clcb[i_clcb].conn_id == conn_id) {
+            return &hidd_le_env.hidd_clcb[i_clcb];
+        }
+    }
+
+    return NULL;
+}
+
 static struct gatts_profile_inst heart_rate_profile_tab[PROFILE_NUM] = {
     [PROFILE_APP_IDX] = {
         .gatts_cb = esp_hidd_prf_cb_hdl,
@@ -809,6 +940,13 @@ static void hid_add_id_tbl(void)
       hid_rpt_map[7].cccdHandle = 0;
       hid_rpt_map[7].mode = HID_PROTOCOL_MODE_REPORT;
 
+      // Touch screen input report, report protocol only
+      hid_rpt_map[8].id = hidReportRefTouchIn[0];
+      hid_rpt_map[8].type = hidReportRefTouchIn[1];
+      hid_rpt_map[8].handle = hidd_le_env.hidd_inst.att_tbl[HIDD_LE_IDX_REPORT_TOUCH_IN_VAL];
+      hid_rpt_map[8].cccdHandle = hidd_le_env.hidd_inst.att_tbl[HIDD_LE_IDX_REPORT_TOUCH_IN_CCC];
+      hid_rpt_map[8].mode = HID_PROTOCOL_MODE_REPORT;
+
 
   // Setup report ID map
   hid_dev_register_reports(HID_NUM_REPORTS, hid_rpt_map);
@@ -0,0 +1,382 @@
+/*
+ * ASCII to HID keyboard usage translation, see hid_keymap.h
+ */
+
+#include <string.h>
+
+#include "hid_keymap.h"
+
+#define KEY(usage) {(usage), 0}
+#define SHIFT(usage) {(usage), HID_KEYMAP_SHIFT}
+#define ALTGR(usage) {(usage), HID_KEYMAP_ALTGR}
+#define ALTGR_SHIFT(usage) {(usage), HID_KEYMAP_ALTGR | HID_KEYMAP_SHIFT}
+
+// Characters missing from a table are dead keys or aren't on that
+// layout at all ('`' and '~' on IT, '^' and '`' on DE).
+// Usage 0x32 is the ISO key next to Enter, 0x64 the one next to left Shift.
+
+static const hid_keymap_entry_t hid_keymap_us[HID_KEYMAP_ASCII_SIZE] = {
+    ['\b'] = KEY(0x2A),
+    ['\t'] = KEY(0x2B),
+    ['\n'] = KEY(0x28),
+    [' '] = KEY(0x2C),
+    ['!'] = SHIFT(0x1E),
+    ['"'] = SHIFT(0x34),
+    ['#'] = SHIFT(0x20),
+    ['$'] = SHIFT(0x21),
+    ['%'] = SHIFT(0x22),
+    ['&'] = SHIFT(0x24),
+    ['\''] = KEY(0x34),
+    ['('] = SHIFT(0x26),
+    [')'] = SHIFT(0x27),
+    ['*'] = SHIFT(0x25),
+    ['+'] = SHIFT(0x2E),
+    [','] = KEY(0x36),
+    ['-'] = KEY(0x2D),
+    ['.'] = KEY(0x37),
+    ['/'] = KEY(0x38),
+    ['0'] = KEY(0x27),
+    ['1'] = KEY(0x1E),
+    ['2'] = KEY(0x1F),
+    ['3'] = KEY(0x20),
+    ['4'] = KEY(0x21),
+    ['5'] = KEY(0x22),
+    ['6'] = KEY(0x23),
+    ['7'] = KEY(0x24),
+    ['8'] = KEY(0x25),
+    ['9'] = KEY(0x26),
+    [':'] = SHIFT(0x33),
+    [';'] = KEY(0x33),
+    ['<'] = SHIFT(0x36),
+    ['='] = KEY(0x2E),
+    ['>'] = SHIFT(0x37),
+    ['?'] = SHIFT(0x38),
+    ['@'] = SHIFT(0x1F),
+    ['A'] = SHIFT(0x04),
+    ['B'] = SHIFT(0x05),
+    ['C'] = SHIFT(0x06),
+    ['D'] = SHIFT(0x07),
+    ['E'] = SHIFT(0x08),
+    ['F'] = SHIFT(0x09),
+    ['G'] = SHIFT(0x0A),
+    ['H'] = SHIFT(0x0B),
+    ['I'] = SHIFT(0x0C),
+    ['J'] = SHIFT(0x0D),
+    ['K'] = SHIFT(0x0E),
+    ['L'] = SHIFT(0x0F),
+    ['M'] = SHIFT(0x10),
+    ['N'] = SHIFT(0x11),
+    ['O'] = SHIFT(0x12),
+    ['P'] = SHIFT(0x13),
+    ['Q'] = SHIFT(0x14),
+    ['R'] = SHIFT(0x15),
+    ['S'] = SHIFT(0x16),
+    ['T'] = SHIFT(0x17),
+    ['U'] = SHIFT(0x18),
+    ['V'] = SHIFT(0x19),
+    ['W'] = SHIFT(0x1A),
+    ['X'] = SHIFT(0x1B),
+    ['Y'] = SHIFT(0x1C),
+    ['Z'] = SHIFT(0x1D),
+    ['['] = KEY(0x2F),
+    ['\\'] = KEY(0x31),
+    [']'] = KEY(0x30),
+    ['^'] = SHIFT(0x23),
+    ['_'] = SHIFT(0x2D),
+    ['`'] = KEY(0x35),
+    ['a'] = KEY(0x04),
+    ['b'] = KEY(0x05),
+    ['c'] = KEY(0x06),
+    ['d'] = KEY(0x07),
+    ['e'] = KEY(0x08),
+    ['f'] = KEY(0x09),
+    ['g'] = KEY(0x0A),
+    ['h'] = KEY(0x0B),
+    ['i'] = KEY(0x0C),
+    ['j'] = KEY(0x0D),
+    ['k'] = KEY(0x0E),
+    ['l'] = KEY(0x0F),
+    ['m'] = KEY(0x10),
+    ['n'] = KEY(0x11),
+    ['o'] = KEY(0x12),
+    ['p'] = KEY(0x13),
+    ['q'] = KEY(0x14),
+    ['r'] = KEY(0x15),
+    ['s'] = KEY(0x16),
+    ['t'] = KEY(0x17),
+    ['u'] = KEY(0x18),
+    ['v'] = KEY(0x19),
+    ['w'] = KEY(0x1A),
+    ['x'] = KEY(0x1B),
+    ['y'] = KEY(0x1C),
+    ['z'] = KEY(0x1D),
+    ['{'] = SHIFT(0x2F),
+    ['|'] = SHIFT(0x31),
+    ['}'] = SHIFT(0x30),
+    ['~'] = SHIFT(0x35),
+};
+
+static const hid_keymap_entry_t hid_keymap_it[HID_KEYMAP_ASCII_SIZE] = {
+    ['\b'] = KEY(0x2A),
+    ['\t'] = KEY(0x2B),
+    ['\n'] = KEY(0x28),
+    [' '] = KEY(0x2C),
+    ['!'] = SHIFT(0x1E),
+    ['"'] = SHIFT(0x1F),
+    ['#'] = ALTGR(0x34),
+    ['$'] = SHIFT(0x21),
+    ['%'] = SHIFT(0x22),
+    ['&'] = SHIFT(0x23),
+    ['\''] = KEY(0x2D),
+    ['('] = SHIFT(0x25),
+    [')'] = SHIFT(0x26),
+    ['*'] = SHIFT(0x30),
+    ['+'] = KEY(0x30),
+    [','] = KEY(0x36),
+    ['-'] = KEY(0x38),
+    ['.'] = KEY(0x37),
+    ['/'] = SHIFT(0x24),
+    ['0'] = KEY(0x27),
+    ['1'] = KEY(0x1E),
+    ['2'] = KEY(0x1F),
+    ['3'] = KEY(0x20),
+    ['4'] = KEY(0x21),
+    ['5'] = KEY(0x22),
+    ['6'] = KEY(0x23),
+    ['7'] = KEY(0x24),
+    ['8'] = KEY(0x25),
+    ['9'] = KEY(0x26),
+    [':'] = SHIFT(0x37),
+    [';'] = SHIFT(0x36),
+    ['<'] = KEY(0x64),
+    ['='] = SHIFT(0x27),
+    ['>'] = SHIFT(0x64),
+    ['?'] = SHIFT(0x2D),
+    ['@'] = ALTGR(0x33),
+    ['A'] = SHIFT(0x04),
+    ['B'] = SHIFT(0x05),
+    ['C'] = SHIFT(0x06),
+    ['D'] = SHIFT(0x07),
+    ['E'] = SHIFT(0x08),
+    ['F'] = SHIFT(0x09),
+    ['G'] = SHIFT(0x0A),
+    ['H'] = SHIFT(0x0B),
+    ['I'] = SHIFT(0x0C),
+    ['J'] = SHIFT(0x0D),
+    ['K'] = SHIFT(0x0E),
+    ['L'] = SHIFT(0x0F),
+    ['M'] = SHIFT(0x10),
+    ['N'] = SHIFT(0x11),
+    ['O'] = SHIFT(0x12),
+    ['P'] = SHIFT(0x13),
+    ['Q'] = SHIFT(0x14),
+    ['R'] = SHIFT(0x15),
+    ['S'] = SHIFT(0x16),
+    ['T'] = SHIFT(0x17),
+    ['U'] = SHIFT(0x18),
+    ['V'] = SHIFT(0x19),
+    ['W'] = SHIFT(0x1A),
+    ['X'] = SHIFT(0x1B),
+    ['Y'] = SHIFT(0x1C),
+    ['Z'] = SHIFT(0x1D),
+    ['['] = ALTGR(0x2F),
+    ['\\'] = KEY(0x35),
+    [']'] = ALTGR(0x30),
+    ['^'] = SHIFT(0x2E),
+    ['_'] = SHIFT(0x38),
+    ['a'] = KEY(0x04),
+    ['b'] = KEY(0x05),
+    ['c'] = KEY(0x06),
+    ['d'] = KEY(0x07),
+    ['e'] = KEY(0x08),
+    ['f'] = KEY(0x09),
+    ['g'] = KEY(0x0A),
+    ['h'] = KEY(0x0B),
+    ['i'] = KEY(0x0C),
+    ['j'] = KEY(0x0D),
+    ['k'] = KEY(0x0E),
+    ['l'] = KEY(0x0F),
+    ['m'] = KEY(0x10),
+    ['n'] = KEY(0x11),
+    ['o'] = KEY(0x12),
+    ['p'] = KEY(0x13),
+    ['q'] = KEY(0x14),
+    ['r'] = KEY(0x15),
+    ['s'] = KEY(0x16),
+    ['t'] = KEY(0x17),
+    ['u'] = KEY(0x18),
+    ['v'] = KEY(0x19),
+    ['w'] = KEY(0x1A),
+    ['x'] = KEY(0x1B),
+    ['y'] = KEY(0x1C),
+    ['z'] = KEY(0x1D),
+    ['{'] = ALTGR_SHIFT(0x2F),
+    ['|'] = SHIFT(0x35),
+    ['}'] = ALTGR_SHIFT(0x30),
+};
+
+static const hid_keymap_entry_t hid_keymap_de[HID_KEYMAP_ASCII_SIZE] = {
+    ['\b'] = KEY(0x2A),
+    ['\t'] = KEY(0x2B),
+    ['\n'] = KEY(0x28),
+    [' '] = KEY(0x2C),
+    ['!'] = SHIFT(0x1E),
+    ['"'] = SHIFT(0x1F),
+    ['#'] = KEY(0x32),
+    ['$'] = SHIFT(0x21),
+    ['%'] = SHIFT(0x22),
+    ['&'] = SHIFT(0x23),
+    ['\''] = SHIFT(0x32),
+    ['('] = SHIFT(0x25),
+    [')'] = SHIFT(0x26),
+    ['*'] = SHIFT(0x30),
+    ['+'] = KEY(0x30),
+    [','] = KEY(0x36),
+    ['-'] = KEY(0x38),
+    ['.'] = KEY(0x37),
+    ['/'] = SHIFT(0x24),
+    ['0'] = KEY(0x27),
+    ['1'] = KEY(0x1E),
+    ['2'] = KEY(0x1F),
+    ['3'] = KEY(0x20),
+    ['4'] = KEY(0x21),
+    ['5'] = KEY(0x22),
+    ['6'] = KEY(0x23),
+    ['7'] = KEY(0x24),
+    ['8'] = KEY(0x25),
+    ['9'] = KEY(0x26),
+    [':'] = SHIFT(0x37),
+    [';'] = SHIFT(0x36),
+    ['<'] = KEY(0x64),
+    ['='] = SHIFT(0x27),
+    ['>'] = SHIFT(0x64),
+    ['?'] = SHIFT(0x2D),
+    ['@'] = ALTGR(0x14),
+    ['A'] = SHIFT(0x04),
+    ['B'] = SHIFT(0x05),
+    ['C'] = SHIFT(0x06),
+    ['D'] = SHIFT(0x07),
+    ['E'] = SHIFT(0x08),
+    ['F'] = SHIFT(0x09),
+    ['G'] = SHIFT(0x0A),
+    ['H'] = SHIFT(0x0B),
+    ['I'] = SHIFT(0x0C),
+    ['J'] = SHIFT(0x0D),
+    ['K'] = SHIFT(0x0E),
+    ['L'] = SHIFT(0x0F),
+    ['M'] = SHIFT(0x10),
+    ['N'] = SHIFT(0x11),
+    ['O'] = SHIFT(0x12),
+    ['P'] = SHIFT(0x13),
+    ['Q'] = SHIFT(0x14),
+    ['R'] = SHIFT(0x15),
+    ['S'] = SHIFT(0x16),
+    ['T'] = SHIFT(0x17),
+    ['U'] = SHIFT(0x18),
+    ['V'] = SHIFT(0x19),
+    ['W'] = SHIFT(0x1A),
+    ['X'] = SHIFT(0x1B),
+    ['Y'] = SHIFT(0x1D),
+    ['Z'] = SHIFT(0x1C),
+    ['['] = ALTGR(0x25),
+    ['\\'] = ALTGR(0x2D),
+    [']'] = ALTGR(0x26),
+    ['_'] = SHIFT(0x38),
+    ['a'] = KEY(0x04),
+    ['b'] = KEY(0x05),
+    ['c'] = KEY(0x06),
+    ['d'] = KEY(0x07),
+    ['e'] = KEY(0x08),
+    ['f'] = KEY(0x09),
+    ['g'] = KEY(0x0A),
+    ['h'] = KEY(0x0B),
+    ['i'] = KEY(0x0C),
+    ['j'] = KEY(0x0D),
+    ['k'] = KEY(0x0E),
+    ['l'] = KEY(0x0F),
+    ['m'] = KEY(0x10),
+    ['n'] = KEY(0x11),
+    ['o'] = KEY(0x12),
+    ['p'] = KEY(0x13),
+    ['q'] = KEY(0x14),
+    ['r'] = KEY(0x15),
+    ['s'] = KEY(0x16),
+    ['t'] = KEY(0x17),
+    ['u'] = KEY(0x18),
+    ['v'] = KEY(0x19),
+    ['w'] = KEY(0x1A),
+    ['x'] = KEY(0x1B),
+    ['y'] = KEY(0x1D),
+    ['z'] = KEY(0x1C),
+    ['{'] = ALTGR(0x24),
+    ['|'] = ALTGR(0x64),
+    ['}'] = ALTGR(0x27),
+    ['~'] = ALTGR(0x30),
+};
+
+static const hid_keymap_entry_t *const hid_keymap_tables[HID_KEYMAP_LAYOUTS] = {
+    [HID_KEYMAP_US] = hid_keymap_us,
+    [HID_KEYMAP_IT] = hid_keymap_it,
+    [HID_KEYMAP_DE] = hid_keymap_de,
+};
+
+static const char *const hid_keymap_names[HID_KEYMAP_LAYOUTS] = {
+    [HID_KEYMAP_US] = "us",
+    [HID_KEYMAP_IT] = "it",
+    [HID_KEYMAP_DE] = "de",
+};
+
+static volatile hid_keymap_layout_t hid_keymap_current = HID_KEYMAP_US;
+
+// FUNCTION DEFINITIONS
+
+void hid_keymap_select(hid_keymap_layout_t layout)
+{
+    if (layout < HID_KEYMAP_LAYOUTS)
+        hid_keymap_current = layout;
+}
+
+hid_keymap_layout_t hid_keymap_selected(void)
+{
+    return hid_keymap_current;
+}
+
+const char *hid_keymap_name(hid_keymap_layout_t layout)
+{
+    return (layout < HID_KEYMAP_LAYOUTS) ? hid_keymap_names[layout] : "?";
+}
+
+hid_keymap_layout_t hid_keymap_from_name(const char *name)
+{
+    uint8_t i;
+
+    for (i = 0; i < HID_KEYMAP_LAYOUTS; i++)
+    {
+        if (strcmp(name, hid_keymap_names[i]) == 0)
+            return (hid_keymap_layout_t)i;
+    }
+
+    return HID_KEYMAP_LAYOUTS;
+}
+
+bool hid_keymap_lookup_layout(hid_keymap_layout_t layout, char c,
+                              uint8_t *usage, uint8_t *modifiers)
+{
+    const hid_keymap_entry_t *entry;
+
+    if (layout >= HID_KEYMAP_LAYOUTS || (uint8_t)c >= HID_KEYMAP_ASCII_SIZE)
+        return false;
+
+    entry = &hid_keymap_tables[layout][(uint8_t)c];
+    if (!entry->usage)
+        return false;
+
+    *usage = entry->usage;
+    *modifiers = entry->modifiers;
+    return true;
+}
+
+bool hid_keymap_lookup(char c, uint8_t *usage, uint8_t *modifiers)
+{
+    return hid_keymap_lookup_layout(hid_keymap_current, c, usage, modifiers);
+}
@@ -0,0 +1,62 @@
+/*
+ * ASCII to HID keyboard usage translation.
+ *
+ * Every supported keyboard layout is a 128-entry table indexed by the
+ * ASCII code, holding the usage to press and the modifiers to hold down
+ * with it. The host decides what a usage means, so the layout selected
+ * here must match the one configured on the host.
+ */
+
+#ifndef HID_KEYMAP_H
+#define HID_KEYMAP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HID_KEYMAP_ASCII_SIZE 128
+
+// modifier bits of the keyboard report
+#define HID_KEYMAP_SHIFT 0x02 // same as LEFT_SHIFT_KEY_MASK
+#define HID_KEYMAP_ALTGR 0x40 // same as RIGHT_ALT_KEY_MASK
+
+#define HID_KEYMAP_CAPS_LOCK 57 // same as HID_KEY_CAPS_LOCK, inverts the case of the letters
+
+    typedef enum
+    {
+        HID_KEYMAP_US,
+        HID_KEYMAP_IT,
+        HID_KEYMAP_DE,
+        HID_KEYMAP_LAYOUTS, // number of layouts available
+    } hid_keymap_layout_t;
+
+    typedef struct
+    {
+        uint8_t usage;     // 0 if the character can't be typed
+        uint8_t modifiers;
+    } hid_keymap_entry_t;
+
+    // Layout used by hid_keymap_lookup(), HID_KEYMAP_US at boot
+    void hid_keymap_select(hid_keymap_layout_t layout);
+    hid_keymap_layout_t hid_keymap_selected(void);
+
+    // Short name ("us", "it", ...) and the other way round. Returns
+    // HID_KEYMAP_LAYOUTS if the name is unknown.
+    const char *hid_keymap_name(hid_keymap_layout_t layout);
+    hid_keymap_layout_t hid_keymap_from_name(const char *name);
+
+    // Translates one character with the given/selected layout, returns
+    // false if it can't be typed
+    bool hid_keymap_lookup_layout(hid_keymap_layout_t layout, char c,
+                                  uint8_t *usage, uint8_t *modifiers);
+    bool hid_keymap_lookup(char c, uint8_t *usage, uint8_t *modifiers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HID_KEYMAP_H */
@@ -38,7 +38,7 @@
 #define HIDD_SUB_VER     0x00  //Version + Subversion
 #define HIDD_VERSION     ((HIDD_GREAT_VER<<8)|HIDD_SUB_VER)  //Version + Subversion
 
-#define HID_MAX_APPS                 1
+#define HID_MAX_APPS                 ESP_HIDD_MAX_CONN  // one connection link each
 
 // Number of HID reports defined in the service
 #define HID_NUM_REPORTS          9
@@ -48,6 +48,7 @@
 #define HID_RPT_ID_KEY_IN        2   // Keyboard input report ID
 #define HID_RPT_ID_CC_IN         3   //Consumer Control input report ID
 #define HID_RPT_ID_VENDOR_OUT    4   // Vendor output report ID
+#define HID_RPT_ID_TOUCH_IN      5   // Touch screen (absolute) input report ID
 #define HID_RPT_ID_LED_OUT       0  // LED output report ID
 #define HID_RPT_ID_FEATURE       0  // Feature report ID
 
@@ -66,6 +67,9 @@
 /// Maximal length of Report Map Char. Value
 #define HIDD_LE_REPORT_MAP_MAX_LEN            (512)
 
+/// Length of the keyboard LED output report (report or boot protocol)
+#define HID_LED_OUT_RPT_LEN                   (1)
+
 /// Length of Boot Report Char. Value Maximal Length
 #define HIDD_LE_BOOT_REPORT_MAX_LEN           (8)
 
@@ -153,6 +157,11 @@ enum {
     HIDD_LE_IDX_REPORT_CC_IN_VAL,
     HIDD_LE_IDX_REPORT_CC_IN_CCC,
     HIDD_LE_IDX_REPORT_CC_IN_REP_REF,
+    // Report touch screen input
+    HIDD_LE_IDX_REPORT_TOUCH_IN_CHAR,
+    HIDD_LE_IDX_REPORT_TOUCH_IN_VAL,
+    HIDD_LE_IDX_REPORT_TOUCH_IN_CCC,
+    HIDD_LE_IDX_REPORT_TOUCH_IN_REP_REF,
     
     // Boot Keyboard Input Report
     HIDD_LE_IDX_BOOT_KB_IN_REPORT_CHAR,
@@ -260,6 +269,8 @@ typedef struct {
     esp_bd_addr_t         remote_bda;
     uint32_t                  trans_id;
     uint8_t                    cur_srvc_id;
+    uint8_t                    leds;            // host keyboard LEDs, last output report written
+    uint8_t                    proto_mode;      // HID_PROTOCOL_MODE_* selected by this host
 
 } hidd_clcb_t;
 
@@ -324,13 +335,14 @@ typedef struct {
 } hidd_le_env_t;
 
 extern hidd_le_env_t hidd_le_env;
-extern uint8_t hidProtocolMode;
 
 
-void hidd_clcb_alloc (uint16_t conn_id, esp_bd_addr_t bda);
+bool hidd_clcb_alloc (uint16_t conn_id, esp_bd_addr_t bda);
 
 bool hidd_clcb_dealloc (uint16_t conn_id);
 
+hidd_clcb_t *hidd_clcb_find (uint16_t conn_id);
+
 void hidd_le_create_service(esp_gatt_if_t gatts_if);
 
 void hidd_set_attr_value(uint16_t handle, uint16_t val_len, const uint8_t *value);
@@ -0,0 +1,67 @@
+/*
+ * Lock-free input event ring, see input_ring.h
+ *
+ * head and tail run free and wrap at 2^32, the slot is the index masked
+ * with INPUT_RING_SIZE - 1, so 'head - tail' is always the fill level.
+ */
+
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define IRAM_ATTR
+#endif
+
+#include "input_ring.h"
+
+#if (INPUT_RING_SIZE & (INPUT_RING_SIZE - 1)) != 0
+#error "INPUT_RING_SIZE must be a power of 2"
+#endif
+
+#define INPUT_RING_MASK (INPUT_RING_SIZE - 1)
+
+// FUNCTION DEFINITIONS
+
+void input_ring_init(input_ring_t *ring)
+{
+    memset(ring, 0, sizeof(*ring));
+}
+
+bool IRAM_ATTR input_ring_push(input_ring_t *ring, const input_ring_event_t *event)
+{
+    uint32_t head = ring->head; // only written here
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= INPUT_RING_SIZE)
+    {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    ring->events[head & INPUT_RING_MASK] = *event;
+    // the event must be in place before the consumer can see it
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool input_ring_pop(input_ring_t *ring, input_ring_event_t *event)
+{
+    uint32_t tail = ring->tail; // only written here
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail)
+        return false;
+
+    *event = ring->events[tail & INPUT_RING_MASK];
+    // the slot can be reused only once it has been copied
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+uint32_t input_ring_dropped(const input_ring_t *ring)
+{
+    return __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+}
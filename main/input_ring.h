@@ -0,0 +1,59 @@
+/*
+ * Single producer / single consumer ring of input events.
+ *
+ * The button ISR pushes, the io hardware task pops. Neither side takes
+ * a lock or disables interrupts: each index is written by one side only
+ * and published with a release store, so input_ring_push() can run from
+ * an IRAM ISR. When the ring is full the new event is dropped and
+ * counted, the consumer can tell how many it missed.
+ */
+
+#ifndef INPUT_RING_H
+#define INPUT_RING_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define INPUT_RING_SIZE 32      // events, must be a power of 2
+#define INPUT_RING_CACHE_LINE 32 // keeps the two indexes apart
+
+    typedef struct
+    {
+        uint32_t time_us; // when the edge was seen (esp_timer)
+        uint8_t button;   // index of the input
+        uint8_t level;    // GPIO level read in the ISR, right after the edge
+    } input_ring_event_t;
+
+    typedef struct
+    {
+        // producer side
+        uint32_t head __attribute__((aligned(INPUT_RING_CACHE_LINE))); // next slot to write
+        uint32_t dropped;                                             // events lost because full
+
+        // consumer side
+        uint32_t tail __attribute__((aligned(INPUT_RING_CACHE_LINE))); // next slot to read
+
+        input_ring_event_t events[INPUT_RING_SIZE] __attribute__((aligned(INPUT_RING_CACHE_LINE)));
+    } input_ring_t;
+
+    void input_ring_init(input_ring_t *ring);
+
+    // Producer only. Returns false (and counts the event) if the ring is full.
+    bool input_ring_push(input_ring_t *ring, const input_ring_event_t *event);
+
+    // Consumer only. Returns false if the ring is empty.
+    bool input_ring_pop(input_ring_t *ring, input_ring_event_t *event);
+
+    // Events dropped since init, can be read from any side
+    uint32_t input_ring_dropped(const input_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INPUT_RING_H */
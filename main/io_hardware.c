@@ -12,12 +12,17 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
-#include "freertos/timers.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
+#include "soc/gpio_struct.h"
 #include "driver/spi_master.h"
+#include "esp_timer.h"
 
 #include "io_hardware.h"
+#include "input_ring.h"
+#include "event_bus.h"
 #include "ws2812.h"
+#include "led_framebuffer.h"
 
 /**
  * Brief: (outdated)
@@ -38,10 +43,10 @@
 
 #define ESP_INTR_FLAG_DEFAULT 0
 
-static xQueueHandle gpio_evt_queue = NULL;
-
-//TODO: Must optimize here, only the first byte should be enough
-uint8_t io_hardware_notify_data[5] = {0x00, 0x00, 0x00, 0x00, 0x00};
+// the button ISR writes the edges in the ring and gives the doorbell to
+// wake up the io hardware task, which drains the ring
+static input_ring_t io_hardware_input_ring;
+static SemaphoreHandle_t io_hardware_input_doorbell = NULL;
 
 uint32_t io_hardware_buttons_rgbCodes[GPIO_INPUT_NUMBER - 1][2] = {
     {IO_HARDWARE_SW2_LED, LED_STATE_GREEN},
@@ -63,100 +68,190 @@ static volatile uint8_t io_hardware_input_digital[GPIO_INPUT_NUMBER][2] = {
 
 //static volatile uint8_t io_hardware_input_digital_previous[GPIO_INPUT_NUMBER] = {0};
 
-rgbVal *pixels; // 7 leds
-uint32_t pixels_states[NUMBER_OF_LEDS] = {
-    0x000000, // 0xrrggbb
-    0x000000,
-    0x000000,
-    0x000000,
-    0x000000,
-    0x000000,
-    0x000000,
-};
+// GPIO number -> index in io_hardware_input_digital (-1 if not a button)
+static int8_t io_hardware_gpio_buttons[GPIO_NUM_MAX];
 
-TimerHandle_t led_blink_timer;
-static xQueueHandle external_tasks_evt_queue = NULL;
+static io_hardware_button_handler_t io_hardware_button_handler = NULL;
+
+// debounces the buttons and turns their edges into gestures
+static button_gesture_t io_hardware_gesture;
 
-static uint8_t notify_code_received[5] = {0x00, 0x00, 0x00, 0x00, 0x00};
 // testing a sort of semaphore.. (not using it now)
 static volatile uint8_t ledsInUse = 0;
 
 // prototypes
-static void led_blink_timer_callback(TimerHandle_t pxTimer);
-static void ws2812_setRGBValue(rgbVal *pixel_to_set, uint8_t r, uint8_t g, uint8_t b);
-
+static void io_hardware_input_drain(void);
+static void io_hardware_system_event(void *ctx, const event_bus_event_t *event);
+static void io_hardware_gesture_event(void *ctx, const button_gesture_event_t *event);
+static void io_hardware_gesture_poll(void);
+static TickType_t io_hardware_gesture_wait(void);
+
+// arg is the index of the button, not the GPIO number. The level is
+// read here, next to the edge: by the time the task drains the ring the
+// button may have bounced again. GPIO.in is a plain register read (all
+// the buttons are below GPIO 32), nothing in flash is called.
 static void IRAM_ATTR gpio_isr_handler(void *arg)
 {
-    uint32_t gpio_num = (uint32_t)arg;
-    xQueueSendFromISR(gpio_evt_queue, &gpio_num, NULL);
+    BaseType_t task_woken = pdFALSE;
+    uint8_t button = (uint8_t)(uint32_t)arg;
+    input_ring_event_t evt = {
+        .time_us = (uint32_t)esp_timer_get_time(),
+        .button = button,
+        .level = (GPIO.in >> io_hardware_input_digital[button][0]) & 1,
+    };
+
+    // when the ring is full the edge is counted as dropped, the doorbell
+    // is rung anyway so the task catches up
+    input_ring_push(&io_hardware_input_ring, &evt);
+    xSemaphoreGiveFromISR(io_hardware_input_doorbell, &task_woken);
+    if (task_woken)
+        portYIELD_FROM_ISR();
 }
 
+// Sleeps until a button interrupt or the next gesture timeout (debounce
+// window or long press), nothing is polled
 static void gpio_task_example(void *arg)
 {
-    uint32_t io_num;
-    static uint8_t firstTime = 1;
-    uint8_t led_blink_activated = 0;
-    uint8_t index_detected;
-    uint8_t level_detected;
-    uint8_t i;
-
     for (;;)
     {
-
-        if (xQueueReceive(gpio_evt_queue, &io_num, 0))
+        if (xSemaphoreTake(io_hardware_input_doorbell, io_hardware_gesture_wait()))
         {
-            //printf("GPIO[%d] intr, val: %d\n", io_num, gpio_get_level(io_num)&1);
-            //vTaskDelay((10) / portTICK_RATE_MS); // lil bit of debounce lol
-            level_detected = gpio_get_level(io_num);
-            printf("level detected: %d, GPIO_NUM: %d\n", level_detected, io_num);
-
-            for (i = 0; i < GPIO_INPUT_NUMBER; i++)
-            {
-                if (io_num == (unsigned int)io_hardware_input_digital[i][0])
-                {
-                    index_detected = i;
-                    //printf("pin detected, index value: %d\n", (int)index_detected);
-                    i = GPIO_INPUT_NUMBER; // stop the 'for' loop
-                }
-            }
-            io_hardware_input_digital[index_detected][1] = level_detected;
+            io_hardware_input_drain();
 
             // maybe will add some control for standby buttons here..
         }
 
-        // testing..
+        io_hardware_gesture_poll();
+    }
+}
 
-        if (xQueueReceive(io_hardware_get_queue(), &notify_code_received,
-                          0))
+// LEDs showing the state of the system, runs in the event bus task
+static void io_hardware_system_event(void *ctx, const event_bus_event_t *event)
+{
+    led_animation_t blink = {
+        .effect = LED_ANIMATION_BLINK,
+        .color = LED_STATE_BLUE,
+        .period_ms = 2 * LED_BLINK_PERIOD_MS,
+        .priority = IO_HARDWARE_LED_PRIORITY_STATUS,
+    };
+
+    switch (event->type)
+    {
+    case EVENT_BUS_BLE_STATE:
+        if (event->ble.connections == 0)
+        {
+            led_framebuffer_animate(IO_HARDWARE_BLE_LED, &blink);
+            printf("BLE led blink started!\n");
+        }
+        else
+        {
+            // also stops the blinking, if any
+            set_led_state(IO_HARDWARE_BLE_LED, LED_STATE_BLUE);
+            led_framebuffer_stop_animation(IO_HARDWARE_BLE_LED, IO_HARDWARE_LED_PRIORITY_STATUS);
+            printf("BLE led set to connected!\n");
+        }
+        break;
+
+    case EVENT_BUS_WIFI_STATE:
+        switch (event->wifi.state)
         {
-            //printf("Color received! 0x%06x\n", RGB(notify_code_received[2], notify_code_received[3], notify_code_received[4]));
-
-            if ((notify_code_received[0]) == IO_HARDWARE_NOTIFY_BLE_DISCONNECT)
-            {
-                led_blink_activated = xTimerStart(led_blink_timer, 0);
-                printf("BLE led blink started!\n");
-            }
-            else if (((notify_code_received[0]) == IO_HARDWARE_NOTIFY_BLE_CONNECT) &&
-                     led_blink_activated)
-            {
-                xTimerStop(led_blink_timer, 0);
-                led_blink_activated = 0;
-                set_led_state(notify_code_received[1],
-                              RGB(notify_code_received[2], notify_code_received[3], notify_code_received[4]));
-                printf("BLE led blink stopped!\n");
-            }
-            else
-            {
-                set_led_state(notify_code_received[1],
-                              RGB(notify_code_received[2], notify_code_received[3], notify_code_received[4]));
-                printf("BLE led set to connected!\n");
-            }
+        case EVENT_BUS_WIFI_STARTING:
+        case EVENT_BUS_WIFI_DISCONNECTED:
+            set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_RED);
+            break;
+        case EVENT_BUS_WIFI_WAITING:
+            set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_OFF);
+            break;
+        case EVENT_BUS_WIFI_CONNECTED:
+        case EVENT_BUS_WIFI_READY:
+            set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_GREEN);
+            break;
+        case EVENT_BUS_WIFI_STATION_JOINED:
+            set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_BLUE);
+            break;
+        default:
+            break;
         }
+        break;
+
+    case EVENT_BUS_OTA:
+        // the firmware update is shown on the wifi led
+        if (event->ota.state == EVENT_BUS_OTA_STARTED)
+            set_led_state(IO_HARDWARE_WIFI_LED, LED_STATE_YELLOW);
+        break;
 
-        vTaskDelay(10); // some delay to let other tasks run smoothly..
+    default:
+        break;
     }
 }
 
+static void io_hardware_input_drain(void)
+{
+    static uint32_t dropped_reported = 0;
+    input_ring_event_t evt;
+    uint32_t dropped;
+
+    // the ISR fires on both edges and reads the level of each
+    while (input_ring_pop(&io_hardware_input_ring, &evt))
+        button_gesture_input(&io_hardware_gesture, evt.button, evt.level, evt.time_us);
+
+    dropped = input_ring_dropped(&io_hardware_input_ring);
+    if (dropped != dropped_reported)
+    {
+        printf("input events dropped: %u\n", dropped - dropped_reported);
+        dropped_reported = dropped;
+    }
+}
+
+static void io_hardware_gesture_event(void *ctx, const button_gesture_event_t *event)
+{
+    if (event->type == BUTTON_GESTURE_PRESS || event->type == BUTTON_GESTURE_RELEASE)
+    {
+        io_hardware_input_digital[event->button][1] = (event->type == BUTTON_GESTURE_PRESS);
+        printf("level detected: %d, GPIO_NUM: %d\n", io_hardware_input_digital[event->button][1],
+               io_hardware_input_digital[event->button][0]);
+    }
+
+    // scripts start from here, without waiting for the event bus
+    if (io_hardware_button_handler)
+        io_hardware_button_handler(event);
+
+    // for the other subsystems, the bus skips it while nobody subscribes
+    event_bus_event_t input = {
+        .type = EVENT_BUS_INPUT,
+        .input = *event,
+    };
+    event_bus_publish(&input);
+}
+
+// Reads again the buttons that are settling (the last bounce may have
+// been missed) and lets the pending timeouts expire
+static void io_hardware_gesture_poll(void)
+{
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    uint8_t i;
+
+    for (i = 0; i < GPIO_INPUT_NUMBER; i++)
+    {
+        if (io_hardware_gesture.settling & (1 << i))
+            button_gesture_input(&io_hardware_gesture, i,
+                                 gpio_get_level(io_hardware_input_digital[i][0]), now_us);
+    }
+
+    button_gesture_poll(&io_hardware_gesture, now_us);
+}
+
+// Ticks until the next gesture timeout, forever if none is pending
+static TickType_t io_hardware_gesture_wait(void)
+{
+    uint32_t wait_us = button_gesture_timeout_us(&io_hardware_gesture, (uint32_t)esp_timer_get_time());
+
+    if (wait_us == BUTTON_GESTURE_NO_TIMEOUT)
+        return portMAX_DELAY;
+
+    return (wait_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+}
+
 void io_hardware_setup()
 {
     gpio_config_t io_conf;
@@ -188,21 +283,16 @@ void io_hardware_setup()
     //change gpio interrupt type for one pin
     //gpio_set_intr_type(GPIO_INPUT_IO_0, GPIO_INTR_ANYEDGE);
 
-    //create a queue to handle gpio event from isr
-    gpio_evt_queue = xQueueCreate(10, sizeof(uint32_t));
-
-    external_tasks_evt_queue = xQueueCreate(5, sizeof(uint8_t) * 5);
-    if (external_tasks_evt_queue == NULL)
-    {
-        printf("io hardware queue not set!\n");
-    }
+    //create the ring and the doorbell to handle gpio events from isr
+    input_ring_init(&io_hardware_input_ring);
+    io_hardware_input_doorbell = xSemaphoreCreateBinary();
 
     // Initialize the RGB leds
     ws2812_init(RGB_LEDS_DATA_PIN);
     printf("Leds initialized!");
 
-    pixels = malloc(sizeof(rgbVal) * NUMBER_OF_LEDS);
-    printf("Pixels array allocated!\n");
+    led_framebuffer_init(NUMBER_OF_LEDS);
+    printf("Led framebuffer started!\n");
 
     printf("Testing leds..\n");
 
@@ -229,12 +319,6 @@ void io_hardware_setup()
 
     printf("Test complete!\n");
 
-    led_blink_timer = xTimerCreate("led_blink_timer",
-                                   ((LED_BLINK_PERIOD_MS) / portTICK_RATE_MS),
-                                   pdTRUE,
-                                   (void *)1,
-                                   led_blink_timer_callback);
-
     /*
 
     io_hardware_buttons_rgbCodes[0][0] = GPIO_INPUT_IO_1;
@@ -258,29 +342,40 @@ void io_hardware_setup()
     In fact, app_main runs within a FreeRTOS task already!
     */
 
+    // buttons already held at boot are ignored until released
+    uint8_t levels = 0;
+    for (int i = 0; i < GPIO_INPUT_NUMBER; i++)
+    {
+        io_hardware_input_digital[i][1] = gpio_get_level(io_hardware_input_digital[i][0]);
+        levels |= io_hardware_input_digital[i][1] << i;
+    }
+    button_gesture_init(&io_hardware_gesture, GPIO_INPUT_NUMBER, levels, io_hardware_gesture_event, NULL);
+
     //start gpio task
     xTaskCreate(gpio_task_example, "gpio_task_example", 2048, NULL, 10, NULL);
 
     //install gpio isr service
     gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT);
-    //hook isr handler for specific gpio pin
-    gpio_isr_handler_add(GPIO_INPUT_IO_0, gpio_isr_handler, (void *)GPIO_INPUT_IO_0);
-    //hook isr handler for specific gpio pin
-    gpio_isr_handler_add(GPIO_INPUT_IO_1, gpio_isr_handler, (void *)GPIO_INPUT_IO_1);
-
-    gpio_isr_handler_add(GPIO_INPUT_IO_2, gpio_isr_handler, (void *)GPIO_INPUT_IO_2);
-    gpio_isr_handler_add(GPIO_INPUT_IO_3, gpio_isr_handler, (void *)GPIO_INPUT_IO_3);
-    gpio_isr_handler_add(GPIO_INPUT_IO_4, gpio_isr_handler, (void *)GPIO_INPUT_IO_4);
-    //gpio_isr_handler_add(GPIO_INPUT_IO_5, gpio_isr_handler, (void*) GPIO_INPUT_IO_5);
+    //hook isr handler for every button, the ISR gets the button index
+    //(GPIO_INPUT_IO_5 is not in io_hardware_input_digital for now)
+    memset(io_hardware_gpio_buttons, -1, sizeof(io_hardware_gpio_buttons));
+    for (int i = 0; i < GPIO_INPUT_NUMBER; i++)
+    {
+        io_hardware_gpio_buttons[io_hardware_input_digital[i][0]] = i;
+        gpio_isr_handler_add(io_hardware_input_digital[i][0], gpio_isr_handler, (void *)i);
+    }
 
-    // Notify initial BLE disconnection of the device..
-    io_hardware_notify_data[0] = IO_HARDWARE_NOTIFY_BLE_DISCONNECT;
-    io_hardware_notify_data[1] = IO_HARDWARE_BLE_LED; // use the last led
-    io_hardware_notify_data[2] = LED_STATE_BLUE >> 16,
-    io_hardware_notify_data[3] = (LED_STATE_BLUE >> 8) & 0xFF,
-    io_hardware_notify_data[4] = LED_STATE_BLUE & 0xFF;
+    // the status LEDs follow the system events, starting from the
+    // initial BLE disconnection of the device..
+    event_bus_subscribe(EVENT_BUS_MASK(EVENT_BUS_BLE_STATE) | EVENT_BUS_MASK(EVENT_BUS_WIFI_STATE) |
+                            EVENT_BUS_MASK(EVENT_BUS_OTA),
+                        io_hardware_system_event, NULL);
 
-    xQueueSend(io_hardware_get_queue(), &io_hardware_notify_data, 0);
+    event_bus_event_t ble_state = {
+        .type = EVENT_BUS_BLE_STATE,
+        .ble.connected = false,
+    };
+    event_bus_publish(&ble_state);
 
     /*gpio_set_direction(GPIO_OUTPUT_IO_1, GPIO_MODE_OUTPUT); // trying something new..
     gpio_set_direction(GPIO_OUTPUT_IO_0, GPIO_MODE_OUTPUT);*/
@@ -324,84 +419,21 @@ void io_hardware_setup()
     gpio_isr_handler_add(GPIO_INPUT_IO_0, gpio_isr_handler, (void*) GPIO_INPUT_IO_0);*/
 }
 
-xQueueHandle io_hardware_get_queue(void)
+void io_hardware_set_button_handler(io_hardware_button_handler_t handler)
 {
-    return external_tasks_evt_queue;
-}
-
-uint8_t **io_hardware_get_digital_inputs(void)
-{
-
-    static uint8_t **return_matrix;
-    static uint8_t firstTime = 1;
-    uint8_t i;
-
-    if (firstTime)
-    {
-        return_matrix = (uint8_t **)malloc(sizeof(uint8_t **) *
-                                           GPIO_INPUT_NUMBER);
-        for (i = 0; i < GPIO_INPUT_NUMBER; i++)
-        {
-
-            uint8_t *matrix_element = (uint8_t *)malloc(sizeof(uint8_t *) * 2);
-            return_matrix[i] = matrix_element;
-        }
-        firstTime = 0;
-    }
-
-    for (i = 0; i < GPIO_INPUT_NUMBER; i++)
-    {
-
-        return_matrix[i][1] = io_hardware_input_digital[i][1];
-    }
-
-    return return_matrix;
+    io_hardware_button_handler = handler;
 }
 
-static void led_blink_timer_callback(TimerHandle_t pxTimer)
+int8_t io_hardware_get_button_index(uint8_t gpio_num)
 {
-
-    static uint8_t led_current_state = 0;
-
-    //printf("led blink running.. 0x%02x%02x%02x%02x%02x \n", notify_code_received[0], notify_code_received[1],
-    //                            notify_code_received[2], notify_code_received[3], notify_code_received[4]);
-
-    if (!led_current_state)
-    {
-        set_led_state(notify_code_received[1],
-                      RGB(notify_code_received[2], notify_code_received[3], notify_code_received[4]));
-
-        led_current_state = 1;
-    }
-    else
-    {
-        set_led_state(notify_code_received[1],
-                      LED_STATE_OFF);
-
-        led_current_state = 0;
-    }
+    return (gpio_num < GPIO_NUM_MAX) ? io_hardware_gpio_buttons[gpio_num] : -1;
 }
 
+// doesn't wait for the LEDs, the frame goes out from the LED task
 void set_led_state(uint8_t led_number, uint32_t led_state_code)
 {
-    pixels_states[led_number] = led_state_code;
-
-    for (int i = 0; i < NUMBER_OF_LEDS; i++)
-    {
-        ws2812_setRGBValue((rgbVal *)pixels + i, pixels_states[i] >> 16,
-                           ((pixels_states[i] >> 8) & 0xFF),
-                           pixels_states[i] & 0xFF);
-    }
-
-    ws2812_setColors(NUMBER_OF_LEDS, pixels);
-}
-
-static void ws2812_setRGBValue(rgbVal *pixel_to_set, uint8_t r, uint8_t g, uint8_t b)
-{
-
-    pixel_to_set->b = b;
-    (*pixel_to_set).r = g; // yeah.. but it works like this for some reason
-    (*pixel_to_set).g = r; // yeah.. but it works like this for some reason
+    if (led_number < NUMBER_OF_LEDS)
+        led_framebuffer_set(led_number, led_state_code);
 }
 
 /*uint32_t RGB(uint8_t r, uint8_t g, uint8_t b)
@@ -428,4 +460,4 @@ uint32_t RGB_WITH_BRIGHTNESS(uint8_t r, uint8_t g, uint8_t b, uint8_t brightness
     //printf("%d | %d | %d\n", (int)newRed, (int)newGreen, (int)newBlue);
 
     return RGB((uint8_t)newRed, (uint8_t)newGreen, (uint8_t)newBlue);
-}*/
\ No newline at end of file
+}*/
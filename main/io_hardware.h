@@ -6,6 +6,8 @@ extern "C"
 {
 #endif
 
+#include "button_gesture.h"
+
 #define GPIO_INPUT_NUMBER 5  // number of digital inputs
 #define GPIO_OUTPUT_NUMBER 2 // number of digital outputs
 
@@ -39,25 +41,29 @@ extern "C"
 #define RGB(r, g, b) (uint32_t)(((uint8_t)r << 16) | ((uint8_t)g << 8) | ((uint8_t)b))
 #define RGB_WITH_BRIGHTNESS(r, g, b, brightness) \
     RGB(                                         \
-        (uint8_t)(r * (float)brightness / 100),  \
-        (uint8_t)(g * (float)brightness / 100),  \
-        (uint8_t)(b * (float)brightness / 100))
-
-// All with 15% brightness for now (otherwise they're too bright)
-#define LED_STATE_OFF RGB_WITH_BRIGHTNESS(0, 0, 0, 15)
-#define LED_STATE_RED RGB_WITH_BRIGHTNESS(255, 0, 0, 15)
-#define LED_STATE_GREEN RGB_WITH_BRIGHTNESS(0, 255, 0, 15)
-#define LED_STATE_BLUE RGB_WITH_BRIGHTNESS(0, 0, 255, 15)
-#define LED_STATE_YELLOW RGB_WITH_BRIGHTNESS(255, 255, 0, 15)
-#define LED_STATE_CYAN RGB_WITH_BRIGHTNESS(0, 255, 255, 15)
-#define LED_STATE_GREY RGB_WITH_BRIGHTNESS(128, 128, 128, 15)
-#define LED_STATE_WHITE RGB_WITH_BRIGHTNESS(255, 255, 255, 15)
-#define LED_SPECIAL_STATE_ON RGB_WITH_BRIGHTNESS(255, 255, 255, 15)
-#define LED_SPECIAL_STATE_OFF RGB_WITH_BRIGHTNESS(0, 0, 0, 100)
+        ((r) * (brightness) / 100),              \
+        ((g) * (brightness) / 100),              \
+        ((b) * (brightness) / 100))
+
+// Full brightness, the LEDs are dimmed all together when the frame is
+// sent (see led_framebuffer_set_brightness)
+#define LED_STATE_OFF RGB(0, 0, 0)
+#define LED_STATE_RED RGB(255, 0, 0)
+#define LED_STATE_GREEN RGB(0, 255, 0)
+#define LED_STATE_BLUE RGB(0, 0, 255)
+#define LED_STATE_YELLOW RGB(255, 255, 0)
+#define LED_STATE_CYAN RGB(0, 255, 255)
+#define LED_STATE_GREY RGB(128, 128, 128)
+#define LED_STATE_WHITE RGB(255, 255, 255)
+#define LED_SPECIAL_STATE_ON RGB(255, 255, 255)
+#define LED_SPECIAL_STATE_OFF RGB(0, 0, 0)
 
 // Set blinking period for blinking activties
 #define LED_BLINK_PERIOD_MS 500
 
+// Priorities of the LED animations (see led_animation.h)
+#define IO_HARDWARE_LED_PRIORITY_STATUS 1 // BLE & WiFi state
+
 // LED ASSOCIATED TO APP CONTROL SWITCH
 #define IO_HARDWARE_APP_LED 0
 
@@ -71,26 +77,21 @@ extern "C"
 #define IO_HARDWARE_WIFI_LED 5
 #define IO_HARDWARE_BLE_LED 6
 
-// codes for notifying ble disconnection to the
-// io hardware related task so it can start
-// blinking the related led
-#define IO_HARDWARE_NOTIFY_BLE_DISCONNECT 0x00
-#define IO_HARDWARE_NOTIFY_BLE_CONNECT 0x01
-
-    // this queue must be accessible from all other tasks
-    //extern xQueueHandle external_tasks_evt_queue; // disabled here for now
-
-    // the notify data to send to the io hardware related task
-    // ble state, led number, led color
-    extern uint8_t io_hardware_notify_data[5];
+    // the BLE & WiFi status LEDs follow the events published on the
+    // event bus (see event_bus.h)
 
     // the button-led-color relationship for the 4 butttons (GPIO_INPUT_IO_0 is not used)
     // (Gpio number, LED number, color state)
     extern uint32_t io_hardware_buttons_rgbCodes[GPIO_INPUT_NUMBER - 1][2];
 
+    // called by the io hardware task for every debounced button gesture,
+    // event->button is the index of the input (0 is GPIO_INPUT_IO_0 and so
+    // on), event->time_us the esp_timer time of the interrupt that caused it
+    typedef void (*io_hardware_button_handler_t)(const button_gesture_event_t *event);
+
     void io_hardware_setup();
-    xQueueHandle io_hardware_get_queue(void);
-    uint8_t **io_hardware_get_digital_inputs(void);
+    void io_hardware_set_button_handler(io_hardware_button_handler_t handler);
+    int8_t io_hardware_get_button_index(uint8_t gpio_num); // -1 if not a button
     void set_led_state(uint8_t led_number, uint32_t led_state_code);
     //uint32_t rgb(uint8_t r, uint8_t g, uint8_t b);
     //uint32_t RGB_WITH_BRIGHTNESS(uint8_t r, uint8_t g, uint8_t b, uint8_t brightness);
@@ -99,4 +100,4 @@ extern "C"
 }
 #endif
 
-#endif /* IO_HARDWARE_H */
\ No newline at end of file
+#endif /* IO_HARDWARE_H */
\ No newline at end of file
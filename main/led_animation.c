@@ -0,0 +1,81 @@
+/*
+ * LED effects, see led_animation.h
+ *
+ * Every effect computes a brightness level (0..255) from the position
+ * inside its period, the color is then scaled by that level. Fades stay
+ * linear here: led_framebuffer.c gamma corrects every channel already.
+ */
+
+#include "led_animation.h"
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static uint8_t led_animation_level(const led_animation_t *animation, uint32_t elapsed_ms);
+static uint8_t led_animation_clamp(uint32_t level);
+
+// FUNCTION DEFINITIONS
+
+uint32_t led_animation_render(const led_animation_t *animation, uint32_t now_ms)
+{
+    if (animation->effect == LED_ANIMATION_NONE || animation->period_ms == 0)
+        return animation->color;
+
+    return led_animation_scale(animation->color,
+                               led_animation_level(animation, now_ms - animation->start_ms + animation->phase_ms));
+}
+
+uint32_t led_animation_scale(uint32_t color, uint8_t level)
+{
+    // (c * (level + 1)) >> 8 keeps 255 as full brightness and 0 as off
+    uint32_t r = (((color >> 16) & 0xFF) * (level + 1)) >> 8;
+    uint32_t g = (((color >> 8) & 0xFF) * (level + 1)) >> 8;
+    uint32_t b = ((color & 0xFF) * (level + 1)) >> 8;
+
+    if (level == 0)
+        return 0;
+
+    return (r << 16) | (g << 8) | b;
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static uint8_t led_animation_level(const led_animation_t *animation, uint32_t elapsed_ms)
+{
+    uint32_t period = animation->period_ms;
+    uint32_t t = elapsed_ms % period;
+    uint32_t on_ms;
+
+    switch (animation->effect)
+    {
+    case LED_ANIMATION_BLINK:
+        return (t < period / 2) ? 255 : 0;
+
+    case LED_ANIMATION_BREATHE:
+        // triangle 0 -> 255 -> 0
+        if (t < period / 2)
+            return led_animation_clamp(t * 510 / period);
+        return led_animation_clamp((period - t) * 510 / period);
+
+    case LED_ANIMATION_PULSE:
+        return led_animation_clamp((period - t) * 255 / period);
+
+    case LED_ANIMATION_CHASE:
+        on_ms = animation->on_ms ? animation->on_ms : 1;
+        if (t < on_ms)
+            return 255;
+        if (t < 2 * on_ms)
+            return led_animation_clamp((2 * on_ms - t) * 255 / on_ms);
+        return 0;
+
+    default:
+        return 255;
+    }
+}
+
+static uint8_t led_animation_clamp(uint32_t level)
+{
+    if (level > 255)
+        level = 255;
+
+    return (uint8_t)level;
+}
@@ -0,0 +1,50 @@
+/*
+ * LED effects rendered from a frame clock.
+ *
+ * An animation is just a description (effect, color, period...), the
+ * color of the LED at a given time is computed by led_animation_render()
+ * with integer math only. The LED framebuffer (see led_framebuffer.h)
+ * runs one animation per LED and renders all of them at every frame.
+ */
+
+#ifndef LED_ANIMATION_H
+#define LED_ANIMATION_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+    typedef enum
+    {
+        LED_ANIMATION_NONE,    // the LED shows its static color
+        LED_ANIMATION_BLINK,   // on for half the period, off for the other half
+        LED_ANIMATION_BREATHE, // fades in and out over the period
+        LED_ANIMATION_PULSE,   // full brightness at the start of the period, fades out
+        LED_ANIMATION_CHASE,   // on for on_ms every period, fading out for another on_ms
+    } led_animation_effect_t;
+
+    typedef struct
+    {
+        led_animation_effect_t effect;
+        uint32_t color;     // 0xrrggbb at full brightness
+        uint16_t period_ms;
+        uint16_t phase_ms;  // shifts the effect, e.g. for the LEDs of a chase
+        uint16_t on_ms;     // only LED_ANIMATION_CHASE
+        uint8_t priority;   // a running animation is replaced only by the same or higher priority
+        uint32_t start_ms;  // set when the animation starts
+    } led_animation_t;
+
+    // Color of the LED 'now_ms' after the animation started
+    uint32_t led_animation_render(const led_animation_t *animation, uint32_t now_ms);
+
+    // Scales a 0xrrggbb color by level / 255
+    uint32_t led_animation_scale(uint32_t color, uint8_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_ANIMATION_H */
@@ -0,0 +1,310 @@
+/*
+ * LED framebuffer service, see led_framebuffer.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "led_framebuffer.h"
+#include "led_animation.h"
+#include "ws2812.h"
+
+// colors requested by the tasks (0xrrggbb) and the LEDs changed since
+// the last frame, both written with atomic operations only
+static uint32_t led_framebuffer_colors[LED_FRAMEBUFFER_MAX_LEDS];
+static uint32_t led_framebuffer_dirty = 0;
+static uint32_t led_framebuffer_requested = 0;
+static uint8_t led_framebuffer_brightness = LED_FRAMEBUFFER_BRIGHTNESS;
+
+// 8 bit gamma correction (2.2) of the WS2812 LEDs
+static const uint8_t led_framebuffer_gamma[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+// running animations, they're bigger than a word so they're guarded by
+// a spinlock (held just to copy or render them)
+static led_animation_t led_framebuffer_animations[LED_FRAMEBUFFER_MAX_LEDS];
+static uint32_t led_framebuffer_animated = 0;
+static portMUX_TYPE led_framebuffer_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// owned by the LED task
+static rgbVal led_framebuffer_pixels[LED_FRAMEBUFFER_MAX_LEDS];
+static uint32_t led_framebuffer_shown[LED_FRAMEBUFFER_MAX_LEDS]; // colors of the last frame sent
+static uint8_t led_framebuffer_lut[256];   // brightness and gamma, for every channel value
+static uint16_t led_framebuffer_lut_brightness = 0xFFFF; // brightness the LUT was built for
+static uint8_t led_framebuffer_num_leds = 0;
+static uint32_t led_framebuffer_applied = 0;
+static uint32_t led_framebuffer_frames = 0;
+
+static TaskHandle_t led_framebuffer_task_handle = NULL;
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static uint32_t led_framebuffer_now_ms(void);
+static void led_framebuffer_wake(uint32_t leds);
+static void led_framebuffer_build_lut(uint8_t brightness);
+static void led_framebuffer_task(void *pvParameters);
+static void ws2812_setRGBValue(rgbVal *pixel_to_set, uint8_t r, uint8_t g, uint8_t b);
+
+// FUNCTION DEFINITIONS
+
+void led_framebuffer_init(uint8_t num_leds)
+{
+    led_framebuffer_num_leds = (num_leds > LED_FRAMEBUFFER_MAX_LEDS) ? LED_FRAMEBUFFER_MAX_LEDS : num_leds;
+
+    // the first frame clears whatever the LEDs show at power on
+    memset(led_framebuffer_shown, 0xFF, sizeof(led_framebuffer_shown));
+    __atomic_fetch_or(&led_framebuffer_dirty, (uint32_t)((1ULL << led_framebuffer_num_leds) - 1), __ATOMIC_RELEASE);
+
+    xTaskCreate(led_framebuffer_task, "led_task", 2048, NULL, 5, &led_framebuffer_task_handle);
+}
+
+void led_framebuffer_set(uint8_t led, uint32_t color)
+{
+    if (led >= LED_FRAMEBUFFER_MAX_LEDS)
+        return;
+
+    __atomic_fetch_add(&led_framebuffer_requested, 1, __ATOMIC_RELAXED);
+
+    // the color must be in place before the LED looks dirty
+    __atomic_store_n(&led_framebuffer_colors[led], color, __ATOMIC_RELAXED);
+    led_framebuffer_wake(1UL << led);
+}
+
+bool led_framebuffer_animate(uint8_t led, const led_animation_t *animation)
+{
+    bool started = false;
+
+    if (led >= LED_FRAMEBUFFER_MAX_LEDS)
+        return false;
+
+    portENTER_CRITICAL(&led_framebuffer_mux);
+    if (!(led_framebuffer_animated & (1UL << led)) ||
+        animation->priority >= led_framebuffer_animations[led].priority)
+    {
+        led_framebuffer_animations[led] = *animation;
+        led_framebuffer_animations[led].start_ms = led_framebuffer_now_ms();
+        if (animation->effect == LED_ANIMATION_NONE)
+            led_framebuffer_animated &= ~(1UL << led);
+        else
+            led_framebuffer_animated |= (1UL << led);
+        started = true;
+    }
+    portEXIT_CRITICAL(&led_framebuffer_mux);
+
+    if (started)
+        led_framebuffer_wake(1UL << led);
+
+    return started;
+}
+
+void led_framebuffer_stop_animation(uint8_t led, uint8_t priority)
+{
+    bool stopped = false;
+
+    if (led >= LED_FRAMEBUFFER_MAX_LEDS)
+        return;
+
+    portENTER_CRITICAL(&led_framebuffer_mux);
+    if ((led_framebuffer_animated & (1UL << led)) &&
+        priority >= led_framebuffer_animations[led].priority)
+    {
+        led_framebuffer_animated &= ~(1UL << led);
+        stopped = true;
+    }
+    portEXIT_CRITICAL(&led_framebuffer_mux);
+
+    // back to the static color
+    if (stopped)
+        led_framebuffer_wake(1UL << led);
+}
+
+void led_framebuffer_chase(uint8_t first, uint8_t count, uint32_t color,
+                           uint16_t period_ms, uint8_t priority)
+{
+    led_animation_t animation = {
+        .effect = LED_ANIMATION_CHASE,
+        .color = color,
+        .period_ms = period_ms,
+        .priority = priority,
+    };
+    uint8_t i;
+
+    if (count == 0)
+        return;
+
+    animation.on_ms = period_ms / count;
+    for (i = 0; i < count; i++)
+    {
+        // every LED lights up on_ms after the one before
+        animation.phase_ms = period_ms - i * animation.on_ms;
+        led_framebuffer_animate(first + i, &animation);
+    }
+}
+
+uint32_t led_framebuffer_get(uint8_t led)
+{
+    if (led >= LED_FRAMEBUFFER_MAX_LEDS)
+        return 0;
+
+    return __atomic_load_n(&led_framebuffer_colors[led], __ATOMIC_RELAXED);
+}
+
+void led_framebuffer_get_stats(led_framebuffer_stats_t *stats)
+{
+    stats->updates_requested = __atomic_load_n(&led_framebuffer_requested, __ATOMIC_RELAXED);
+    stats->updates_applied = led_framebuffer_applied;
+    stats->frames_sent = led_framebuffer_frames;
+}
+
+void led_framebuffer_set_brightness(uint8_t brightness)
+{
+    __atomic_store_n(&led_framebuffer_brightness, brightness, __ATOMIC_RELAXED);
+
+    // every LED must be sent again
+    led_framebuffer_wake((uint32_t)((1ULL << led_framebuffer_num_leds) - 1));
+}
+
+uint8_t led_framebuffer_get_brightness(void)
+{
+    return __atomic_load_n(&led_framebuffer_brightness, __ATOMIC_RELAXED);
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static uint32_t led_framebuffer_now_ms(void)
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+// Marks the LEDs dirty, the task is woken up only by the first change
+// after a frame
+static void led_framebuffer_wake(uint32_t leds)
+{
+    uint32_t dirty = __atomic_fetch_or(&led_framebuffer_dirty, leds, __ATOMIC_RELEASE);
+
+    if (dirty == 0 && led_framebuffer_task_handle)
+        xTaskNotifyGive(led_framebuffer_task_handle);
+}
+
+// Channel value -> gamma corrected value at this brightness
+static void led_framebuffer_build_lut(uint8_t brightness)
+{
+    uint16_t value;
+
+    for (value = 0; value < 256; value++)
+        led_framebuffer_lut[value] = led_framebuffer_gamma[(value * (brightness + 1)) >> 8];
+
+    led_framebuffer_lut_brightness = brightness;
+}
+
+// The frame clock: renders the dirty and the animated LEDs, sends a
+// frame if anything changed and sleeps one refresh period, or until the
+// next change when nothing is animated
+static void led_framebuffer_task(void *pvParameters)
+{
+    uint32_t frame[LED_FRAMEBUFFER_MAX_LEDS];
+    uint32_t dirty;
+    uint32_t animated;
+    uint32_t changed;
+    uint32_t now_ms;
+    uint8_t brightness;
+    uint8_t i;
+
+    while (1)
+    {
+        dirty = __atomic_exchange_n(&led_framebuffer_dirty, 0, __ATOMIC_ACQUIRE);
+
+        brightness = __atomic_load_n(&led_framebuffer_brightness, __ATOMIC_RELAXED);
+        if (brightness != led_framebuffer_lut_brightness)
+        {
+            led_framebuffer_build_lut(brightness);
+            // nothing on the LEDs matches the new LUT
+            memset(led_framebuffer_shown, 0xFF, sizeof(led_framebuffer_shown));
+        }
+
+        now_ms = led_framebuffer_now_ms();
+        changed = 0;
+
+        portENTER_CRITICAL(&led_framebuffer_mux);
+        animated = led_framebuffer_animated;
+        for (i = 0; i < led_framebuffer_num_leds; i++)
+        {
+            if (animated & (1UL << i))
+                frame[i] = led_animation_render(&led_framebuffer_animations[i], now_ms);
+        }
+        portEXIT_CRITICAL(&led_framebuffer_mux);
+
+        if (!dirty && !animated)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        for (i = 0; i < led_framebuffer_num_leds; i++)
+        {
+            if (!((dirty | animated) & (1UL << i)))
+                continue;
+
+            if (!(animated & (1UL << i)))
+                frame[i] = __atomic_load_n(&led_framebuffer_colors[i], __ATOMIC_RELAXED);
+
+            if (frame[i] != led_framebuffer_shown[i])
+            {
+                ws2812_setRGBValue(&led_framebuffer_pixels[i],
+                                   led_framebuffer_lut[frame[i] >> 16],
+                                   led_framebuffer_lut[(frame[i] >> 8) & 0xFF],
+                                   led_framebuffer_lut[frame[i] & 0xFF]);
+                changed |= (1UL << i);
+            }
+        }
+
+        // the driver copies the frame, the RMT sends it in the background
+        if (changed)
+        {
+            if (ws2812_submit(led_framebuffer_num_leds, led_framebuffer_pixels, NULL, NULL))
+            {
+                for (i = 0; i < led_framebuffer_num_leds; i++)
+                {
+                    if (changed & (1UL << i))
+                        led_framebuffer_shown[i] = frame[i];
+                }
+                led_framebuffer_applied += __builtin_popcount(changed);
+                led_framebuffer_frames++;
+            }
+            else
+            {
+                __atomic_fetch_or(&led_framebuffer_dirty, dirty, __ATOMIC_RELAXED); // retried next period
+            }
+        }
+
+        // whatever changes in the meantime goes in the next frame
+        vTaskDelay(LED_FRAMEBUFFER_REFRESH_MS / portTICK_PERIOD_MS);
+    }
+}
+
+static void ws2812_setRGBValue(rgbVal *pixel_to_set, uint8_t r, uint8_t g, uint8_t b)
+{
+
+    pixel_to_set->b = b;
+    (*pixel_to_set).r = g; // yeah.. but it works like this for some reason
+    (*pixel_to_set).g = r; // yeah.. but it works like this for some reason
+}
@@ -0,0 +1,76 @@
+/*
+ * Framebuffer of the RGB LEDs.
+ *
+ * Every task can change a LED (set_led_state() ends up here) without
+ * locks and without waiting for the RMT: the new color is stored in the
+ * LED slot and the LED is marked dirty with an atomic operation. The LED
+ * task wakes up, takes all the dirty LEDs at once and sends one frame,
+ * then sleeps at least LED_FRAMEBUFFER_REFRESH_MS before the next one.
+ * A burst of changes (boot test, app switch, blinking) costs one frame.
+ *
+ * Each LED can also run an animation (see led_animation.h) on top of its
+ * static color. While any animation runs the task is the frame clock:
+ * every LED is rendered once per refresh period, and a frame goes out
+ * only if some LED changed.
+ *
+ * Colors are given at full brightness. When the frame is built every
+ * channel goes through a LUT that applies the global brightness and the
+ * gamma correction of the LEDs, so one setting dims all of them alike.
+ */
+
+#ifndef LED_FRAMEBUFFER_H
+#define LED_FRAMEBUFFER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "led_animation.h"
+
+#define LED_FRAMEBUFFER_MAX_LEDS 32      // one bit each in the dirty mask (and WS2812_MAX_LEDS)
+#define LED_FRAMEBUFFER_REFRESH_MS 20    // minimum time between two frames
+#define LED_FRAMEBUFFER_BRIGHTNESS 108   // default (0..255), about the old 15% once gamma corrected
+
+    typedef struct
+    {
+        uint32_t updates_requested; // calls to led_framebuffer_set()
+        uint32_t updates_applied;   // LEDs changed in the frames sent
+        uint32_t frames_sent;
+    } led_framebuffer_stats_t;
+
+    // Starts the LED task, 'ws2812_init' must have been called already
+    void led_framebuffer_init(uint8_t num_leds);
+
+    // Color as 0xrrggbb, can be called from any task (not from an ISR)
+    void led_framebuffer_set(uint8_t led, uint32_t color);
+
+    // Last color set for the LED (maybe not sent yet)
+    uint32_t led_framebuffer_get(uint8_t led);
+
+    // Runs an animation on the LED, unless one with a higher priority is
+    // already running (returns false). LED_ANIMATION_NONE stops it.
+    bool led_framebuffer_animate(uint8_t led, const led_animation_t *animation);
+
+    // Stops the animation of the LED if its priority isn't above 'priority',
+    // the LED goes back to its static color
+    void led_framebuffer_stop_animation(uint8_t led, uint8_t priority);
+
+    // Runs a light along 'count' LEDs starting from 'first', once per period
+    void led_framebuffer_chase(uint8_t first, uint8_t count, uint32_t color,
+                               uint16_t period_ms, uint8_t priority);
+
+    void led_framebuffer_get_stats(led_framebuffer_stats_t *stats);
+
+    // Global brightness (0..255) applied to all the LEDs from the next frame
+    void led_framebuffer_set_brightness(uint8_t brightness);
+    uint8_t led_framebuffer_get_brightness(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_FRAMEBUFFER_H */
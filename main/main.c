@@ -9,6 +9,7 @@
 
 #include "ble_hid_app.h"
 #include "esp32_nat_router.h"
+#include "event_bus.h"
 
 
 void app_main(void)
@@ -22,6 +23,9 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK( ret );
+
+    // before anything can publish
+    event_bus_init();
     
     // Setting up BLE application (should run in background)
     printf("Setting up BLE application..\n");
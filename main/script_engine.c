@@ -0,0 +1,737 @@
+/*
+ * Interpreter for the compiled app control scripts, see script_engine.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "app_script.h"
+#include "script_engine.h"
+#include "hid_keymap.h"
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void engine_send_keyboard(script_engine_t *engine, uint8_t modifiers,
+                                 uint8_t *keys, uint8_t num_keys);
+static void engine_send_mouse(script_engine_t *engine, uint8_t buttons, int16_t x, int16_t y);
+static void engine_wait(script_engine_t *engine, uint32_t now_ms, uint32_t ms);
+static void engine_next_instruction(script_engine_t *engine, uint8_t op_length);
+static void engine_finish(script_engine_t *engine, uint32_t now_ms);
+static void engine_step(script_engine_t *engine, uint32_t now_ms);
+static void engine_special(script_engine_t *engine, uint8_t op_length);
+static void engine_combine_keys(script_engine_t *engine, const uint8_t *keys, uint8_t num_keys,
+                                uint8_t op_length, uint32_t now_ms);
+static void engine_click(script_engine_t *engine, uint8_t mouse_op, uint32_t now_ms);
+static void engine_move(script_engine_t *engine, const uint8_t *operands, uint32_t now_ms);
+static void engine_tap(script_engine_t *engine, const uint8_t *operands, uint32_t now_ms);
+static void engine_consumer(script_engine_t *engine, uint8_t usage, uint32_t now_ms);
+static void engine_press(script_engine_t *engine, uint8_t key);
+static void engine_release(script_engine_t *engine, uint8_t key);
+static void engine_repeat(script_engine_t *engine, uint8_t count, uint8_t body_length);
+static void engine_jump_if_led(script_engine_t *engine, uint8_t leds, uint8_t skip);
+static void engine_type_string(script_engine_t *engine, uint8_t id);
+static void engine_call(script_engine_t *engine, uint8_t id);
+static void engine_return(script_engine_t *engine);
+static void engine_press_key(script_engine_t *engine, uint8_t key, uint32_t now_ms);
+static void engine_type_text(script_engine_t *engine, uint32_t now_ms);
+static bool engine_text_can_roll_over(script_engine_t *engine, const char *text, uint8_t length);
+static bool engine_text_needs_caps_lock_off(script_engine_t *engine, const char *text, uint8_t length);
+static void engine_restore_caps_lock(script_engine_t *engine, uint32_t now_ms);
+
+// FUNCTION DEFINITIONS
+
+void script_engine_init(script_engine_t *engine, const script_engine_transport_t *transport)
+{
+    const script_engine_config_t default_config = {
+        .key_press_ms = SCRIPT_ENGINE_KEY_PRESS_MS,
+        .key_release_ms = SCRIPT_ENGINE_KEY_RELEASE_MS,
+        .combo_key_ms = SCRIPT_ENGINE_COMBO_KEY_MS,
+        .mouse_click_ms = SCRIPT_ENGINE_MOUSE_CLICK_MS,
+        .rollover_keys = SCRIPT_ENGINE_MAX_ROLLOVER_KEYS,
+    };
+
+    memset(engine, 0, sizeof(script_engine_t));
+    engine->transport = transport;
+    script_engine_set_config(engine, &default_config);
+}
+
+void script_engine_set_config(script_engine_t *engine, const script_engine_config_t *config)
+{
+    engine->config = *config;
+
+    if (engine->config.rollover_keys < 1)
+        engine->config.rollover_keys = 1;
+    else if (engine->config.rollover_keys > SCRIPT_ENGINE_MAX_ROLLOVER_KEYS)
+        engine->config.rollover_keys = SCRIPT_ENGINE_MAX_ROLLOVER_KEYS;
+}
+
+void script_engine_reset_stats(script_engine_t *engine)
+{
+    memset(&engine->stats, 0, sizeof(script_engine_stats_t));
+}
+
+bool script_engine_start(script_engine_t *engine, const uint8_t *script,
+                         uint8_t length, uint16_t tag, uint32_t now_ms)
+{
+    if (engine->running)
+        return false;
+
+    engine->script = script;
+    engine->length = (script != NULL) ? length : 0;
+    engine->tag = tag;
+    engine->pc = 0;
+    engine->step = 0;
+    engine->modifiers = 0x00;
+    engine->texts_count = 0;
+    engine->text_index = 0;
+    engine->text_pos = 0;
+    engine->held_count = 0;
+    engine->caps_lock_off = false;
+    engine->repeat_left = 0;
+    engine->pressed_count = 0;
+    engine->pressed_modifiers = 0x00;
+    engine->call_depth = 0;
+    engine->started_ms = now_ms;
+    engine->wake_ms = now_ms;
+    engine->running = true;
+
+    return true;
+}
+
+bool script_engine_poll(script_engine_t *engine, uint32_t now_ms)
+{
+    // steps with no pause after them are chained in the same poll
+    while (engine->running && (int32_t)(now_ms - engine->wake_ms) >= 0)
+        engine_step(engine, now_ms);
+
+    return engine->running;
+}
+
+bool script_engine_type_text(script_engine_t *engine, const char *text, uint8_t length)
+{
+    if (engine->texts_count >= SCRIPT_ENGINE_MAX_TEXTS)
+        return false;
+
+    engine->texts[engine->texts_count] = text;
+    engine->texts_length[engine->texts_count] = length;
+    engine->texts_count++;
+
+    return true;
+}
+
+void script_engine_run(script_engine_t *engine, const uint8_t *script, uint8_t length)
+{
+    uint32_t now_ms = 0; // only the elapsed time matters here
+
+    if (!script_engine_start(engine, script, length, 0, now_ms))
+        return;
+
+    while (script_engine_poll(engine, now_ms))
+    {
+        engine->transport->delay_ms(engine->transport->ctx, engine->wake_ms - now_ms);
+        now_ms = engine->wake_ms;
+    }
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static void engine_send_keyboard(script_engine_t *engine, uint8_t modifiers,
+                                 uint8_t *keys, uint8_t num_keys)
+{
+    engine->transport->send_keyboard(engine->transport->ctx, engine, modifiers, keys, num_keys);
+    engine->stats.reports_sent++;
+}
+
+static void engine_send_mouse(script_engine_t *engine, uint8_t buttons, int16_t x, int16_t y)
+{
+    engine->transport->send_mouse(engine->transport->ctx, engine, buttons, x, y, 0, 0);
+    engine->stats.reports_sent++;
+}
+
+static void engine_wait(script_engine_t *engine, uint32_t now_ms, uint32_t ms)
+{
+    engine->wake_ms = now_ms + ms;
+    engine->stats.delay_ms_total += ms;
+}
+
+static void engine_next_instruction(script_engine_t *engine, uint8_t op_length)
+{
+    engine->pc += op_length;
+    engine->step = 0;
+}
+
+static void engine_finish(script_engine_t *engine, uint32_t now_ms)
+{
+    // nothing stays pressed on the host once the script is over
+    if (engine->pressed_count || engine->pressed_modifiers)
+    {
+        engine->pressed_count = 0;
+        engine->pressed_modifiers = 0x00;
+        engine_send_keyboard(engine, 0, NULL, 0);
+    }
+
+    engine->running = false;
+    engine->stats.scripts_run++;
+    engine->stats.last_script_ms = now_ms - engine->started_ms;
+
+    if (engine->transport->finished)
+        engine->transport->finished(engine->transport->ctx, engine);
+}
+
+static void engine_step(script_engine_t *engine, uint32_t now_ms)
+{
+    uint8_t op;
+    uint8_t op_length;
+
+    // text queued by a special action goes out before the next instruction
+    if (engine->text_index < engine->texts_count)
+    {
+        engine_type_text(engine, now_ms);
+        return;
+    }
+
+    if (engine->repeat_left > 0 && engine->pc == engine->repeat_end)
+    {
+        engine->pc = engine->repeat_start;
+        engine->repeat_left--;
+    }
+
+    if (engine->pc >= engine->length)
+    {
+        if (engine->call_depth > 0)
+            engine_return(engine);
+        else if (engine->caps_lock_off)
+            engine_restore_caps_lock(engine, now_ms);
+        else
+            engine_finish(engine, now_ms);
+        return;
+    }
+
+    op = engine->script[engine->pc];
+    op_length = app_script_op_length(&engine->script[engine->pc], engine->length - engine->pc);
+    if (!op_length)
+    {
+        printf("script_engine: malformed opcode %d at %d\n", op, engine->pc);
+        engine_finish(engine, now_ms);
+        return;
+    }
+
+    if (op == APP_SCRIPT_OP_SPECIAL)
+    {
+        engine_special(engine, op_length);
+    }
+    else if (op >= APP_SCRIPT_OP_COMBINE_BASE + APP_SCRIPT_OP_COMBINE_MIN &&
+             op <= APP_SCRIPT_OP_COMBINE_BASE + APP_SCRIPT_OP_COMBINE_MAX)
+    {
+        engine_combine_keys(engine, &engine->script[engine->pc + 1],
+                            op - APP_SCRIPT_OP_COMBINE_BASE, op_length, now_ms);
+    }
+    else if (op == APP_SCRIPT_OP_MOUSE_MOVE)
+    {
+        engine_move(engine, &engine->script[engine->pc + 1], now_ms);
+    }
+    else if (op == APP_SCRIPT_OP_TAP)
+    {
+        engine_tap(engine, &engine->script[engine->pc + 1], now_ms);
+    }
+    else if (op == APP_SCRIPT_OP_CONSUMER)
+    {
+        engine_consumer(engine, engine->script[engine->pc + 1], now_ms);
+    }
+    else if (op == APP_SCRIPT_OP_PRESS)
+    {
+        engine_press(engine, engine->script[engine->pc + 1]);
+    }
+    else if (op == APP_SCRIPT_OP_RELEASE)
+    {
+        engine_release(engine, engine->script[engine->pc + 1]);
+    }
+    else if (op == APP_SCRIPT_OP_WAIT)
+    {
+        engine_wait(engine, now_ms, engine->script[engine->pc + 1] | (engine->script[engine->pc + 2] << 8));
+        engine_next_instruction(engine, op_length);
+    }
+    else if (op == APP_SCRIPT_OP_REPEAT)
+    {
+        engine_repeat(engine, engine->script[engine->pc + 1], engine->script[engine->pc + 2]);
+    }
+    else if (op == APP_SCRIPT_OP_JUMP_IF_LED)
+    {
+        engine_jump_if_led(engine, engine->script[engine->pc + 1], engine->script[engine->pc + 2]);
+    }
+    else if (op == APP_SCRIPT_OP_TYPE_STRING)
+    {
+        engine_type_string(engine, engine->script[engine->pc + 1]);
+    }
+    else if (op == APP_SCRIPT_OP_CALL)
+    {
+        engine_call(engine, engine->script[engine->pc + 1]);
+    }
+    else if (op >= APP_SCRIPT_OP_MOUSE_LEFT)
+    {
+        engine_click(engine, op, now_ms);
+    }
+    else
+    {
+        engine_press_key(engine, op, now_ms);
+    }
+}
+
+static void engine_special(script_engine_t *engine, uint8_t op_length)
+{
+    script_engine_special_result_t result = SCRIPT_ENGINE_SPECIAL_CONTINUE;
+    uint8_t pc = engine->pc;
+
+    if (engine->transport->run_special)
+        result = engine->transport->run_special(engine->transport->ctx, engine,
+                                                engine->script[pc + 1], engine->script);
+
+    if (result == SCRIPT_ENGINE_SPECIAL_STOP)
+    {
+        // whatever the action queued still gets typed, then the script
+        // ends, including the ones that CALLed it
+        op_length = engine->length - pc;
+        engine->repeat_left = 0;
+        engine->call_depth = 0;
+    }
+    else if (result == SCRIPT_ENGINE_SPECIAL_SKIP_NEXT && pc + op_length < engine->length)
+    {
+        op_length += app_script_op_length(&engine->script[pc + op_length],
+                                          engine->length - pc - op_length);
+    }
+
+    engine_next_instruction(engine, op_length);
+}
+
+// Presses all the keys one after the other (modifiers go in the mask),
+// then releases them in the same order. One key per step.
+static void engine_combine_keys(script_engine_t *engine, const uint8_t *keys, uint8_t num_keys,
+                                uint8_t op_length, uint32_t now_ms)
+{
+    uint8_t key = keys[engine->step % num_keys];
+    uint8_t pressed = (engine->step < num_keys); // press everything first, then release
+
+    if (key >= APP_SCRIPT_KEY_MODIFIER_FIRST && key <= APP_SCRIPT_KEY_MODIFIER_LAST)
+    {
+        engine->modifiers = (pressed) ? (engine->modifiers | APP_SCRIPT_KEY_MODIFIER_MASK(key))
+                                      : (engine->modifiers & ~APP_SCRIPT_KEY_MODIFIER_MASK(key));
+    }
+    engine_send_keyboard(engine, engine->modifiers, &key, pressed);
+    engine_wait(engine, now_ms, engine->config.combo_key_ms);
+
+    if (++engine->step >= 2 * num_keys)
+        engine_next_instruction(engine, op_length);
+}
+
+// Simulate a short 'click'
+static void engine_click(script_engine_t *engine, uint8_t mouse_op, uint32_t now_ms)
+{
+    uint8_t buttons;
+
+    if (engine->step == 0)
+    {
+        switch (mouse_op)
+        {
+        case APP_SCRIPT_OP_MOUSE_LEFT:
+            buttons = 0x01;
+            break;
+        case APP_SCRIPT_OP_MOUSE_MIDDLE:
+            buttons = 0x04;
+            break;
+        default:
+            buttons = 0x02;
+            break;
+        }
+
+        engine_send_mouse(engine, buttons, 0, 0);
+        engine_wait(engine, now_ms, engine->config.mouse_click_ms);
+        engine->step = 1;
+    }
+    else
+    {
+        engine_send_mouse(engine, 0x00, 0, 0);
+        engine_wait(engine, now_ms, engine->config.key_release_ms);
+        engine_next_instruction(engine, 1);
+    }
+}
+
+// The whole movement goes in one report, the host moves the pointer at once
+static void engine_move(script_engine_t *engine, const uint8_t *operands, uint32_t now_ms)
+{
+    int16_t x = (int16_t)(operands[0] | (operands[1] << 8));
+    int16_t y = (int16_t)(operands[2] | (operands[3] << 8));
+
+    engine_send_mouse(engine, 0x00, x, y);
+    engine_wait(engine, now_ms, engine->config.key_release_ms);
+    engine_next_instruction(engine, 5);
+}
+
+// Touches the screen at X%, Y% and lifts the finger, like a mouse click
+static void engine_tap(script_engine_t *engine, const uint8_t *operands, uint32_t now_ms)
+{
+    uint16_t x = (operands[0] > 100 ? 100 : operands[0]) * 100;
+    uint16_t y = (operands[1] > 100 ? 100 : operands[1]) * 100;
+
+    if (engine->transport->send_touch == NULL)
+    {
+        engine_next_instruction(engine, 3);
+        return;
+    }
+
+    engine->transport->send_touch(engine->transport->ctx, engine, engine->step == 0, x, y);
+    engine->stats.reports_sent++;
+
+    if (engine->step == 0)
+    {
+        engine_wait(engine, now_ms, engine->config.mouse_click_ms);
+        engine->step = 1;
+    }
+    else
+    {
+        engine_wait(engine, now_ms, engine->config.key_release_ms);
+        engine_next_instruction(engine, 3);
+    }
+}
+
+// Presses and releases a consumer control key (mute, volume, play...),
+// timed like a keyboard key
+static void engine_consumer(script_engine_t *engine, uint8_t usage, uint32_t now_ms)
+{
+    if (engine->transport->send_consumer == NULL)
+    {
+        engine_next_instruction(engine, 2);
+        return;
+    }
+
+    engine->transport->send_consumer(engine->transport->ctx, engine, usage, engine->step == 0);
+    engine->stats.reports_sent++;
+
+    if (engine->step == 0)
+    {
+        engine_wait(engine, now_ms, engine->config.key_press_ms);
+        engine->step = 1;
+    }
+    else
+    {
+        engine_wait(engine, now_ms, engine->config.key_release_ms);
+        engine_next_instruction(engine, 2);
+    }
+}
+
+// PRESS and RELEASE send their report right away and don't wait: the
+// script sets the timing with WAIT
+static void engine_press(script_engine_t *engine, uint8_t key)
+{
+    uint8_t i;
+
+    if (key >= APP_SCRIPT_KEY_MODIFIER_FIRST && key <= APP_SCRIPT_KEY_MODIFIER_LAST)
+    {
+        engine->pressed_modifiers |= APP_SCRIPT_KEY_MODIFIER_MASK(key);
+    }
+    else
+    {
+        for (i = 0; i < engine->pressed_count && engine->pressed_keys[i] != key; i++)
+            ;
+
+        if (i == engine->pressed_count && engine->pressed_count < SCRIPT_ENGINE_MAX_ROLLOVER_KEYS)
+            engine->pressed_keys[engine->pressed_count++] = key;
+        else if (i == engine->pressed_count)
+            printf("script_engine: too many keys held, %d not pressed\n", key);
+    }
+
+    engine_send_keyboard(engine, engine->pressed_modifiers, engine->pressed_keys, engine->pressed_count);
+    engine_next_instruction(engine, 2);
+}
+
+static void engine_release(script_engine_t *engine, uint8_t key)
+{
+    uint8_t i;
+
+    if (key == APP_SCRIPT_KEY_ALL)
+    {
+        engine->pressed_count = 0;
+        engine->pressed_modifiers = 0x00;
+    }
+    else if (key >= APP_SCRIPT_KEY_MODIFIER_FIRST && key <= APP_SCRIPT_KEY_MODIFIER_LAST)
+    {
+        engine->pressed_modifiers &= ~APP_SCRIPT_KEY_MODIFIER_MASK(key);
+    }
+    else
+    {
+        for (i = 0; i < engine->pressed_count; i++)
+        {
+            if (engine->pressed_keys[i] == key)
+            {
+                engine->pressed_count--;
+                memmove(&engine->pressed_keys[i], &engine->pressed_keys[i + 1], engine->pressed_count - i);
+                break;
+            }
+        }
+    }
+
+    engine_send_keyboard(engine, engine->pressed_modifiers, engine->pressed_keys, engine->pressed_count);
+    engine_next_instruction(engine, 2);
+}
+
+// The body is the next 'body_length' bytes, it runs 'count' times (none if 0)
+static void engine_repeat(script_engine_t *engine, uint8_t count, uint8_t body_length)
+{
+    uint16_t end = engine->pc + 3 + body_length;
+
+    if (end > engine->length)
+        end = engine->length;
+
+    if (count == 0)
+    {
+        engine->pc = end;
+        engine->step = 0;
+        return;
+    }
+
+    engine->repeat_start = engine->pc + 3;
+    engine->repeat_end = end;
+    engine->repeat_left = count - 1;
+    engine_next_instruction(engine, 3);
+}
+
+// Skips 'skip' bytes forward if any of the 'leds' is on at the host
+static void engine_jump_if_led(script_engine_t *engine, uint8_t leds, uint8_t skip)
+{
+    uint8_t host_leds = 0x00;
+    uint16_t target = engine->pc + 3;
+
+    if (engine->transport->get_leds)
+        host_leds = engine->transport->get_leds(engine->transport->ctx, engine);
+
+    if (host_leds & leds)
+        target += skip;
+
+    engine->pc = (target > engine->length) ? engine->length : target;
+    engine->step = 0;
+}
+
+// The string is typed before the next instruction, like the text queued
+// by a special action
+static void engine_type_string(script_engine_t *engine, uint8_t id)
+{
+    const char *text = NULL;
+    uint8_t length = 0;
+
+    if (engine->transport->get_string)
+        text = engine->transport->get_string(engine->transport->ctx, engine, id, &length);
+
+    if (text == NULL)
+        printf("script_engine: no string %d\n", id);
+    else if (!script_engine_type_text(engine, text, length))
+        printf("script_engine: string %d not typed, too much text queued\n", id);
+
+    engine_next_instruction(engine, 2);
+}
+
+// Runs another script, this one goes on when it ends
+static void engine_call(script_engine_t *engine, uint8_t id)
+{
+    script_engine_frame_t *frame;
+    const uint8_t *script = NULL;
+    uint8_t length = 0;
+
+    if (engine->call_depth >= SCRIPT_ENGINE_MAX_CALL_DEPTH)
+    {
+        printf("script_engine: CALL %d too deep\n", id);
+        engine_next_instruction(engine, 2);
+        return;
+    }
+
+    if (engine->transport->get_script)
+        script = engine->transport->get_script(engine->transport->ctx, engine, id, &length);
+
+    if (script == NULL)
+    {
+        printf("script_engine: no script %d to call\n", id);
+        engine_next_instruction(engine, 2);
+        return;
+    }
+
+    frame = &engine->calls[engine->call_depth++];
+    frame->script = engine->script;
+    frame->length = engine->length;
+    frame->pc = engine->pc + 2;
+    frame->repeat_start = engine->repeat_start;
+    frame->repeat_end = engine->repeat_end;
+    frame->repeat_left = engine->repeat_left;
+
+    engine->script = script;
+    engine->length = length;
+    engine->pc = 0;
+    engine->step = 0;
+    engine->repeat_left = 0;
+}
+
+static void engine_return(script_engine_t *engine)
+{
+    script_engine_frame_t *frame = &engine->calls[--engine->call_depth];
+
+    engine->script = frame->script;
+    engine->length = frame->length;
+    engine->pc = frame->pc;
+    engine->step = 0;
+    engine->repeat_start = frame->repeat_start;
+    engine->repeat_end = frame->repeat_end;
+    engine->repeat_left = frame->repeat_left;
+}
+
+static void engine_press_key(script_engine_t *engine, uint8_t key, uint32_t now_ms)
+{
+    if (engine->step == 0)
+    {
+        engine_send_keyboard(engine, 0, &key, 1);
+        engine_wait(engine, now_ms, engine->config.key_press_ms);
+        engine->step = 1;
+    }
+    else
+    {
+        engine_send_keyboard(engine, 0, &key, 0);
+        engine_wait(engine, now_ms, engine->config.key_release_ms);
+        engine_next_instruction(engine, 1);
+    }
+}
+
+// Types the queued text. Consecutive characters are pressed one more
+// per report (up to config.rollover_keys) and then released together.
+// If the host has CapsLock on, the letters would come out with the
+// wrong case: CapsLock is pressed before the chunk and stays off until
+// the script ends (the host LED report may still be on its way).
+// step: 0 = text chunk not started yet, 1 = press, 2 = release,
+// 3 = release CapsLock and type
+static void engine_type_text(script_engine_t *engine, uint32_t now_ms)
+{
+    const char *text = engine->texts[engine->text_index];
+    uint8_t length = engine->texts_length[engine->text_index];
+    uint8_t key;
+    uint8_t modifiers;
+
+    if (engine->step >= 2)
+    {
+        // release the keys and the modifiers (Shift, AltGr) together
+        engine_send_keyboard(engine, 0, engine->held_keys, 0);
+        engine_wait(engine, now_ms, engine->config.key_release_ms);
+        engine->held_count = 0;
+        engine->modifiers = 0x00;
+        engine->step = 1;
+        return;
+    }
+
+    if (engine->text_pos >= length)
+    {
+        // chunk done, the next one (or the script) is due right away
+        engine->text_index++;
+        engine->text_pos = 0;
+        engine->step = 0;
+        if (engine->text_index >= engine->texts_count)
+            engine->texts_count = engine->text_index = 0;
+        return;
+    }
+
+    if (engine->step == 0 && !engine->caps_lock_off && engine_text_needs_caps_lock_off(engine, text, length))
+    {
+        // this also releases whatever was still held down
+        key = HID_KEYMAP_CAPS_LOCK;
+        engine_send_keyboard(engine, 0, &key, 1);
+        engine_wait(engine, now_ms, engine->config.key_press_ms);
+        engine->caps_lock_off = true;
+        engine->step = 3;
+        return;
+    }
+
+    if (engine->step == 0)
+    {
+        // make sure nothing is still held down before typing
+        engine_send_keyboard(engine, 0, NULL, 0);
+        engine->step = 1;
+        return;
+    }
+
+    if (!hid_keymap_lookup(text[engine->text_pos], &key, &modifiers))
+    {
+        printf("script_engine: can't type '%c'\n", text[engine->text_pos]);
+        engine->text_pos++;
+        return;
+    }
+
+    engine->held_keys[engine->held_count++] = key;
+    engine->modifiers = modifiers;
+    engine_send_keyboard(engine, modifiers, engine->held_keys, engine->held_count);
+    engine->text_pos++;
+
+    // the next key rolls over in a report of its own right away: each
+    // report only adds a key, so the host sees the presses in order
+    // without a pause in between
+    if (!engine_text_can_roll_over(engine, text, length))
+    {
+        engine_wait(engine, now_ms, engine->config.key_press_ms);
+        engine->step = 2;
+    }
+}
+
+// True if the next character can be pressed while the ones typed so far
+// are still held down: same modifiers and not one of the held keys (a
+// repeated key needs a release in between or the host won't see it)
+static bool engine_text_can_roll_over(script_engine_t *engine, const char *text, uint8_t length)
+{
+    uint8_t key;
+    uint8_t modifiers;
+    uint8_t i;
+
+    if (engine->held_count >= engine->config.rollover_keys || engine->text_pos >= length)
+        return false;
+
+    if (!hid_keymap_lookup(text[engine->text_pos], &key, &modifiers) ||
+        modifiers != engine->modifiers)
+        return false;
+
+    for (i = 0; i < engine->held_count; i++)
+    {
+        if (engine->held_keys[i] == key)
+            return false;
+    }
+
+    return true;
+}
+
+// True if the host has CapsLock on and the text has letters
+static bool engine_text_needs_caps_lock_off(script_engine_t *engine, const char *text, uint8_t length)
+{
+    uint8_t i;
+
+    if (engine->transport->get_leds == NULL ||
+        !(engine->transport->get_leds(engine->transport->ctx, engine) & APP_SCRIPT_LED_CAPS_LOCK))
+        return false;
+
+    for (i = 0; i < length; i++)
+    {
+        if ((text[i] >= 'a' && text[i] <= 'z') || (text[i] >= 'A' && text[i] <= 'Z'))
+            return true;
+    }
+
+    return false;
+}
+
+// Turns the host CapsLock on again, like it was before typing
+static void engine_restore_caps_lock(script_engine_t *engine, uint32_t now_ms)
+{
+    uint8_t key = HID_KEYMAP_CAPS_LOCK;
+
+    if (engine->step == 0)
+    {
+        engine_send_keyboard(engine, 0, &key, 1);
+        engine_wait(engine, now_ms, engine->config.key_press_ms);
+        engine->step = 1;
+    }
+    else
+    {
+        engine_send_keyboard(engine, 0, &key, 0);
+        engine_wait(engine, now_ms, engine->config.key_release_ms);
+        engine->caps_lock_off = false;
+        engine->step = 0;
+    }
+}
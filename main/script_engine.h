@@ -0,0 +1,176 @@
+/*
+ * Interpreter for the compiled app control scripts (see app_script.h).
+ *
+ * The engine doesn't know anything about BLE or FreeRTOS: every report
+ * goes through the transport given at init time, so the same code runs
+ * on the device (esp_hidd_send_*) and on a host with a stub transport
+ * that just records the reports.
+ *
+ * A script is executed as a state machine: script_engine_start() loads
+ * it, then every script_engine_poll() sends the reports that are due and
+ * tells when the engine wants to be polled again. Nothing blocks in
+ * between, so whoever owns the engine (see script_executor.h) can keep
+ * doing other work while a script is streaming out.
+ */
+
+#ifndef SCRIPT_ENGINE_H
+#define SCRIPT_ENGINE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Default timings used while executing a script (in ms)
+#define SCRIPT_ENGINE_KEY_PRESS_MS 20   // between key press and release
+#define SCRIPT_ENGINE_KEY_RELEASE_MS 0  // between key release and the next step
+#define SCRIPT_ENGINE_COMBO_KEY_MS 10   // between the keys of a combination
+#define SCRIPT_ENGINE_MOUSE_CLICK_MS 50 // between mouse button press and release (or touch and lift)
+
+// Keys in a single keyboard report (6-key rollover). While typing text,
+// consecutive characters are pressed one more per report and released
+// all together; 1 means one key at a time, for the hosts that can't
+// keep up with that.
+#define SCRIPT_ENGINE_MAX_ROLLOVER_KEYS 6
+
+#define SCRIPT_ENGINE_MAX_TEXTS 4 // text chunks a single script can queue for typing
+
+#define SCRIPT_ENGINE_MAX_CALL_DEPTH 2 // scripts started by CALL, one inside the other
+
+    typedef struct script_engine script_engine_t;
+
+    // what the engine must do after a special action has been executed
+    typedef enum
+    {
+        SCRIPT_ENGINE_SPECIAL_CONTINUE,
+        SCRIPT_ENGINE_SPECIAL_SKIP_NEXT,
+        SCRIPT_ENGINE_SPECIAL_STOP,
+    } script_engine_special_result_t;
+
+    typedef struct
+    {
+        // 'engine' tells which script the report belongs to (e.g. by its tag)
+        void (*send_keyboard)(void *ctx, script_engine_t *engine, uint8_t modifiers,
+                              uint8_t *keys, uint8_t num_keys);
+        void (*send_mouse)(void *ctx, script_engine_t *engine, uint8_t buttons,
+                           int16_t x, int16_t y, int8_t wheel, int8_t pan);
+        // 'usage' is one of HID_CONSUMER_*, released with pressed = false
+        void (*send_consumer)(void *ctx, script_engine_t *engine, uint8_t usage, bool pressed);
+        // absolute position in 0.01% of the screen (0..10000)
+        void (*send_touch)(void *ctx, script_engine_t *engine, bool touching,
+                           uint16_t x, uint16_t y);
+        void (*delay_ms)(void *ctx, uint32_t ms); // only used by script_engine_run()
+        script_engine_special_result_t (*run_special)(void *ctx, script_engine_t *engine,
+                                                      uint8_t special_index, const uint8_t *script);
+        // host keyboard LEDs (APP_SCRIPT_LED_*) for JUMP_IF_LED and to type with
+        // CapsLock off, optional: all off
+        uint8_t (*get_leds)(void *ctx, script_engine_t *engine);
+        // text of TYPE_STRING, valid until the script ends, NULL if unknown (optional)
+        const char *(*get_string)(void *ctx, script_engine_t *engine, uint8_t id, uint8_t *length);
+        // compiled script for CALL, NULL if unknown (optional)
+        const uint8_t *(*get_script)(void *ctx, script_engine_t *engine, uint8_t id, uint8_t *length);
+        void (*finished)(void *ctx, script_engine_t *engine); // optional
+        void *ctx;
+    } script_engine_transport_t;
+
+    typedef struct
+    {
+        uint16_t key_press_ms;
+        uint16_t key_release_ms;
+        uint16_t combo_key_ms;
+        uint16_t mouse_click_ms;
+        uint8_t rollover_keys; // 1..SCRIPT_ENGINE_MAX_ROLLOVER_KEYS
+    } script_engine_config_t;
+
+    // where a CALL returns to
+    typedef struct
+    {
+        const uint8_t *script;
+        uint8_t length;
+        uint8_t pc;
+        uint8_t repeat_start;
+        uint8_t repeat_end;
+        uint8_t repeat_left;
+    } script_engine_frame_t;
+
+    typedef struct
+    {
+        uint32_t scripts_run;
+        uint32_t reports_sent;
+        uint32_t delay_ms_total;   // time spent waiting since the last reset
+        uint32_t last_script_ms;   // time taken by the last script
+    } script_engine_stats_t;
+
+    struct script_engine
+    {
+        const script_engine_transport_t *transport;
+        script_engine_config_t config;
+        script_engine_stats_t stats;
+
+        // state of the script being executed
+        bool running;
+        uint16_t tag;        // owner defined, e.g. which button started the script
+        const uint8_t *script;
+        uint8_t length;
+        uint8_t pc;          // next instruction to execute
+        uint8_t step;        // progress inside the current instruction
+        uint8_t modifiers;   // modifier keys currently held down
+        uint32_t started_ms;
+        uint32_t wake_ms;    // when the next step is due
+
+        // REPEAT: the body runs again while repeat_left > 0
+        uint8_t repeat_start;
+        uint8_t repeat_end;
+        uint8_t repeat_left;
+
+        // keys held down by PRESS until RELEASE (or the end of the script)
+        uint8_t pressed_keys[SCRIPT_ENGINE_MAX_ROLLOVER_KEYS];
+        uint8_t pressed_count;
+        uint8_t pressed_modifiers;
+
+        script_engine_frame_t calls[SCRIPT_ENGINE_MAX_CALL_DEPTH];
+        uint8_t call_depth;
+
+        // text queued by special actions, typed before the next instruction
+        const char *texts[SCRIPT_ENGINE_MAX_TEXTS];
+        uint8_t texts_length[SCRIPT_ENGINE_MAX_TEXTS];
+        uint8_t texts_count;
+        uint8_t text_index;
+        uint8_t text_pos;
+        uint8_t held_keys[SCRIPT_ENGINE_MAX_ROLLOVER_KEYS]; // typed keys still pressed
+        uint8_t held_count;
+        bool caps_lock_off; // the host CapsLock was on, turned off while typing
+    };
+
+    void script_engine_init(script_engine_t *engine, const script_engine_transport_t *transport);
+
+    void script_engine_set_config(script_engine_t *engine, const script_engine_config_t *config);
+
+    // Loads a compiled script, the first step is due at 'now_ms'.
+    // Returns false if the engine is still busy with another script.
+    bool script_engine_start(script_engine_t *engine, const uint8_t *script,
+                             uint8_t length, uint16_t tag, uint32_t now_ms);
+
+    // Executes all the steps due at 'now_ms'. Returns true while the
+    // script is still running, engine->wake_ms is the next deadline.
+    bool script_engine_poll(script_engine_t *engine, uint32_t now_ms);
+
+    // Queues text to be typed with the layout selected in hid_keymap.h
+    // (only from a special action, the text must stay valid until the
+    // script ends). Returns false if full.
+    bool script_engine_type_text(script_engine_t *engine, const char *text, uint8_t length);
+
+    // Runs a whole compiled script through transport->delay_ms, returns
+    // when the last report is sent
+    void script_engine_run(script_engine_t *engine, const uint8_t *script, uint8_t length);
+
+    void script_engine_reset_stats(script_engine_t *engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCRIPT_ENGINE_H */
@@ -0,0 +1,329 @@
+/*
+ * Background execution of the app control scripts, see script_executor.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "script_executor.h"
+#include "event_bus.h"
+
+typedef enum
+{
+    SCRIPT_EXECUTOR_RUN,
+    SCRIPT_EXECUTOR_SET_CONFIG,
+} script_executor_request_type_t;
+
+typedef struct
+{
+    script_executor_request_type_t type;
+    const uint8_t *script;
+    uint8_t length;
+    uint16_t tag;
+    uint32_t event_us;
+    script_engine_config_t config;
+} script_executor_request_t;
+
+static xQueueHandle script_executor_queue = NULL;
+static script_engine_t script_executor_engines[SCRIPT_EXECUTOR_MAX_RUNNING];
+// input time of the scripts that haven't sent their first report yet, 0 if none
+static uint32_t script_executor_event_us[SCRIPT_EXECUTOR_MAX_RUNNING];
+static const uint16_t script_executor_latency_limits_ms[SCRIPT_EXECUTOR_LATENCY_BUCKETS - 1] =
+    SCRIPT_EXECUTOR_LATENCY_BUCKETS_MS;
+static script_executor_latency_t script_executor_latency;
+static portMUX_TYPE script_executor_latency_mux = portMUX_INITIALIZER_UNLOCKED;
+// scripts queued or running: a script is accepted only if an engine will be free for it
+static uint8_t script_executor_reserved = 0;
+static portMUX_TYPE script_executor_reserved_mux = portMUX_INITIALIZER_UNLOCKED;
+// written by the executor task only, the other tasks read it under the lock
+static portMUX_TYPE script_executor_config_mux = portMUX_INITIALIZER_UNLOCKED;
+static script_engine_config_t script_executor_config = {
+    .key_press_ms = CONFIG_HID_SCRIPT_KEY_PRESS_MS,
+    .key_release_ms = CONFIG_HID_SCRIPT_KEY_RELEASE_MS,
+    .combo_key_ms = CONFIG_HID_SCRIPT_COMBO_KEY_MS,
+    .mouse_click_ms = CONFIG_HID_SCRIPT_MOUSE_CLICK_MS,
+    .rollover_keys = CONFIG_HID_SCRIPT_ROLLOVER_KEYS,
+};
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static uint32_t script_executor_now_ms(void);
+static bool script_executor_reserve(void);
+static void script_executor_release(void);
+static bool script_executor_start(const script_executor_request_t *request);
+static TickType_t script_executor_next_wait(uint32_t now_ms);
+static void script_executor_poll(uint8_t index, uint32_t now_ms);
+static void script_executor_latency_add(uint32_t latency_us);
+static void script_executor_publish(event_bus_type_t type, const script_engine_t *engine);
+static void script_executor_task(void *pvParameters);
+
+// FUNCTION DEFINITIONS
+
+void script_executor_init(const script_engine_transport_t *transport)
+{
+    uint8_t i;
+
+    for (i = 0; i < SCRIPT_EXECUTOR_MAX_RUNNING; i++)
+    {
+        script_engine_init(&script_executor_engines[i], transport);
+        script_engine_set_config(&script_executor_engines[i], &script_executor_config);
+    }
+
+    script_executor_reset_latency();
+
+    script_executor_queue = xQueueCreate(SCRIPT_EXECUTOR_QUEUE_LENGTH, sizeof(script_executor_request_t));
+    xTaskCreate(script_executor_task, "script_task", 3072, NULL, 8, NULL);
+}
+
+bool script_executor_submit(const uint8_t *script, uint8_t length, uint16_t tag, uint32_t event_us)
+{
+    script_executor_request_t request = {
+        .type = SCRIPT_EXECUTOR_RUN,
+        .script = script,
+        .length = length,
+        .tag = tag,
+        .event_us = event_us,
+    };
+
+    if (script_executor_queue == NULL || !script_executor_reserve())
+        return false;
+
+    if (xQueueSend(script_executor_queue, &request, 0) != pdTRUE)
+    {
+        script_executor_release();
+        return false;
+    }
+
+    return true;
+}
+
+void script_executor_get_config(script_engine_config_t *config)
+{
+    portENTER_CRITICAL(&script_executor_config_mux);
+    *config = script_executor_config;
+    portEXIT_CRITICAL(&script_executor_config_mux);
+}
+
+bool script_executor_set_config(const script_engine_config_t *config)
+{
+    script_executor_request_t request = {
+        .type = SCRIPT_EXECUTOR_SET_CONFIG,
+        .config = *config,
+    };
+
+    if (script_executor_queue == NULL)
+        return false;
+
+    return xQueueSend(script_executor_queue, &request, 0) == pdTRUE;
+}
+
+void script_executor_get_latency(script_executor_latency_t *latency)
+{
+    portENTER_CRITICAL(&script_executor_latency_mux);
+    *latency = script_executor_latency;
+    portEXIT_CRITICAL(&script_executor_latency_mux);
+}
+
+void script_executor_reset_latency(void)
+{
+    portENTER_CRITICAL(&script_executor_latency_mux);
+    memset(&script_executor_latency, 0, sizeof(script_executor_latency));
+    script_executor_latency.min_us = UINT32_MAX;
+    portEXIT_CRITICAL(&script_executor_latency_mux);
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static uint32_t script_executor_now_ms(void)
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+static bool script_executor_reserve(void)
+{
+    bool reserved = false;
+
+    portENTER_CRITICAL(&script_executor_reserved_mux);
+    if (script_executor_reserved < SCRIPT_EXECUTOR_MAX_RUNNING)
+    {
+        script_executor_reserved++;
+        reserved = true;
+    }
+    portEXIT_CRITICAL(&script_executor_reserved_mux);
+
+    return reserved;
+}
+
+static void script_executor_release(void)
+{
+    portENTER_CRITICAL(&script_executor_reserved_mux);
+    if (script_executor_reserved > 0)
+        script_executor_reserved--;
+    portEXIT_CRITICAL(&script_executor_reserved_mux);
+}
+
+// Returns false if no engine is free, script_executor_submit() already
+// refuses the scripts that wouldn't find one
+static bool script_executor_start(const script_executor_request_t *request)
+{
+    uint8_t i;
+    script_engine_t *engine;
+
+    for (i = 0; i < SCRIPT_EXECUTOR_MAX_RUNNING; i++)
+    {
+        engine = &script_executor_engines[i];
+        if (!engine->running)
+        {
+            script_engine_set_config(engine, &script_executor_config);
+            script_engine_start(engine, request->script, request->length,
+                                request->tag, script_executor_now_ms());
+            script_executor_event_us[i] = request->event_us;
+            script_executor_publish(EVENT_BUS_SCRIPT_STARTED, engine);
+            return true;
+        }
+    }
+
+    printf("script_executor: all engines busy, script %d dropped\n", request->tag);
+    script_executor_release();
+    return false;
+}
+
+// How long the task can sleep before the first engine needs a poll
+static TickType_t script_executor_next_wait(uint32_t now_ms)
+{
+    uint8_t i;
+    bool busy = false;
+    int32_t wait_ms = 0;
+    int32_t engine_wait_ms;
+
+    for (i = 0; i < SCRIPT_EXECUTOR_MAX_RUNNING; i++)
+    {
+        if (!script_executor_engines[i].running)
+            continue;
+
+        engine_wait_ms = (int32_t)(script_executor_engines[i].wake_ms - now_ms);
+        if (!busy || engine_wait_ms < wait_ms)
+            wait_ms = engine_wait_ms;
+        busy = true;
+    }
+
+    if (!busy)
+        return portMAX_DELAY;
+    if (wait_ms <= 0)
+        return 0;
+
+    // round up, waking up early would only mean polling twice
+    return (wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+}
+
+// Polls one engine, the first report of a script closes its latency sample
+static void script_executor_poll(uint8_t index, uint32_t now_ms)
+{
+    script_engine_t *engine = &script_executor_engines[index];
+    uint32_t reports_sent = engine->stats.reports_sent;
+    uint32_t poll_us;
+
+    if (!engine->running)
+        return;
+
+    if (script_executor_event_us[index] == 0)
+    {
+        if (!script_engine_poll(engine, now_ms))
+        {
+            script_executor_release();
+            script_executor_publish(EVENT_BUS_SCRIPT_FINISHED, engine);
+        }
+        return;
+    }
+
+    // taken right before the poll that sends the report
+    poll_us = (uint32_t)esp_timer_get_time();
+    script_engine_poll(engine, now_ms);
+
+    if (engine->stats.reports_sent != reports_sent)
+    {
+        script_executor_latency_add(poll_us - script_executor_event_us[index]);
+        script_executor_event_us[index] = 0;
+    }
+    else if (!engine->running)
+    {
+        // the script ended without sending anything
+        script_executor_event_us[index] = 0;
+    }
+
+    if (!engine->running)
+    {
+        script_executor_release();
+        script_executor_publish(EVENT_BUS_SCRIPT_FINISHED, engine);
+    }
+}
+
+static void script_executor_publish(event_bus_type_t type, const script_engine_t *engine)
+{
+    event_bus_event_t event = {
+        .type = type,
+        .script.tag = engine->tag,
+        .script.engine = (uint8_t)(engine - script_executor_engines),
+        .script.reports_sent = engine->stats.reports_sent,
+        .script.duration_ms = (type == EVENT_BUS_SCRIPT_FINISHED) ? engine->stats.last_script_ms : 0,
+    };
+
+    event_bus_publish(&event);
+}
+
+static void script_executor_latency_add(uint32_t latency_us)
+{
+    uint8_t bucket = 0;
+
+    while (bucket < SCRIPT_EXECUTOR_LATENCY_BUCKETS - 1 &&
+           latency_us >= script_executor_latency_limits_ms[bucket] * 1000)
+        bucket++;
+
+    portENTER_CRITICAL(&script_executor_latency_mux);
+    script_executor_latency.buckets[bucket]++;
+    script_executor_latency.count++;
+    script_executor_latency.total_us += latency_us;
+    if (latency_us < script_executor_latency.min_us)
+        script_executor_latency.min_us = latency_us;
+    if (latency_us > script_executor_latency.max_us)
+        script_executor_latency.max_us = latency_us;
+    portEXIT_CRITICAL(&script_executor_latency_mux);
+}
+
+static void script_executor_task(void *pvParameters)
+{
+    script_executor_request_t request;
+    uint32_t now_ms;
+    uint8_t i;
+
+    while (1)
+    {
+        if (xQueueReceive(script_executor_queue, &request,
+                          script_executor_next_wait(script_executor_now_ms())) == pdTRUE)
+        {
+            switch (request.type)
+            {
+            case SCRIPT_EXECUTOR_RUN:
+                script_executor_start(&request);
+                break;
+            case SCRIPT_EXECUTOR_SET_CONFIG:
+                portENTER_CRITICAL(&script_executor_config_mux);
+                script_executor_config = request.config;
+                portEXIT_CRITICAL(&script_executor_config_mux);
+                break;
+            default:
+                break;
+            }
+        }
+
+        now_ms = script_executor_now_ms();
+        for (i = 0; i < SCRIPT_EXECUTOR_MAX_RUNNING; i++)
+            script_executor_poll(i, now_ms);
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * Runs the app control scripts in the background.
+ *
+ * A dedicated task owns a small pool of script engines. Scripts are
+ * submitted through a queue and the task sleeps on that queue until the
+ * earliest deadline among the running engines, so whoever submits a
+ * script (the button task) never waits for the reports to go out.
+ *
+ * The executor also measures the input latency: the time between the
+ * button interrupt that caused a script and its first report.
+ */
+
+#ifndef SCRIPT_EXECUTOR_H
+#define SCRIPT_EXECUTOR_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "script_engine.h"
+
+#define SCRIPT_EXECUTOR_MAX_RUNNING 2 // scripts that can be executed at the same time
+#define SCRIPT_EXECUTOR_QUEUE_LENGTH 4
+
+// upper bounds (in ms, excluded) of the latency histogram buckets, the
+// last bucket takes everything above
+#define SCRIPT_EXECUTOR_LATENCY_BUCKETS_MS {1, 2, 5, 10, 20, 50, 100}
+#define SCRIPT_EXECUTOR_LATENCY_BUCKETS 8
+
+    typedef struct
+    {
+        uint32_t buckets[SCRIPT_EXECUTOR_LATENCY_BUCKETS];
+        uint32_t count;
+        uint32_t min_us;
+        uint32_t max_us;
+        uint64_t total_us;
+    } script_executor_latency_t;
+
+    // Creates the executor task, 'transport' must stay valid forever
+    void script_executor_init(const script_engine_transport_t *transport);
+
+    // Queues a compiled script for execution, doesn't block. 'tag' is
+    // handed back in engine->tag to the transport callbacks, 'event_us' is
+    // the esp_timer time of the input that caused it (0 to leave it out
+    // of the latency histogram). Returns false, and the script is not
+    // run, if the queue is full or SCRIPT_EXECUTOR_MAX_RUNNING scripts
+    // are already queued or running.
+    bool script_executor_submit(const uint8_t *script, uint8_t length, uint16_t tag, uint32_t event_us);
+
+    // Settings applied to all the scripts started from now on
+    void script_executor_get_config(script_engine_config_t *config);
+    bool script_executor_set_config(const script_engine_config_t *config);
+
+    // Input to first report latency of the scripts run since the last reset
+    void script_executor_get_latency(script_executor_latency_t *latency);
+    void script_executor_reset_latency(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCRIPT_EXECUTOR_H */
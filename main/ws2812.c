@@ -10,6 +10,7 @@
 #include "ws2812.h"
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <soc/rmt_struct.h>
 #include <soc/dport_reg.h>
 #include <driver/gpio.h>
@@ -47,11 +48,28 @@ typedef union {
   uint32_t val;
 } rmtPulsePair;
 
+typedef struct {
+  uint8_t grb[WS2812_MAX_LEDS * 3];
+  unsigned int len;
+  ws2812_doneCallback done;
+  void *ctx;
+} ws2812_frame;
+
+/* one frame on the wire, one waiting: both are only touched by the
+   submitter while they're free, and swapped by the interrupt */
+static ws2812_frame ws2812_frames[2];
+static unsigned int ws2812_tx;
+static bool ws2812_active, ws2812_pending;
+static portMUX_TYPE ws2812_mux = portMUX_INITIALIZER_UNLOCKED;
+
 static uint8_t *ws2812_buffer = NULL;
 static unsigned int ws2812_pos, ws2812_len, ws2812_half;
-static xSemaphoreHandle ws2812_sem = NULL;
+static xSemaphoreHandle ws2812_sem = NULL; /* for ws2812_setColors */
 static intr_handle_t rmt_intr_handle = NULL;
 static rmtPulsePair ws2812_bits[2];
+/* the 8 pulses of every byte value, MSB first, built by ws2812_init so
+   the interrupt only copies words */
+static rmtPulsePair ws2812_pulses[256][8];
 
 void ws2812_initRMTChannel(int rmtChannel)
 {
@@ -75,7 +93,9 @@ void ws2812_initRMTChannel(int rmtChannel)
 
 void ws2812_copy()
 {
-  unsigned int i, j, offset, len, bit;
+  unsigned int i, j, offset, len;
+  const rmtPulsePair *pulses;
+  volatile uint32_t *dest;
 
 
   offset = ws2812_half * MAX_PULSES;
@@ -92,11 +112,11 @@ void ws2812_copy()
   }
 
   for (i = 0; i < len; i++) {
-    bit = ws2812_buffer[i + ws2812_pos];
-    for (j = 0; j < 8; j++, bit <<= 1) {
-      RMTMEM.chan[RMTCHANNEL].data32[j + i * 8 + offset].val =
-	ws2812_bits[(bit >> 7) & 0x01].val;
-    }
+    /* the RMT memory takes 32 bit writes only, no memcpy */
+    pulses = ws2812_pulses[ws2812_buffer[i + ws2812_pos]];
+    dest = &RMTMEM.chan[RMTCHANNEL].data32[i * 8 + offset].val;
+    for (j = 0; j < 8; j++)
+      dest[j] = pulses[j].val;
     if (i + ws2812_pos == ws2812_len - 1)
       RMTMEM.chan[RMTCHANNEL].data32[7 + i * 8 + offset].duration1 = PULSE_TRS;
   }
@@ -108,25 +128,74 @@ void ws2812_copy()
   return;
 }
 
+/* Loads ws2812_frames[ws2812_tx] in the RMT and starts it */
+static void ws2812_start()
+{
+  ws2812_buffer = ws2812_frames[ws2812_tx].grb;
+  ws2812_len = ws2812_frames[ws2812_tx].len;
+  ws2812_pos = 0;
+  ws2812_half = 0;
+
+  ws2812_copy();
+
+  if (ws2812_pos < ws2812_len)
+    ws2812_copy();
+
+  RMT.conf_ch[RMTCHANNEL].conf1.mem_rd_rst = 1;
+  RMT.conf_ch[RMTCHANNEL].conf1.tx_start = 1;
+
+  return;
+}
+
 void ws2812_handleInterrupt(void *arg)
 {
-  portBASE_TYPE taskAwoken = 0;
+  ws2812_doneCallback done = NULL;
+  void *ctx = NULL;
 
 
   if (RMT.int_st.ch0_tx_thr_event) {
     ws2812_copy();
     RMT.int_clr.ch0_tx_thr_event = 1;
   }
-  else if (RMT.int_st.ch0_tx_end && ws2812_sem) {
-    xSemaphoreGiveFromISR(ws2812_sem, &taskAwoken);
+  else if (RMT.int_st.ch0_tx_end) {
     RMT.int_clr.ch0_tx_end = 1;
+
+    portENTER_CRITICAL_ISR(&ws2812_mux);
+    done = ws2812_frames[ws2812_tx].done;
+    ctx = ws2812_frames[ws2812_tx].ctx;
+    if (ws2812_pending) {
+      ws2812_tx = !ws2812_tx;
+      ws2812_pending = false;
+      ws2812_start();
+    }
+    else
+      ws2812_active = false;
+    portEXIT_CRITICAL_ISR(&ws2812_mux);
+
+    if (done)
+      done(ctx);
   }
 
   return;
 }
 
+static void ws2812_wakeSetColors(void *ctx)
+{
+  portBASE_TYPE taskAwoken = 0;
+
+
+  xSemaphoreGiveFromISR(ws2812_sem, &taskAwoken);
+  if (taskAwoken)
+    portYIELD_FROM_ISR();
+
+  return;
+}
+
 void ws2812_init(int gpioNum)
 {
+  unsigned int i, j;
+
+
   DPORT_SET_PERI_REG_MASK(DPORT_PERIP_CLK_EN_REG, DPORT_RMT_CLK_EN);
   DPORT_CLEAR_PERI_REG_MASK(DPORT_PERIP_RST_EN_REG, DPORT_RMT_RST);
 
@@ -147,43 +216,63 @@ void ws2812_init(int gpioNum)
   ws2812_bits[1].duration0 = PULSE_T1H;
   ws2812_bits[1].duration1 = PULSE_T1L;
 
+  for (i = 0; i < 256; i++)
+    for (j = 0; j < 8; j++)
+      ws2812_pulses[i][j] = ws2812_bits[(i >> (7 - j)) & 0x01];
+
+  ws2812_sem = xSemaphoreCreateBinary();
+
   esp_intr_alloc(ETS_RMT_INTR_SOURCE, 0, ws2812_handleInterrupt, NULL, &rmt_intr_handle);
 
   return;
 }
 
-void ws2812_setColors(unsigned int length, rgbVal *array)
+bool ws2812_submit(unsigned int length, const rgbVal *array,
+		   ws2812_doneCallback done, void *ctx)
 {
   unsigned int i;
+  ws2812_frame *frame;
 
 
-  ws2812_len = (length * 3) * sizeof(uint8_t);
-  ws2812_buffer = malloc(ws2812_len);
+  if (length > WS2812_MAX_LEDS)
+    length = WS2812_MAX_LEDS;
 
-  for (i = 0; i < length; i++) {
-    ws2812_buffer[0 + i * 3] = array[i].g; // changed the order of the colors (was grb)
-    ws2812_buffer[1 + i * 3] = array[i].r;
-    ws2812_buffer[2 + i * 3] = array[i].b;
+  portENTER_CRITICAL(&ws2812_mux);
+
+  if (ws2812_pending) {
+    portEXIT_CRITICAL(&ws2812_mux);
+    return false;
   }
 
-  ws2812_pos = 0;
-  ws2812_half = 0;
+  frame = &ws2812_frames[ws2812_active ? !ws2812_tx : ws2812_tx];
+  frame->len = (length * 3) * sizeof(uint8_t);
+  frame->done = done;
+  frame->ctx = ctx;
 
-  ws2812_copy();
+  for (i = 0; i < length; i++) {
+    frame->grb[0 + i * 3] = array[i].g; // changed the order of the colors (was grb)
+    frame->grb[1 + i * 3] = array[i].r;
+    frame->grb[2 + i * 3] = array[i].b;
+  }
 
-  if (ws2812_pos < ws2812_len)
-    ws2812_copy();
+  if (ws2812_active)
+    ws2812_pending = true;
+  else {
+    ws2812_active = true;
+    ws2812_start();
+  }
 
-  ws2812_sem = xSemaphoreCreateBinary();
+  portEXIT_CRITICAL(&ws2812_mux);
 
-  RMT.conf_ch[RMTCHANNEL].conf1.mem_rd_rst = 1;
-  RMT.conf_ch[RMTCHANNEL].conf1.tx_start = 1;
+  return true;
+}
 
-  xSemaphoreTake(ws2812_sem, portMAX_DELAY);
-  vSemaphoreDelete(ws2812_sem);
-  ws2812_sem = NULL;
+void ws2812_setColors(unsigned int length, rgbVal *array)
+{
+  while (!ws2812_submit(length, array, ws2812_wakeSetColors, NULL))
+    vTaskDelay(1);
 
-  free(ws2812_buffer);
+  xSemaphoreTake(ws2812_sem, portMAX_DELAY);
 
   return;
 }
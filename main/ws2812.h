@@ -10,6 +10,9 @@
 #define WS2812_DRIVER_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#define WS2812_MAX_LEDS 32 /* size of the static frame buffers */
 
 typedef union {
   struct __attribute__ ((packed)) {
@@ -18,7 +21,18 @@ typedef union {
   uint32_t num;
 } rgbVal;
 
+/* Called from the RMT interrupt when a frame has been sent */
+typedef void (*ws2812_doneCallback)(void *ctx);
+
 extern void ws2812_init(int gpioNum);
+
+/* Copies the frame and returns right away, the frame is sent as soon as
+   the one on the wire (if any) is done. Returns false if another frame
+   is already waiting, try again later. 'done' can be NULL. */
+extern bool ws2812_submit(unsigned int length, const rgbVal *array,
+			  ws2812_doneCallback done, void *ctx);
+
+/* Same as ws2812_submit, but waits until the frame has been sent */
 extern void ws2812_setColors(unsigned int length, rgbVal *array);
 
 inline rgbVal makeRGBVal(uint8_t r, uint8_t g, uint8_t b)
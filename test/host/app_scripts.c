@@ -0,0 +1,47 @@
+/*
+ * App control scripts on the host, see app_scripts.h
+ */
+
+#include <string.h>
+
+#include "app_scripts.h"
+
+// FUNCTION DEFINITIONS
+
+uint8_t app_scripts_compile(app_script_image_t *image, app_scripts_entry_t entries[APP_SCRIPTS_TOTAL])
+{
+    const app_control_scripts_t *app;
+    uint8_t count = 0;
+    uint8_t i, k;
+
+    app_script_image_reset(image);
+
+    for (i = 0; i < CONTROL_SCRIPTS_SETS; i++)
+    {
+        app = &app_control_scripts[i];
+        for (k = 0; k < app->num_of_scripts && count < APP_SCRIPTS_TOTAL; k++, count++)
+        {
+            entries[count].name = app->rows[k].name;
+            entries[count].app = app->app_control_id;
+            entries[count].offset = app_script_compile(image, app->rows[k].steps,
+                                                       app->max_steps_per_script + 1);
+        }
+    }
+
+    return count;
+}
+
+script_engine_special_result_t app_scripts_run_special(void *ctx, script_engine_t *engine,
+                                                       uint8_t special_index, const uint8_t *script)
+{
+    if (special_index == 1) // type_and_connect_meeting2() only prints
+        return SCRIPT_ENGINE_SPECIAL_CONTINUE;
+
+    // type_and_connect_meeting()
+    if (special_index != 0 ||
+        !script_engine_type_text(engine, MEETING1_ID, strlen(MEETING1_ID)) ||
+        !script_engine_type_text(engine, MEETING1_PASSCODE, strlen(MEETING1_PASSCODE)))
+        return SCRIPT_ENGINE_SPECIAL_STOP;
+
+    return SCRIPT_ENGINE_SPECIAL_CONTINUE;
+}
@@ -0,0 +1,44 @@
+/*
+ * The app control scripts of app_control_scripts.c, compiled on the host
+ * from the same table and in the same order as app_control_init() on the
+ * device.
+ */
+
+#ifndef APP_SCRIPTS_H
+#define APP_SCRIPTS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_script.h"
+#include "hid_app_control.h"
+
+#define APP_SCRIPTS_TOTAL (CONTROL_SCRIPTS_SETS * CONTROL_SCRIPTS_MAX_SCRIPTS)
+
+    typedef struct
+    {
+        const char *name; // e.g. "ZOOM_CONTROL_MOBILE_TOGGLE_MIC"
+        uint8_t app;      // *_CONTROL_*_ID
+        uint16_t offset;  // inside the image, APP_SCRIPT_INVALID_OFFSET if refused
+    } app_scripts_entry_t;
+
+    // Compiles every script into 'image' (reset first), 'entries' gets one
+    // entry per script, in order. Returns the number of scripts.
+    uint8_t app_scripts_compile(app_script_image_t *image, app_scripts_entry_t entries[APP_SCRIPTS_TOTAL]);
+
+    // Special actions like the device ones (see hid_app_control.c), for
+    // the recording transport: SPECIAL 0 types the meeting id and the
+    // passcode, 1 does nothing, the others stop the script
+    script_engine_special_result_t app_scripts_run_special(void *ctx, script_engine_t *engine,
+                                                           uint8_t special_index, const uint8_t *script);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APP_SCRIPTS_H */
@@ -0,0 +1,295 @@
+/*
+ * hid_dev send path on the host: main/hid_dev.c runs on top of a stubbed
+ * GATT layer that records the reports instead of sending them.
+ *
+ * First checks what reaches the "link": the handle picked from each
+ * connection's own protocol mode, repeats coalesced, reports held back by
+ * a congestion or missing TX credits and flushed in order afterwards.
+ * Then counts reports per second through hid_dev_send_report(), and
+ * times the table scan the handle cache replaced (kept here as the
+ * reference) to show its share of a report.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "hidd_le_prf_int.h"
+#include "esp_timer.h"
+
+#define BENCH_SENDS 5000000
+
+// attribute handles of the reports, as hid_device_le_prf.c would register them
+#define BENCH_HANDLE_MOUSE 0x20
+#define BENCH_HANDLE_KEY 0x24
+#define BENCH_HANDLE_CC 0x28
+#define BENCH_HANDLE_LED 0x2c
+#define BENCH_HANDLE_BOOT_KEY 0x30
+#define BENCH_HANDLE_BOOT_LED 0x32
+#define BENCH_HANDLE_BOOT_MOUSE 0x34
+#define BENCH_HANDLE_FEATURE 0x38
+#define BENCH_HANDLE_TOUCH 0x3c
+
+#define BENCH_GATT_IF 3
+
+// report lengths, as esp_hidd_prf_api.c sends them
+#define BENCH_KEY_LEN 8
+#define BENCH_TOUCH_LEN 5
+
+static hid_report_map_t bench_reports[HID_NUM_REPORTS] = {
+    {BENCH_HANDLE_MOUSE, 0, HID_RPT_ID_MOUSE_IN, HID_TYPE_INPUT, HID_PROTOCOL_MODE_REPORT},
+    {BENCH_HANDLE_KEY, 0, HID_RPT_ID_KEY_IN, HID_TYPE_INPUT, HID_PROTOCOL_MODE_REPORT},
+    {BENCH_HANDLE_CC, 0, HID_RPT_ID_CC_IN, HID_TYPE_INPUT, HID_PROTOCOL_MODE_REPORT},
+    {BENCH_HANDLE_LED, 0, HID_RPT_ID_LED_OUT, HID_TYPE_OUTPUT, HID_PROTOCOL_MODE_REPORT},
+    {BENCH_HANDLE_BOOT_KEY, 0, HID_RPT_ID_KEY_IN, HID_TYPE_INPUT, HID_PROTOCOL_MODE_BOOT},
+    {BENCH_HANDLE_BOOT_LED, 0, HID_RPT_ID_LED_OUT, HID_TYPE_OUTPUT, HID_PROTOCOL_MODE_BOOT},
+    {BENCH_HANDLE_BOOT_MOUSE, 0, HID_RPT_ID_MOUSE_IN, HID_TYPE_INPUT, HID_PROTOCOL_MODE_BOOT},
+    {BENCH_HANDLE_FEATURE, 0, HID_RPT_ID_FEATURE, HID_TYPE_FEATURE, HID_PROTOCOL_MODE_REPORT},
+    {BENCH_HANDLE_TOUCH, 0, HID_RPT_ID_TOUCH_IN, HID_TYPE_INPUT, HID_PROTOCOL_MODE_REPORT},
+};
+
+// the stubbed link
+static uint16_t bench_credits = 0xffff; // esp_ble_get_cur_sendable_packets_num()
+static uint32_t bench_indications = 0;
+static char bench_log[256];              // "conn:handle" of each report when logging
+static bool bench_logging = false;
+
+// the connections, owned by hid_device_le_prf.c on the device
+hidd_le_env_t hidd_le_env;
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void bench_connect(uint16_t conn_id);
+static void bench_disconnect(uint16_t conn_id);
+static void bench_send_key(uint16_t conn_id, uint8_t key);
+static const char *bench_take_log(void);
+static void bench_checks(void);
+static hid_report_map_t *bench_scan(uint8_t id, uint8_t type, uint8_t mode);
+static double bench_seconds(void);
+static void bench_send_path(void);
+
+// FUNCTION DEFINITIONS
+
+esp_err_t __attribute__((noinline)) esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id,
+                                                                 uint16_t attr_handle, uint16_t value_len,
+                                                                 uint8_t *value, bool need_confirm)
+{
+    size_t length;
+
+    bench_indications++;
+    if (bench_logging)
+    {
+        length = strlen(bench_log);
+        snprintf(bench_log + length, sizeof(bench_log) - length, "%s%u:%02x", length ? " " : "", conn_id,
+                 attr_handle);
+    }
+
+    return ESP_OK;
+}
+
+uint16_t esp_ble_get_cur_sendable_packets_num(uint16_t connid)
+{
+    return bench_credits;
+}
+
+hidd_clcb_t *hidd_clcb_find(uint16_t conn_id)
+{
+    for (uint8_t i_clcb = 0; i_clcb < HID_MAX_APPS; i_clcb++)
+    {
+        if (hidd_le_env.hidd_clcb[i_clcb].in_use && hidd_le_env.hidd_clcb[i_clcb].conn_id == conn_id)
+            return &hidd_le_env.hidd_clcb[i_clcb];
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    hid_dev_register_reports(HID_NUM_REPORTS, bench_reports);
+    hid_dev_tx_init();
+
+    bench_checks();
+    bench_send_path();
+
+    return HOST_TEST_RESULT();
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+// What hidd_clcb_alloc() and the connect event do
+static void bench_connect(uint16_t conn_id)
+{
+    for (uint8_t i = 0; i < HID_MAX_APPS; i++)
+    {
+        if (!hidd_le_env.hidd_clcb[i].in_use)
+        {
+            memset(&hidd_le_env.hidd_clcb[i], 0, sizeof(hidd_clcb_t));
+            hidd_le_env.hidd_clcb[i].in_use = true;
+            hidd_le_env.hidd_clcb[i].conn_id = conn_id;
+            hidd_le_env.hidd_clcb[i].proto_mode = HID_PROTOCOL_MODE_REPORT;
+            break;
+        }
+    }
+    hid_dev_tx_open(conn_id);
+}
+
+static void bench_disconnect(uint16_t conn_id)
+{
+    hidd_clcb_t *p_clcb = hidd_clcb_find(conn_id);
+
+    hid_dev_tx_close(conn_id);
+    if (p_clcb != NULL)
+        p_clcb->in_use = false;
+}
+
+static void bench_send_key(uint16_t conn_id, uint8_t key)
+{
+    uint8_t report[BENCH_KEY_LEN] = {0, 0, key};
+
+    hid_dev_send_report(BENCH_GATT_IF, conn_id, HID_RPT_ID_KEY_IN, HID_TYPE_INPUT, sizeof(report), report);
+}
+
+static const char *bench_take_log(void)
+{
+    static char log[sizeof(bench_log)];
+
+    strcpy(log, bench_log);
+    bench_log[0] = '\0';
+
+    return log;
+}
+
+static void bench_checks(void)
+{
+    uint8_t touch[BENCH_TOUCH_LEN] = {0};
+    hid_dev_tx_stats_t stats;
+
+    bench_logging = true;
+    bench_connect(0);
+    bench_connect(1);
+    HOST_CHECK(hid_dev_get_protocol_mode(0) == HID_PROTOCOL_MODE_REPORT);
+    HOST_CHECK(hid_dev_get_protocol_mode(7) == HID_PROTOCOL_MODE_REPORT); // unknown connection
+
+    // the PC's BIOS switches its connection to boot mode, the phone stays in report mode
+    hid_dev_set_protocol_mode(1, HID_PROTOCOL_MODE_BOOT);
+    hid_dev_set_protocol_mode(0, 0x7f); // ignored
+    HOST_CHECK(hid_dev_get_protocol_mode(0) == HID_PROTOCOL_MODE_REPORT);
+    HOST_CHECK(hid_dev_get_protocol_mode(1) == HID_PROTOCOL_MODE_BOOT);
+
+    bench_send_key(0, HID_KEY_A);
+    bench_send_key(1, HID_KEY_A);
+    HOST_CHECK_STR(bench_take_log(), "0:24 1:30");
+
+    // no touch report in boot mode
+    hid_dev_send_report(BENCH_GATT_IF, 1, HID_RPT_ID_TOUCH_IN, HID_TYPE_INPUT, sizeof(touch), touch);
+    hid_dev_send_report(BENCH_GATT_IF, 0, HID_RPT_ID_TOUCH_IN, HID_TYPE_INPUT, sizeof(touch), touch);
+    HOST_CHECK_STR(bench_take_log(), "0:3c");
+
+    // the same keys again are coalesced
+    bench_send_key(0, HID_KEY_A);
+    bench_send_key(0, 0);
+    HOST_CHECK_STR(bench_take_log(), "0:24");
+
+    // held back by a congestion, then sent in order
+    hid_dev_tx_set_congested(0, true);
+    bench_send_key(0, HID_KEY_B);
+    bench_send_key(0, 0);
+    bench_send_key(1, 0);
+    HOST_CHECK_STR(bench_take_log(), "1:30");
+    hid_dev_tx_set_congested(0, false);
+    HOST_CHECK_STR(bench_take_log(), "0:24 0:24");
+
+    // out of TX credits: the retry timer sends them once credits are back
+    bench_credits = 1;
+    bench_send_key(0, HID_KEY_C);
+    bench_credits = 0;
+    bench_send_key(0, 0);
+    bench_send_key(0, HID_KEY_D);
+    HOST_CHECK_STR(bench_take_log(), "0:24");
+    HOST_CHECK(esp_timer_host_fire() == 1);
+    HOST_CHECK_STR(bench_take_log(), "");
+    bench_credits = 0xffff;
+    HOST_CHECK(esp_timer_host_fire() == 1);
+    HOST_CHECK_STR(bench_take_log(), "0:24 0:24");
+    HOST_CHECK(esp_timer_host_fire() == 0);
+
+    // reports of a closed connection are dropped, the queue is freed
+    bench_disconnect(1);
+    bench_send_key(1, HID_KEY_E);
+    HOST_CHECK_STR(bench_take_log(), "");
+    bench_connect(2);
+    HOST_CHECK(hid_dev_get_protocol_mode(2) == HID_PROTOCOL_MODE_REPORT);
+    bench_send_key(2, HID_KEY_E);
+    HOST_CHECK_STR(bench_take_log(), "2:24");
+
+    hid_dev_get_tx_stats(&stats);
+    HOST_CHECK(stats.sent == 11);
+    HOST_CHECK(stats.coalesced == 1);
+    HOST_CHECK(stats.retried == 2); // the head of the queue, once congested, once without credits
+    HOST_CHECK(stats.dropped == 1);
+
+    bench_disconnect(0);
+    bench_disconnect(2);
+    bench_logging = false;
+}
+
+// The lookup hid_dev_send_report() did on every report before the cache
+static hid_report_map_t * __attribute__((noinline)) bench_scan(uint8_t id, uint8_t type, uint8_t mode)
+{
+    hid_report_map_t *rpt = bench_reports;
+
+    for (uint8_t i = HID_NUM_REPORTS; i > 0; i--, rpt++)
+    {
+        if (rpt->id == id && rpt->type == type && rpt->mode == mode)
+            return rpt;
+    }
+
+    return NULL;
+}
+
+static double bench_seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void bench_send_path(void)
+{
+    // a key pressed and released: no two reports in a row are equal
+    uint8_t reports[2][BENCH_KEY_LEN] = {{0, 0, HID_KEY_A}, {0}};
+    hid_dev_tx_stats_t before, after;
+    uint32_t indications;
+    uint32_t handles = 0;
+    double start, scan_s, send_s;
+    uint32_t i;
+
+    bench_connect(0);
+
+    hid_dev_get_tx_stats(&before);
+    indications = bench_indications;
+    start = bench_seconds();
+    for (i = 0; i < BENCH_SENDS; i++)
+        hid_dev_send_report(BENCH_GATT_IF, 0, HID_RPT_ID_KEY_IN, HID_TYPE_INPUT, BENCH_KEY_LEN, reports[i & 1]);
+    send_s = bench_seconds() - start;
+    hid_dev_get_tx_stats(&after);
+
+    HOST_CHECK(after.sent - before.sent == BENCH_SENDS);
+    HOST_CHECK(bench_indications - indications == BENCH_SENDS);
+
+    // the touch report is the last one of the table: the worst case of the scan
+    start = bench_seconds();
+    for (i = 0; i < BENCH_SENDS; i++)
+        handles += bench_scan(HID_RPT_ID_TOUCH_IN, HID_TYPE_INPUT, hid_dev_get_protocol_mode(0))->handle;
+    scan_s = bench_seconds() - start;
+
+    HOST_CHECK(handles == BENCH_SENDS * BENCH_HANDLE_TOUCH);
+
+    printf("hid_dev_send_report: %.1f M reports/s, %.1f ns/report\n", BENCH_SENDS / send_s / 1e6,
+           send_s / BENCH_SENDS * 1e9);
+    printf("table scan replaced by the handle cache: %.1f ns/report\n", scan_s / BENCH_SENDS * 1e9);
+
+    bench_disconnect(0);
+}
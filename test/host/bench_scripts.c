@@ -0,0 +1,100 @@
+/*
+ * Script engine benchmark on the host.
+ *
+ * Runs the app control scripts through the recording transport. For
+ * every script it prints the reports it sends and its virtual latency:
+ * when the first report goes out and when the last one does, with the
+ * default timings. Then it runs them all in a loop and prints how many
+ * scripts (and reports) per second the engine itself gets through.
+ *
+ * usage: bench_scripts [runs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "app_script.h"
+#include "script_engine.h"
+#include "recording_transport.h"
+#include "app_scripts.h"
+
+#define BENCH_SCRIPTS_RUNS 1000000
+
+static app_script_image_t bench_image;
+static app_scripts_entry_t bench_entries[APP_SCRIPTS_TOTAL];
+static recording_transport_t bench_recording;
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static double bench_now_s(void);
+
+// FUNCTION DEFINITIONS
+
+int main(int argc, char **argv)
+{
+    uint32_t runs = (argc > 1) ? strtoul(argv[1], NULL, 0) : BENCH_SCRIPTS_RUNS;
+    const uint8_t *scripts[APP_SCRIPTS_TOTAL];
+    uint8_t lengths[APP_SCRIPTS_TOTAL];
+    script_engine_t engine;
+    uint8_t count, used = 0;
+    uint32_t duration_ms, reports = 0;
+    uint32_t i;
+    double start_s, elapsed_s;
+
+    count = app_scripts_compile(&bench_image, bench_entries);
+
+    recording_transport_init(&bench_recording);
+    bench_recording.run_special = app_scripts_run_special;
+    script_engine_init(&engine, &bench_recording.transport);
+
+    printf("%-40s %5s %7s %9s %9s\n", "script", "bytes", "reports", "first ms", "total ms");
+    for (i = 0; i < count; i++)
+    {
+        if (bench_entries[i].offset == APP_SCRIPT_INVALID_OFFSET)
+        {
+            printf("%s doesn't compile\n", bench_entries[i].name);
+            return 1;
+        }
+
+        scripts[used] = app_script_get(&bench_image, bench_entries[i].offset, &lengths[used]);
+        if (lengths[used] == 0)
+            continue; // nothing defined yet
+
+        recording_transport_clear(&bench_recording);
+        bench_recording.now_ms = 0;
+        duration_ms = recording_transport_run(&bench_recording, &engine, scripts[used], lengths[used]);
+
+        printf("%-40s %5d %7u %9u %9u\n", bench_entries[i].name, lengths[used],
+               bench_recording.count, bench_recording.first_report_ms, duration_ms);
+        used++;
+    }
+
+    if (used == 0)
+        return 1;
+
+    // throughput of the engine alone, the reports are only counted
+    bench_recording.keep = false;
+    recording_transport_clear(&bench_recording);
+
+    start_s = bench_now_s();
+    for (i = 0; i < runs; i++)
+        recording_transport_run(&bench_recording, &engine, scripts[i % used], lengths[i % used]);
+    elapsed_s = bench_now_s() - start_s;
+    reports = bench_recording.count;
+
+    printf("%u scripts, %u reports in %.3f s: %.0f scripts/s, %.0f reports/s\n",
+           runs, reports, elapsed_s, runs / elapsed_s, reports / elapsed_s);
+
+    return 0;
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static double bench_now_s(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
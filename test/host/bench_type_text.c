@@ -0,0 +1,79 @@
+/*
+ * Text typing benchmark on the host.
+ *
+ * Types a few strings through the recording transport, one key per
+ * report (rollover 1, how text used to be typed) and with 6-key
+ * rollover, and prints the reports sent and the virtual milliseconds
+ * each string takes with the default timings.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "app_script.h"
+#include "script_engine.h"
+#include "hid_app_control.h"
+#include "recording_transport.h"
+
+static const char *const bench_strings[] = {
+    MEETING1_ID,
+    MEETING1_PASSCODE,
+    "https://zoom.us/j/12345670?pwd=coMeValavita",
+    "The quick brown fox jumps over the lazy dog",
+};
+
+static recording_transport_t bench_recording;
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static uint32_t bench_type(const char *text, uint8_t rollover_keys, uint32_t *reports);
+
+// FUNCTION DEFINITIONS
+
+int main(void)
+{
+    uint32_t serial_ms, serial_reports;
+    uint32_t rollover_ms, rollover_reports;
+    uint8_t i;
+
+    printf("%-45s %5s | %8s %8s | %8s %8s | %7s\n", "text", "chars",
+           "reports", "ms", "reports", "ms", "speedup");
+    printf("%-45s %5s | %17s | %17s |\n", "", "", "1 key per report", "6-key rollover");
+
+    for (i = 0; i < sizeof(bench_strings) / sizeof(bench_strings[0]); i++)
+    {
+        serial_ms = bench_type(bench_strings[i], 1, &serial_reports);
+        rollover_ms = bench_type(bench_strings[i], SCRIPT_ENGINE_MAX_ROLLOVER_KEYS, &rollover_reports);
+
+        printf("%-45s %5zu | %8u %8u | %8u %8u | %6.2fx\n", bench_strings[i], strlen(bench_strings[i]),
+               serial_reports, serial_ms, rollover_reports, rollover_ms,
+               rollover_ms ? (double)serial_ms / rollover_ms : 0.0);
+    }
+
+    return 0;
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+// Types 'text' with TYPE_STRING, returns the virtual ms it takes
+static uint32_t bench_type(const char *text, uint8_t rollover_keys, uint32_t *reports)
+{
+    static const uint8_t script[] = {APP_SCRIPT_OP_TYPE_STRING, 0};
+    script_engine_t engine;
+    script_engine_config_t config;
+    uint32_t duration_ms;
+
+    recording_transport_init(&bench_recording);
+    bench_recording.keep = false;
+    bench_recording.strings[0] = text;
+
+    script_engine_init(&engine, &bench_recording.transport);
+    config = engine.config;
+    config.rollover_keys = rollover_keys;
+    script_engine_set_config(&engine, &config);
+
+    duration_ms = recording_transport_run(&bench_recording, &engine, script, sizeof(script));
+    *reports = bench_recording.count;
+
+    return duration_ms;
+}
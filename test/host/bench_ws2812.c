@@ -0,0 +1,286 @@
+/*
+ * ws2812 RMT refill on the host: main/ws2812.c writes into a plain copy
+ * of the RMT memory (stub/rmt_host.c) and the test plays the interrupts.
+ *
+ * Every half of the RMT memory the driver fills is compared with what
+ * the bit loop the pulse table replaced (kept here as the reference)
+ * writes for the same bytes, over all 256 byte values, and two frames
+ * submitted back to back must go out one after the other. Then both
+ * refills are timed over whole frames, in ns per color byte.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "ws2812.h"
+#include "soc/rmt_struct.h"
+
+#define BENCH_FRAMES 200000
+#define BENCH_BYTES (WS2812_MAX_LEDS * 3)
+
+// as in ws2812.c
+#define BENCH_CHANNEL 0
+#define BENCH_PULSES 32 // half of the channel memory
+#define BENCH_T0H 7     // 350 ns in 50 ns ticks
+#define BENCH_T1H 18
+#define BENCH_T0L 18
+#define BENCH_T1L 7
+#define BENCH_TRS 1000 // reset, after the last bit
+
+typedef struct
+{
+    uint8_t grb[BENCH_BYTES];
+    unsigned int pos;
+    unsigned int half;
+} bench_bit_loop_t;
+
+static rmt_item32_t bench_bits[2];
+static unsigned int bench_done = 0;
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void bench_done_callback(void *ctx);
+static void bench_colors(rgbVal *colors, unsigned int first_byte);
+static void bench_bit_loop_copy(bench_bit_loop_t *loop, volatile rmt_item32_t *mem);
+static void bench_interrupt(bool end);
+static void bench_check_half(const bench_bit_loop_t *expected);
+static void bench_check_frame(const rgbVal *colors);
+static void bench_check_chaining(void);
+static double bench_seconds(void);
+static void bench_refill(void);
+
+// the RMT interrupt handler of ws2812.c, the host calls it itself
+void ws2812_handleInterrupt(void *arg);
+
+// FUNCTION DEFINITIONS
+
+int main(void)
+{
+    rgbVal colors[WS2812_MAX_LEDS];
+
+    ws2812_init(18);
+
+    bench_bits[0].level0 = 1;
+    bench_bits[0].duration0 = BENCH_T0H;
+    bench_bits[0].duration1 = BENCH_T0L;
+    bench_bits[1].level0 = 1;
+    bench_bits[1].duration0 = BENCH_T1H;
+    bench_bits[1].duration1 = BENCH_T1L;
+
+    // all the byte values, through full frames
+    for (unsigned int first = 0; first < 256; first += BENCH_BYTES)
+    {
+        bench_colors(colors, first);
+        bench_check_frame(colors);
+    }
+
+    bench_check_chaining();
+    bench_refill();
+
+    return HOST_TEST_RESULT();
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static void bench_done_callback(void *ctx)
+{
+    bench_done++;
+}
+
+// A frame whose color bytes, in wire (GRB) order, count from 'first_byte'
+static void bench_colors(rgbVal *colors, unsigned int first_byte)
+{
+    for (unsigned int i = 0; i < WS2812_MAX_LEDS; i++)
+    {
+        colors[i].g = (uint8_t)(first_byte + i * 3);
+        colors[i].r = (uint8_t)(first_byte + i * 3 + 1);
+        colors[i].b = (uint8_t)(first_byte + i * 3 + 2);
+    }
+}
+
+// ws2812_copy() before the pulse table: one lookup and shift per bit
+static void bench_bit_loop_copy(bench_bit_loop_t *loop, volatile rmt_item32_t *mem)
+{
+    unsigned int i, j, offset, len, bit;
+
+    offset = loop->half * BENCH_PULSES;
+    loop->half = !loop->half;
+
+    len = BENCH_BYTES - loop->pos;
+    if (len > (BENCH_PULSES / 8))
+        len = (BENCH_PULSES / 8);
+
+    if (!len)
+    {
+        for (i = 0; i < BENCH_PULSES; i++)
+            mem[i + offset].val = 0;
+        return;
+    }
+
+    for (i = 0; i < len; i++)
+    {
+        bit = loop->grb[i + loop->pos];
+        for (j = 0; j < 8; j++, bit <<= 1)
+            mem[j + i * 8 + offset].val = bench_bits[(bit >> 7) & 0x01].val;
+        if (i + loop->pos == BENCH_BYTES - 1)
+            mem[7 + i * 8 + offset].duration1 = BENCH_TRS;
+    }
+
+    for (i *= 8; i < BENCH_PULSES; i++)
+        mem[i + offset].val = 0;
+
+    loop->pos += len;
+}
+
+// What the RMT raises: a half has been sent, or the end marker reached
+static void bench_interrupt(bool end)
+{
+    RMT.int_st.ch0_tx_thr_event = !end;
+    RMT.int_st.ch0_tx_end = end;
+    ws2812_handleInterrupt(NULL);
+    RMT.int_st.ch0_tx_thr_event = 0;
+    RMT.int_st.ch0_tx_end = 0;
+}
+
+// The half the reference just wrote must be what the driver wrote
+static void bench_check_half(const bench_bit_loop_t *expected)
+{
+    static rmt_item32_t mem[2 * BENCH_PULSES];
+    bench_bit_loop_t loop = *expected;
+    unsigned int offset = loop.half * BENCH_PULSES;
+    unsigned int i, wrong = 0;
+
+    bench_bit_loop_copy(&loop, mem);
+    for (i = 0; i < BENCH_PULSES; i++)
+    {
+        if (RMTMEM.chan[BENCH_CHANNEL].data32[i + offset].val != mem[i + offset].val)
+            wrong++;
+    }
+    HOST_CHECK(wrong == 0);
+}
+
+// Sends a frame the way the RMT would, checking every refill
+static void bench_check_frame(const rgbVal *colors)
+{
+    bench_bit_loop_t expected = {.pos = 0, .half = 0};
+    static rmt_item32_t scratch[2 * BENCH_PULSES];
+    unsigned int done = bench_done;
+
+    for (unsigned int i = 0; i < WS2812_MAX_LEDS; i++)
+    {
+        expected.grb[i * 3] = colors[i].g;
+        expected.grb[i * 3 + 1] = colors[i].r;
+        expected.grb[i * 3 + 2] = colors[i].b;
+    }
+
+    // both halves are filled before the start
+    HOST_CHECK(ws2812_submit(WS2812_MAX_LEDS, colors, bench_done_callback, NULL));
+    bench_check_half(&expected);
+    bench_bit_loop_copy(&expected, scratch);
+    bench_check_half(&expected);
+    bench_bit_loop_copy(&expected, scratch);
+
+    // then one half each time the other one has been sent, up to a zero half
+    while (expected.pos < BENCH_BYTES)
+    {
+        bench_interrupt(false);
+        bench_check_half(&expected);
+        bench_bit_loop_copy(&expected, scratch);
+    }
+    bench_interrupt(false);
+    bench_check_half(&expected);
+
+    HOST_CHECK(bench_done == done);
+    bench_interrupt(true);
+    HOST_CHECK(bench_done == done + 1);
+}
+
+// A frame submitted while one is on the wire waits for it, a third is refused
+static void bench_check_chaining(void)
+{
+    rgbVal first[WS2812_MAX_LEDS], second[WS2812_MAX_LEDS];
+    unsigned int done;
+    unsigned int i;
+
+    bench_colors(first, 0x10);
+    bench_colors(second, 0x80);
+
+    HOST_CHECK(ws2812_submit(WS2812_MAX_LEDS, first, bench_done_callback, NULL));
+    HOST_CHECK(ws2812_submit(WS2812_MAX_LEDS, second, bench_done_callback, NULL));
+    HOST_CHECK(!ws2812_submit(WS2812_MAX_LEDS, first, bench_done_callback, NULL));
+
+    // the first frame: 24 halves with data, both in place at the start, then a zero half
+    for (i = 0; i < BENCH_BYTES / 4 - 1; i++)
+        bench_interrupt(false);
+    done = bench_done;
+    bench_interrupt(true);
+    HOST_CHECK(bench_done == done + 1);
+
+    // the second one has been started: its first bytes are in the RMT memory
+    HOST_CHECK(RMTMEM.chan[BENCH_CHANNEL].data32[0].val == bench_bits[(0x80 >> 7) & 1].val);
+    HOST_CHECK(RMTMEM.chan[BENCH_CHANNEL].data32[1].val == bench_bits[(0x80 >> 6) & 1].val);
+    for (i = 0; i < BENCH_BYTES / 4 - 1; i++)
+        bench_interrupt(false);
+    bench_interrupt(true);
+    HOST_CHECK(bench_done == done + 2);
+
+    // idle again
+    HOST_CHECK(ws2812_submit(WS2812_MAX_LEDS, first, bench_done_callback, NULL));
+    for (i = 0; i < BENCH_BYTES / 4 - 1; i++)
+        bench_interrupt(false);
+    bench_interrupt(true);
+    HOST_CHECK(bench_done == done + 3);
+}
+
+static double bench_seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Whole frames: the color bytes copied, then all the refills
+static void bench_refill(void)
+{
+    rgbVal colors[WS2812_MAX_LEDS];
+    bench_bit_loop_t loop;
+    double start, table_s, bit_loop_s;
+    unsigned int done = bench_done;
+    unsigned int frame, i;
+
+    bench_colors(colors, 0x5a);
+
+    start = bench_seconds();
+    for (frame = 0; frame < BENCH_FRAMES; frame++)
+    {
+        ws2812_submit(WS2812_MAX_LEDS, colors, bench_done_callback, NULL);
+        for (i = 0; i < BENCH_BYTES / 4 - 1; i++)
+            bench_interrupt(false);
+        bench_interrupt(true);
+    }
+    table_s = bench_seconds() - start;
+    HOST_CHECK(bench_done == done + BENCH_FRAMES);
+
+    start = bench_seconds();
+    for (frame = 0; frame < BENCH_FRAMES; frame++)
+    {
+        for (i = 0; i < WS2812_MAX_LEDS; i++)
+        {
+            loop.grb[i * 3] = colors[i].g;
+            loop.grb[i * 3 + 1] = colors[i].r;
+            loop.grb[i * 3 + 2] = colors[i].b;
+        }
+        loop.pos = 0;
+        loop.half = 0;
+        for (i = 0; i < BENCH_BYTES / 4 + 1; i++)
+            bench_bit_loop_copy(&loop, RMTMEM.chan[BENCH_CHANNEL].data32);
+    }
+    bit_loop_s = bench_seconds() - start;
+
+    printf("bit loop:    %.2f ns/byte\n", bit_loop_s / BENCH_FRAMES / BENCH_BYTES * 1e9);
+    printf("pulse table: %.2f ns/byte (interrupt handling included)\n",
+           table_s / BENCH_FRAMES / BENCH_BYTES * 1e9);
+}
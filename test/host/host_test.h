@@ -0,0 +1,44 @@
+/*
+ * Checks for the host tests: a failed check is printed and counted, the
+ * test goes on and main() returns HOST_TEST_RESULT() for ctest.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+
+static int host_test_checks = 0;
+static int host_test_failures = 0;
+
+#define HOST_CHECK(condition)                                                   \
+    do                                                                          \
+    {                                                                           \
+        host_test_checks++;                                                     \
+        if (!(condition))                                                       \
+        {                                                                       \
+            host_test_failures++;                                               \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        }                                                                       \
+    } while (0)
+
+#define HOST_CHECK_STR(actual, expected)                                                \
+    do                                                                                  \
+    {                                                                                   \
+        const char *host_test_actual_ = (actual);                                       \
+        const char *host_test_expected_ = (expected);                                   \
+        host_test_checks++;                                                             \
+        if (strcmp(host_test_actual_, host_test_expected_) != 0)                        \
+        {                                                                               \
+            host_test_failures++;                                                       \
+            printf("%s:%d: got      %s\n%s:%d: expected %s\n", __FILE__, __LINE__,     \
+                   host_test_actual_, __FILE__, __LINE__, host_test_expected_);         \
+        }                                                                               \
+    } while (0)
+
+#define HOST_TEST_RESULT()                                                        \
+    (printf("%d checks, %d failed\n", host_test_checks, host_test_failures),      \
+     host_test_failures ? 1 : 0)
+
+#endif /* HOST_TEST_H */
@@ -0,0 +1,232 @@
+/*
+ * Recording script engine transport, see recording_transport.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "recording_transport.h"
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static recorded_report_t *recording_add(recording_transport_t *recording, recorded_report_type_t type);
+static void recording_send_keyboard(void *ctx, script_engine_t *engine, uint8_t modifiers,
+                                    uint8_t *keys, uint8_t num_keys);
+static void recording_send_mouse(void *ctx, script_engine_t *engine, uint8_t buttons,
+                                 int16_t x, int16_t y, int8_t wheel, int8_t pan);
+static void recording_send_consumer(void *ctx, script_engine_t *engine, uint8_t usage, bool pressed);
+static void recording_send_touch(void *ctx, script_engine_t *engine, bool touching,
+                                 uint16_t x, uint16_t y);
+static void recording_delay_ms(void *ctx, uint32_t ms);
+static script_engine_special_result_t recording_run_special(void *ctx, script_engine_t *engine,
+                                                            uint8_t special_index, const uint8_t *script);
+static uint8_t recording_get_leds(void *ctx, script_engine_t *engine);
+static const char *recording_get_string(void *ctx, script_engine_t *engine, uint8_t id, uint8_t *length);
+static const uint8_t *recording_get_script(void *ctx, script_engine_t *engine, uint8_t id, uint8_t *length);
+static void recording_finished(void *ctx, script_engine_t *engine);
+
+// FUNCTION DEFINITIONS
+
+void recording_transport_init(recording_transport_t *recording)
+{
+    memset(recording, 0, sizeof(*recording));
+
+    recording->transport.send_keyboard = recording_send_keyboard;
+    recording->transport.send_mouse = recording_send_mouse;
+    recording->transport.send_consumer = recording_send_consumer;
+    recording->transport.send_touch = recording_send_touch;
+    recording->transport.delay_ms = recording_delay_ms;
+    recording->transport.run_special = recording_run_special;
+    recording->transport.get_leds = recording_get_leds;
+    recording->transport.get_string = recording_get_string;
+    recording->transport.get_script = recording_get_script;
+    recording->transport.finished = recording_finished;
+    recording->transport.ctx = recording;
+    recording->keep = true;
+}
+
+void recording_transport_clear(recording_transport_t *recording)
+{
+    recording->count = 0;
+    recording->first_report_ms = 0;
+}
+
+size_t recording_transport_format(const recording_transport_t *recording, char *text, size_t size)
+{
+    const recorded_report_t *report;
+    size_t length = 0;
+    uint32_t i;
+    uint8_t k;
+
+    if (size > 0)
+        text[0] = '\0';
+
+#define RECORDING_PRINT(...)                                                          \
+    length += snprintf(text + ((length < size) ? length : size),                      \
+                       (length < size) ? size - length : 0, __VA_ARGS__)
+
+    for (i = 0; i < recording->count && i < RECORDING_TRANSPORT_MAX_REPORTS && recording->keep; i++)
+    {
+        report = &recording->reports[i];
+
+        switch (report->type)
+        {
+        case RECORDED_KEYBOARD:
+            RECORDING_PRINT("[%02x:", report->keyboard.modifiers);
+            for (k = 0; k < report->keyboard.num_keys; k++)
+                RECORDING_PRINT((k == 0) ? "%02x" : ",%02x", report->keyboard.keys[k]);
+            RECORDING_PRINT("]");
+            break;
+        case RECORDED_MOUSE:
+            RECORDING_PRINT("{%d,%d,%d,%d,%d}", report->mouse.buttons, report->mouse.x,
+                            report->mouse.y, report->mouse.wheel, report->mouse.pan);
+            break;
+        case RECORDED_CONSUMER:
+            RECORDING_PRINT("<%d%c>", report->consumer.usage, report->consumer.pressed ? '+' : '-');
+            break;
+        case RECORDED_TOUCH:
+            if (report->touch.touching)
+                RECORDING_PRINT("(%d,%d)", report->touch.x, report->touch.y);
+            else
+                RECORDING_PRINT("(-)");
+            break;
+        }
+    }
+
+#undef RECORDING_PRINT
+
+    return length;
+}
+
+uint32_t recording_transport_run(recording_transport_t *recording, script_engine_t *engine,
+                                 const uint8_t *script, uint8_t length)
+{
+    uint32_t start_ms = recording->now_ms;
+
+    if (!script_engine_start(engine, script, length, 0, recording->now_ms))
+        return 0;
+
+    // poll exactly at the deadlines, like the executor task does
+    while (script_engine_poll(engine, recording->now_ms))
+        recording->now_ms = engine->wake_ms;
+
+    return recording->now_ms - start_ms;
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static recorded_report_t *recording_add(recording_transport_t *recording, recorded_report_type_t type)
+{
+    static recorded_report_t discarded;
+    recorded_report_t *report = &discarded;
+
+    if (recording->count == 0)
+        recording->first_report_ms = recording->now_ms;
+
+    if (recording->keep && recording->count < RECORDING_TRANSPORT_MAX_REPORTS)
+        report = &recording->reports[recording->count];
+    recording->count++;
+
+    report->type = type;
+    report->time_ms = recording->now_ms;
+
+    return report;
+}
+
+static void recording_send_keyboard(void *ctx, script_engine_t *engine, uint8_t modifiers,
+                                    uint8_t *keys, uint8_t num_keys)
+{
+    recorded_report_t *report = recording_add(ctx, RECORDED_KEYBOARD);
+
+    if (num_keys > SCRIPT_ENGINE_MAX_ROLLOVER_KEYS)
+        num_keys = SCRIPT_ENGINE_MAX_ROLLOVER_KEYS;
+
+    report->keyboard.modifiers = modifiers;
+    report->keyboard.num_keys = num_keys;
+    if (num_keys > 0)
+        memcpy(report->keyboard.keys, keys, num_keys);
+}
+
+static void recording_send_mouse(void *ctx, script_engine_t *engine, uint8_t buttons,
+                                 int16_t x, int16_t y, int8_t wheel, int8_t pan)
+{
+    recorded_report_t *report = recording_add(ctx, RECORDED_MOUSE);
+
+    report->mouse.buttons = buttons;
+    report->mouse.x = x;
+    report->mouse.y = y;
+    report->mouse.wheel = wheel;
+    report->mouse.pan = pan;
+}
+
+static void recording_send_consumer(void *ctx, script_engine_t *engine, uint8_t usage, bool pressed)
+{
+    recorded_report_t *report = recording_add(ctx, RECORDED_CONSUMER);
+
+    report->consumer.usage = usage;
+    report->consumer.pressed = pressed;
+}
+
+static void recording_send_touch(void *ctx, script_engine_t *engine, bool touching,
+                                 uint16_t x, uint16_t y)
+{
+    recorded_report_t *report = recording_add(ctx, RECORDED_TOUCH);
+
+    report->touch.touching = touching;
+    report->touch.x = x;
+    report->touch.y = y;
+}
+
+static void recording_delay_ms(void *ctx, uint32_t ms)
+{
+    recording_transport_t *recording = ctx;
+
+    recording->now_ms += ms;
+}
+
+static script_engine_special_result_t recording_run_special(void *ctx, script_engine_t *engine,
+                                                            uint8_t special_index, const uint8_t *script)
+{
+    recording_transport_t *recording = ctx;
+
+    if (recording->run_special == NULL)
+        return SCRIPT_ENGINE_SPECIAL_STOP;
+
+    return recording->run_special(recording->special_ctx, engine, special_index, script);
+}
+
+static uint8_t recording_get_leds(void *ctx, script_engine_t *engine)
+{
+    recording_transport_t *recording = ctx;
+
+    return recording->leds;
+}
+
+static const char *recording_get_string(void *ctx, script_engine_t *engine, uint8_t id, uint8_t *length)
+{
+    recording_transport_t *recording = ctx;
+
+    if (id >= RECORDING_TRANSPORT_MAX_STRINGS || recording->strings[id] == NULL)
+        return NULL;
+
+    *length = strlen(recording->strings[id]);
+    return recording->strings[id];
+}
+
+static const uint8_t *recording_get_script(void *ctx, script_engine_t *engine, uint8_t id, uint8_t *length)
+{
+    recording_transport_t *recording = ctx;
+
+    if (id >= RECORDING_TRANSPORT_MAX_SCRIPTS || recording->scripts[id] == NULL)
+        return NULL;
+
+    *length = recording->scripts_length[id];
+    return recording->scripts[id];
+}
+
+static void recording_finished(void *ctx, script_engine_t *engine)
+{
+    recording_transport_t *recording = ctx;
+
+    recording->finished++;
+}
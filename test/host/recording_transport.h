@@ -0,0 +1,113 @@
+/*
+ * Script engine transport for the host build.
+ *
+ * Nothing goes anywhere: every report the engine sends is recorded with
+ * the virtual time it was sent at. The clock only moves when the engine
+ * waits (delay_ms of script_engine_run(), or the test polling at later
+ * times), so a run is fully deterministic and takes no real time.
+ */
+
+#ifndef RECORDING_TRANSPORT_H
+#define RECORDING_TRANSPORT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "script_engine.h"
+
+#define RECORDING_TRANSPORT_MAX_REPORTS 1024
+#define RECORDING_TRANSPORT_MAX_STRINGS 8
+#define RECORDING_TRANSPORT_MAX_SCRIPTS 8
+
+    typedef enum
+    {
+        RECORDED_KEYBOARD,
+        RECORDED_MOUSE,
+        RECORDED_CONSUMER,
+        RECORDED_TOUCH,
+    } recorded_report_type_t;
+
+    typedef struct
+    {
+        recorded_report_type_t type;
+        uint32_t time_ms; // virtual time the report was sent at
+        union
+        {
+            struct
+            {
+                uint8_t modifiers;
+                uint8_t keys[SCRIPT_ENGINE_MAX_ROLLOVER_KEYS];
+                uint8_t num_keys;
+            } keyboard;
+            struct
+            {
+                uint8_t buttons;
+                int16_t x;
+                int16_t y;
+                int8_t wheel;
+                int8_t pan;
+            } mouse;
+            struct
+            {
+                uint8_t usage;
+                bool pressed;
+            } consumer;
+            struct
+            {
+                bool touching;
+                uint16_t x;
+                uint16_t y;
+            } touch;
+        };
+    } recorded_report_t;
+
+    typedef struct
+    {
+        script_engine_transport_t transport; // give &recording->transport to the engine
+
+        uint32_t now_ms;  // virtual clock
+        bool keep;        // false only counts the reports (benchmarks)
+        recorded_report_t reports[RECORDING_TRANSPORT_MAX_REPORTS];
+        uint32_t count;   // reports sent, even the ones not kept
+        uint32_t first_report_ms; // virtual time of the first report
+
+        // what the host would answer
+        uint8_t leds; // APP_SCRIPT_LED_*
+        const char *strings[RECORDING_TRANSPORT_MAX_STRINGS];
+        const uint8_t *scripts[RECORDING_TRANSPORT_MAX_SCRIPTS];
+        uint8_t scripts_length[RECORDING_TRANSPORT_MAX_SCRIPTS];
+
+        // optional, stops the script if NULL
+        script_engine_special_result_t (*run_special)(void *ctx, script_engine_t *engine,
+                                                      uint8_t special_index, const uint8_t *script);
+        void *special_ctx;
+        uint32_t finished; // scripts finished
+    } recording_transport_t;
+
+    void recording_transport_init(recording_transport_t *recording);
+
+    // Forgets the reports, the clock keeps going
+    void recording_transport_clear(recording_transport_t *recording);
+
+    // Writes the reports as text, e.g. "[02:04,05][00:]" for keyboard
+    // reports (modifiers:keys), "{btn,x,y,wheel,pan}" for mouse reports,
+    // "<usage+>" / "<usage->" for consumer keys and "(x,y)" / "(-)" for
+    // touches. Returns the length, the text is cut to 'size'.
+    size_t recording_transport_format(const recording_transport_t *recording, char *text, size_t size);
+
+    // Runs the script to the end on the virtual clock, returns the
+    // virtual time it took
+    uint32_t recording_transport_run(recording_transport_t *recording, script_engine_t *engine,
+                                     const uint8_t *script, uint8_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RECORDING_TRANSPORT_H */
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for the ESP-IDF header, only what the host build needs
+ */
+
+#ifndef DRIVER_GPIO_H
+#define DRIVER_GPIO_H
+
+typedef int gpio_num_t;
+
+#endif /* DRIVER_GPIO_H */
@@ -0,0 +1,22 @@
+/*
+ * Host stand-in for the ESP-IDF header, see rmt_host.c
+ */
+
+#ifndef DRIVER_RMT_H
+#define DRIVER_RMT_H
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "soc/rmt_struct.h"
+
+typedef int rmt_channel_t;
+
+typedef enum
+{
+    RMT_MODE_TX,
+    RMT_MODE_RX,
+} rmt_mode_t;
+
+esp_err_t rmt_set_pin(rmt_channel_t channel, rmt_mode_t mode, gpio_num_t gpio_num);
+
+#endif /* DRIVER_RMT_H */
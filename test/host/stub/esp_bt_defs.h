@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for the ESP-IDF header, only what the host build needs
+ */
+
+#ifndef ESP_BT_DEFS_H
+#define ESP_BT_DEFS_H
+
+#include <stdint.h>
+
+#define ESP_BD_ADDR_LEN 6
+
+typedef uint8_t esp_bd_addr_t[ESP_BD_ADDR_LEN];
+
+#endif /* ESP_BT_DEFS_H */
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the ESP-IDF header, only what the host build needs.
+ * The GAP calls are implemented by the host test that links hid_dev.c.
+ */
+
+#ifndef ESP_GAP_BLE_API_H
+#define ESP_GAP_BLE_API_H
+
+#include <stdint.h>
+
+uint16_t esp_ble_get_cur_sendable_packets_num(uint16_t connid);
+
+#endif /* ESP_GAP_BLE_API_H */
@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for the ESP-IDF header, only what the host build needs
+ */
+
+#ifndef ESP_GATT_DEFS_H
+#define ESP_GATT_DEFS_H
+
+#include <stdint.h>
+
+#include "esp_bt_defs.h"
+
+#define ESP_GATT_IF_NONE 0xff
+
+typedef uint8_t esp_gatt_if_t;
+
+#endif /* ESP_GATT_DEFS_H */
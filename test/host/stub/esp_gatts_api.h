@@ -0,0 +1,25 @@
+/*
+ * Host stand-in for the ESP-IDF header, only what the host build needs.
+ * The GATT calls are implemented by the host test that links hid_dev.c.
+ */
+
+#ifndef ESP_GATTS_API_H
+#define ESP_GATTS_API_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_gatt_defs.h"
+
+typedef int esp_gatts_cb_event_t;
+
+typedef union
+{
+    int unused;
+} esp_ble_gatts_cb_param_t;
+
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                      uint16_t value_len, uint8_t *value, bool need_confirm);
+
+#endif /* ESP_GATTS_API_H */
@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the ESP-IDF header, see rmt_host.c. Nothing raises
+ * the interrupts: the host test calls the handler itself.
+ */
+
+#ifndef ESP_INTR_ALLOC_H
+#define ESP_INTR_ALLOC_H
+
+#include "esp_err.h"
+
+#define ETS_RMT_INTR_SOURCE 47
+
+typedef void (*intr_handler_t)(void *arg);
+
+typedef struct intr_handle_data_t *intr_handle_t;
+
+esp_err_t esp_intr_alloc(int source, int flags, intr_handler_t handler, void *arg, intr_handle_t *ret_handle);
+
+#endif /* ESP_INTR_ALLOC_H */
@@ -0,0 +1,38 @@
+/*
+ * Host stand-in for esp_timer (see esp_timer_host.c). The timers never
+ * fire by themselves: the host test calls esp_timer_host_fire() when it
+ * wants the callbacks of the armed ones to run.
+ */
+
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef struct esp_timer *esp_timer_handle_t;
+
+typedef struct
+{
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle);
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+
+// microseconds since the start of the process (CLOCK_MONOTONIC)
+int64_t esp_timer_get_time(void);
+
+// Runs the callback of every armed timer, returns how many ran
+int esp_timer_host_fire(void);
+
+#endif /* ESP_TIMER_H */
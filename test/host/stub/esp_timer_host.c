@@ -0,0 +1,74 @@
+/*
+ * esp_timer on the host, see esp_timer.h
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "esp_timer.h"
+
+#define ESP_TIMER_HOST_MAX 8
+
+struct esp_timer
+{
+    esp_timer_create_args_t args;
+    bool armed;
+};
+
+static struct esp_timer esp_timer_host_timers[ESP_TIMER_HOST_MAX];
+static int esp_timer_host_count = 0;
+
+// FUNCTION DEFINITIONS
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (esp_timer_host_count >= ESP_TIMER_HOST_MAX)
+        return ESP_FAIL;
+
+    esp_timer_host_timers[esp_timer_host_count].args = *create_args;
+    esp_timer_host_timers[esp_timer_host_count].armed = false;
+    *out_handle = &esp_timer_host_timers[esp_timer_host_count++];
+
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->armed)
+        return ESP_FAIL; // ESP_ERR_INVALID_STATE on the device
+
+    timer->armed = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    timer->armed = false;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+int esp_timer_host_fire(void)
+{
+    int fired = 0;
+    int i;
+
+    for (i = 0; i < esp_timer_host_count; i++)
+    {
+        if (!esp_timer_host_timers[i].armed)
+            continue;
+
+        esp_timer_host_timers[i].armed = false;
+        esp_timer_host_timers[i].args.callback(esp_timer_host_timers[i].args.arg);
+        fired++;
+    }
+
+    return fired;
+}
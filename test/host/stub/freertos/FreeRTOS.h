@@ -0,0 +1,35 @@
+/*
+ * Host stand-in for FreeRTOS: tasks are pthreads, the critical sections
+ * are mutexes (see freertos_host.c). Only what main/ uses on the host.
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef BaseType_t portBASE_TYPE;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+
+#define configTICK_RATE_HZ 100 // CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+typedef pthread_mutex_t portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED PTHREAD_MUTEX_INITIALIZER
+#define portENTER_CRITICAL(mux) pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL(mux) pthread_mutex_unlock(mux)
+#define portENTER_CRITICAL_ISR(mux) pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL_ISR(mux) pthread_mutex_unlock(mux)
+#define portYIELD_FROM_ISR() ((void)0)
+
+#endif /* FREERTOS_H */
@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for FreeRTOS tasks, see FreeRTOS.h
+ */
+
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+typedef pthread_t *TaskHandle_t;
+
+// the task runs in a detached thread, 'stack_depth' and 'priority' are ignored
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth,
+                       void *parameters, UBaseType_t priority, TaskHandle_t *created_task);
+
+TickType_t xTaskGetTickCount(void);
+
+void vTaskDelay(TickType_t ticks);
+
+#endif /* FREERTOS_TASK_H */
@@ -0,0 +1,282 @@
+/*
+ * FreeRTOS calls used by main/, on top of pthreads (see freertos/FreeRTOS.h)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+struct host_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+};
+
+// binary: given is 0 or 1
+struct host_semaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t given;
+};
+
+typedef struct
+{
+    TaskFunction_t code;
+    void *parameters;
+} host_task_t;
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void *host_task_entry(void *arg);
+static void host_deadline(struct timespec *deadline, TickType_t ticks);
+static SemaphoreHandle_t host_semaphore_create(UBaseType_t given);
+
+// FUNCTION DEFINITIONS
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth,
+                       void *parameters, UBaseType_t priority, TaskHandle_t *created_task)
+{
+    host_task_t *task = malloc(sizeof(host_task_t));
+    pthread_t thread;
+
+    if (task == NULL)
+        return pdFALSE;
+
+    task->code = code;
+    task->parameters = parameters;
+
+    if (pthread_create(&thread, NULL, host_task_entry, task) != 0)
+    {
+        free(task);
+        return pdFALSE;
+    }
+
+    pthread_detach(thread);
+    if (created_task != NULL)
+        *created_task = NULL;
+
+    return pdPASS;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)(now.tv_sec * configTICK_RATE_HZ + now.tv_nsec / (1000000 * portTICK_PERIOD_MS));
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec delay = {
+        .tv_sec = ticks / configTICK_RATE_HZ,
+        .tv_nsec = (long)(ticks % configTICK_RATE_HZ) * portTICK_PERIOD_MS * 1000000,
+    };
+
+    nanosleep(&delay, NULL);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t queue = calloc(1, sizeof(struct host_queue));
+
+    if (queue == NULL)
+        return NULL;
+
+    queue->items = malloc(length * item_size);
+    if (queue->items == NULL)
+    {
+        free(queue);
+        return NULL;
+    }
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    queue->length = length;
+    queue->item_size = item_size;
+
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    int rc = 0;
+
+    host_deadline(&deadline, ticks_to_wait);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length && ticks_to_wait != 0 && rc != ETIMEDOUT)
+    {
+        if (ticks_to_wait == portMAX_DELAY)
+            pthread_cond_wait(&queue->changed, &queue->lock);
+        else
+            rc = pthread_cond_timedwait(&queue->changed, &queue->lock, &deadline);
+    }
+
+    if (queue->count == queue->length)
+    {
+        pthread_mutex_unlock(&queue->lock);
+        return pdFALSE;
+    }
+
+    memcpy(queue->items + ((queue->head + queue->count) % queue->length) * queue->item_size,
+           item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    int rc = 0;
+
+    host_deadline(&deadline, ticks_to_wait);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && ticks_to_wait != 0 && rc != ETIMEDOUT)
+    {
+        if (ticks_to_wait == portMAX_DELAY)
+            pthread_cond_wait(&queue->changed, &queue->lock);
+        else
+            rc = pthread_cond_timedwait(&queue->changed, &queue->lock, &deadline);
+    }
+
+    if (queue->count == 0)
+    {
+        pthread_mutex_unlock(&queue->lock);
+        return pdFALSE;
+    }
+
+    memcpy(buffer, queue->items + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    UBaseType_t count;
+
+    pthread_mutex_lock(&queue->lock);
+    count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+
+    return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return host_semaphore_create(1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return host_semaphore_create(0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    int rc = 0;
+
+    host_deadline(&deadline, ticks_to_wait);
+
+    pthread_mutex_lock(&semaphore->lock);
+    while (semaphore->given == 0 && ticks_to_wait != 0 && rc != ETIMEDOUT)
+    {
+        if (ticks_to_wait == portMAX_DELAY)
+            pthread_cond_wait(&semaphore->changed, &semaphore->lock);
+        else
+            rc = pthread_cond_timedwait(&semaphore->changed, &semaphore->lock, &deadline);
+    }
+
+    if (semaphore->given == 0)
+    {
+        pthread_mutex_unlock(&semaphore->lock);
+        return pdFALSE;
+    }
+
+    semaphore->given = 0;
+    pthread_mutex_unlock(&semaphore->lock);
+
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    BaseType_t given;
+
+    pthread_mutex_lock(&semaphore->lock);
+    given = semaphore->given == 0 ? pdTRUE : pdFALSE;
+    semaphore->given = 1;
+    pthread_cond_signal(&semaphore->changed);
+    pthread_mutex_unlock(&semaphore->lock);
+
+    return given;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *higher_priority_task_woken)
+{
+    if (higher_priority_task_woken != NULL)
+        *higher_priority_task_woken = pdFALSE;
+
+    return xSemaphoreGive(semaphore);
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static void *host_task_entry(void *arg)
+{
+    host_task_t task = *(host_task_t *)arg;
+
+    free(arg);
+    task.code(task.parameters);
+
+    return NULL;
+}
+
+static void host_deadline(struct timespec *deadline, TickType_t ticks)
+{
+    uint64_t ns;
+
+    clock_gettime(CLOCK_REALTIME, deadline);
+    if (ticks == portMAX_DELAY)
+        return;
+
+    ns = deadline->tv_nsec + (uint64_t)ticks * portTICK_PERIOD_MS * 1000000;
+    deadline->tv_sec += ns / 1000000000;
+    deadline->tv_nsec = ns % 1000000000;
+}
+
+static SemaphoreHandle_t host_semaphore_create(UBaseType_t given)
+{
+    SemaphoreHandle_t semaphore = calloc(1, sizeof(struct host_semaphore));
+
+    if (semaphore == NULL)
+        return NULL;
+
+    pthread_mutex_init(&semaphore->lock, NULL);
+    pthread_cond_init(&semaphore->changed, NULL);
+    semaphore->given = given;
+
+    return semaphore;
+}
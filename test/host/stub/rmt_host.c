@@ -0,0 +1,27 @@
+/*
+ * The RMT peripheral on the host: registers and memory the driver writes
+ * and the test reads back, see soc/rmt_struct.h
+ */
+
+#include <stddef.h>
+
+#include "driver/rmt.h"
+#include "esp_intr_alloc.h"
+
+rmt_dev_t RMT;
+rmt_mem_t RMTMEM;
+
+// FUNCTION DEFINITIONS
+
+esp_err_t rmt_set_pin(rmt_channel_t channel, rmt_mode_t mode, gpio_num_t gpio_num)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_intr_alloc(int source, int flags, intr_handler_t handler, void *arg, intr_handle_t *ret_handle)
+{
+    if (ret_handle != NULL)
+        *ret_handle = NULL;
+
+    return ESP_OK;
+}
@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for the ESP-IDF header, the peripheral clocks are no-ops
+ */
+
+#ifndef SOC_DPORT_REG_H
+#define SOC_DPORT_REG_H
+
+#define DPORT_PERIP_CLK_EN_REG 0
+#define DPORT_PERIP_RST_EN_REG 0
+#define DPORT_RMT_CLK_EN 0
+#define DPORT_RMT_RST 0
+
+#define DPORT_SET_PERI_REG_MASK(reg, mask) ((void)0)
+#define DPORT_CLEAR_PERI_REG_MASK(reg, mask) ((void)0)
+
+#endif /* SOC_DPORT_REG_H */
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for the ESP-IDF header, nothing is used
+ */
+
+#ifndef SOC_GPIO_SIG_MAP_H
+#define SOC_GPIO_SIG_MAP_H
+
+#endif /* SOC_GPIO_SIG_MAP_H */
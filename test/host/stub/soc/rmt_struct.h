@@ -0,0 +1,78 @@
+/*
+ * Host stand-in for the ESP-IDF header: the RMT registers and memory are
+ * plain variables (see rmt_host.c), with only the fields main/ uses
+ */
+
+#ifndef SOC_RMT_STRUCT_H
+#define SOC_RMT_STRUCT_H
+
+#include <stdint.h>
+
+typedef volatile struct
+{
+    struct
+    {
+        struct
+        {
+            uint32_t div_cnt : 8;
+            uint32_t mem_size : 4;
+            uint32_t carrier_en : 1;
+            uint32_t carrier_out_lv : 1;
+            uint32_t mem_pd : 1;
+        } conf0;
+        struct
+        {
+            uint32_t tx_start : 1;
+            uint32_t rx_en : 1;
+            uint32_t mem_rd_rst : 1;
+            uint32_t mem_owner : 1;
+            uint32_t tx_conti_mode : 1;
+            uint32_t ref_always_on : 1;
+            uint32_t idle_out_lv : 1;
+            uint32_t idle_out_en : 1;
+        } conf1;
+    } conf_ch[8];
+    struct
+    {
+        uint32_t ch0_tx_end : 1;
+        uint32_t ch0_tx_thr_event : 1;
+    } int_st, int_ena, int_clr;
+    struct
+    {
+        uint32_t limit : 9;
+    } tx_lim_ch[8];
+    struct
+    {
+        uint32_t fifo_mask : 1;
+        uint32_t mem_tx_wrap_en : 1;
+    } apb_conf;
+} rmt_dev_t;
+
+extern rmt_dev_t RMT;
+
+typedef struct
+{
+    union
+    {
+        struct
+        {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
+
+typedef volatile struct
+{
+    struct
+    {
+        rmt_item32_t data32[64];
+    } chan[8];
+} rmt_mem_t;
+
+extern rmt_mem_t RMTMEM;
+
+#endif /* SOC_RMT_STRUCT_H */
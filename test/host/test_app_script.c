@@ -0,0 +1,178 @@
+/*
+ * Compiles the app control scripts of hid_app_control.h and checks the
+ * image byte for byte, then a few rows the compiler must refuse and the
+ * control flow app_script_validate() must refuse.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "app_script.h"
+#include "app_scripts.h"
+
+#define COMBINE(n) (APP_SCRIPT_OP_COMBINE_BASE + (n))
+
+// [length][opcodes], in the order app_control_init() registers the scripts
+static const uint8_t test_expected_image[] = {
+    // ZOOM_CONTROL_MOBILE
+    4, HID_MOUSE_LEFT, HID_KEY_DOWN_ARROW, HID_KEY_SPACEBAR, HID_KEY_ESCAPE,          // TOGGLE_MIC
+    5, HID_MOUSE_LEFT, HID_KEY_DOWN_ARROW, HID_KEY_RIGHT_ARROW, HID_KEY_SPACEBAR,     // TOGGLE_VID
+    HID_KEY_ESCAPE,
+    2, APP_SCRIPT_OP_SPECIAL, ZOOM_CONTROL_MOBILE_SPECIAL_1,                          // JOIN1
+    0,                                                                                // OPEN_APP
+    0,                                                                                // STILL_DECIDING
+    // ZOOM_CONTROL_PC
+    3, COMBINE(2), HID_KEY_LEFT_ALT, HID_KEY_A,                                       // TOGGLE_MIC
+    0, 0, 0, 0,
+    // SKYPE_CONTROL_MOBILE
+    0, 0, 0, 0, 0,
+    // SKYPE_CONTROL_PC
+    0, 0, 0, 0, 0,
+    // MEET_CONTROL_MOBILE
+    0, 0, 0, 0, 0,
+    // MEET_CONTROL_PC
+    3, COMBINE(2), HID_KEY_LEFT_CTRL, HID_KEY_D,                                      // TOGGLE_MIC
+    3, COMBINE(2), HID_KEY_LEFT_CTRL, HID_KEY_E,                                      // TOGGLE_VID
+    0, 0, 0,
+};
+
+static app_script_image_t test_image;
+static app_scripts_entry_t test_entries[APP_SCRIPTS_TOTAL];
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void test_app_control_image(void);
+static void test_refused_rows(void);
+static void test_validate(void);
+
+// FUNCTION DEFINITIONS
+
+int main(void)
+{
+    test_app_control_image();
+    test_refused_rows();
+    test_validate();
+
+    return HOST_TEST_RESULT();
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static void test_app_control_image(void)
+{
+    const uint8_t *script;
+    uint16_t offset = 0;
+    uint8_t count, length, i;
+
+    count = app_scripts_compile(&test_image, test_entries);
+
+    HOST_CHECK(count == 30);
+    HOST_CHECK(test_image.used == sizeof(test_expected_image));
+    HOST_CHECK(memcmp(test_image.code, test_expected_image, sizeof(test_expected_image)) == 0);
+
+    for (i = 0; i < test_image.used && i < sizeof(test_expected_image); i++)
+    {
+        if (test_image.code[i] != test_expected_image[i])
+            printf("image[%d] = %d, expected %d\n", i, test_image.code[i], test_expected_image[i]);
+    }
+
+    // every script right after the previous one, and valid
+    for (i = 0; i < count; i++)
+    {
+        HOST_CHECK(test_entries[i].offset == offset);
+
+        script = app_script_get(&test_image, test_entries[i].offset, &length);
+        HOST_CHECK(script == &test_image.code[offset + 1]);
+        HOST_CHECK(app_script_validate(script, length));
+
+        offset += 1 + length;
+    }
+}
+
+static void test_refused_rows(void)
+{
+    // id first, then the padded steps
+    static const int missing_operand[] = {0, HID_KEY_A, APP_SCRIPT_OP_WAIT, 10};
+    static const int combine_too_long[] = {0, COMBINE(3), HID_KEY_LEFT_CTRL, HID_KEY_A};
+    static const int not_a_byte[] = {0, 256};
+    static const int padded[] = {0, APP_SCRIPT_OP_WAIT, 0, 0, APP_SCRIPT_OP_END, APP_SCRIPT_OP_END};
+    static const int big[1 + 200] = {0, [1 ... 200] = HID_KEY_A};
+    uint16_t used;
+    uint8_t length;
+
+    app_script_image_reset(&test_image);
+
+    HOST_CHECK(app_script_compile(&test_image, missing_operand, 4) == APP_SCRIPT_INVALID_OFFSET);
+    HOST_CHECK(app_script_compile(&test_image, combine_too_long, 4) == APP_SCRIPT_INVALID_OFFSET);
+    HOST_CHECK(app_script_compile(&test_image, not_a_byte, 2) == APP_SCRIPT_INVALID_OFFSET);
+    HOST_CHECK(test_image.used == 0);
+
+    // a WAIT of 0 ms is a WAIT, not the end of the script
+    HOST_CHECK(app_script_compile(&test_image, padded, 6) == 0);
+    HOST_CHECK(app_script_get(&test_image, 0, &length) != NULL && length == 3);
+
+    // the third one doesn't fit in the image any more
+    HOST_CHECK(app_script_compile(&test_image, big, 1 + 200) == 4);
+    HOST_CHECK(app_script_compile(&test_image, big, 1 + 200) == 4 + 201);
+    used = test_image.used;
+    HOST_CHECK(app_script_compile(&test_image, big, 1 + 200) == APP_SCRIPT_INVALID_OFFSET);
+    HOST_CHECK(test_image.used == used);
+}
+
+static void test_validate(void)
+{
+    static const uint8_t nested_repeat[] = {
+        APP_SCRIPT_OP_REPEAT, 2, 5, APP_SCRIPT_OP_REPEAT, 2, 1, HID_KEY_A, HID_KEY_B,
+    };
+    static const uint8_t empty_repeat[] = {APP_SCRIPT_OP_REPEAT, 2, 0, HID_KEY_A};
+    static const uint8_t repeat_into_operand[] = {APP_SCRIPT_OP_REPEAT, 2, 1, APP_SCRIPT_OP_WAIT, 10, 0};
+    static const uint8_t repeat_past_end[] = {APP_SCRIPT_OP_REPEAT, 2, 2, HID_KEY_A};
+    static const uint8_t jump_out_of_body[] = {
+        APP_SCRIPT_OP_REPEAT, 2, 4, APP_SCRIPT_OP_JUMP_IF_LED, APP_SCRIPT_LED_CAPS_LOCK, 2, HID_KEY_A,
+        HID_KEY_B,
+    };
+    static const uint8_t jump_into_operand[] = {
+        APP_SCRIPT_OP_JUMP_IF_LED, APP_SCRIPT_LED_CAPS_LOCK, 1, APP_SCRIPT_OP_WAIT, 10, 0, HID_KEY_A,
+    };
+    static const uint8_t jump_past_end[] = {APP_SCRIPT_OP_JUMP_IF_LED, APP_SCRIPT_LED_CAPS_LOCK, 2, HID_KEY_A};
+    static const uint8_t press_not_a_key[] = {APP_SCRIPT_OP_PRESS, APP_SCRIPT_OP_WAIT};
+    static const uint8_t release_nothing[] = {APP_SCRIPT_OP_RELEASE, HID_MOUSE_LEFT};
+    static const uint8_t missing_operand[] = {HID_KEY_A, APP_SCRIPT_OP_MOUSE_MOVE, 1, 0, 1};
+    // the same things done right
+    static const uint8_t jump_to_body_end[] = {
+        APP_SCRIPT_OP_REPEAT, 2, 4, APP_SCRIPT_OP_JUMP_IF_LED, APP_SCRIPT_LED_CAPS_LOCK, 1, HID_KEY_A,
+        HID_KEY_B,
+    };
+    static const uint8_t jump_to_end[] = {APP_SCRIPT_OP_JUMP_IF_LED, APP_SCRIPT_LED_CAPS_LOCK, 1, HID_KEY_A};
+    static const uint8_t two_repeats[] = {
+        APP_SCRIPT_OP_REPEAT, 2, 1, HID_KEY_A, APP_SCRIPT_OP_REPEAT, 3, 3, APP_SCRIPT_OP_WAIT, 10, 0,
+    };
+    static const uint8_t release_all[] = {
+        APP_SCRIPT_OP_PRESS, HID_KEY_RIGHT_GUI, APP_SCRIPT_OP_RELEASE, APP_SCRIPT_KEY_ALL,
+    };
+    static const int jump_row[] = {0, APP_SCRIPT_OP_JUMP_IF_LED, APP_SCRIPT_LED_NUM_LOCK, 3, HID_KEY_A,
+                                   APP_SCRIPT_OP_END, APP_SCRIPT_OP_END};
+
+    HOST_CHECK(!app_script_validate(nested_repeat, sizeof(nested_repeat)));
+    HOST_CHECK(!app_script_validate(empty_repeat, sizeof(empty_repeat)));
+    HOST_CHECK(!app_script_validate(repeat_into_operand, sizeof(repeat_into_operand)));
+    HOST_CHECK(!app_script_validate(repeat_past_end, sizeof(repeat_past_end)));
+    HOST_CHECK(!app_script_validate(jump_out_of_body, sizeof(jump_out_of_body)));
+    HOST_CHECK(!app_script_validate(jump_into_operand, sizeof(jump_into_operand)));
+    HOST_CHECK(!app_script_validate(jump_past_end, sizeof(jump_past_end)));
+    HOST_CHECK(!app_script_validate(press_not_a_key, sizeof(press_not_a_key)));
+    HOST_CHECK(!app_script_validate(release_nothing, sizeof(release_nothing)));
+    HOST_CHECK(!app_script_validate(missing_operand, sizeof(missing_operand)));
+
+    HOST_CHECK(app_script_validate(jump_to_body_end, sizeof(jump_to_body_end)));
+    HOST_CHECK(app_script_validate(jump_to_end, sizeof(jump_to_end)));
+    HOST_CHECK(app_script_validate(two_repeats, sizeof(two_repeats)));
+    HOST_CHECK(app_script_validate(release_all, sizeof(release_all)));
+
+    // the compiler refuses what the validator refuses: the jump skips
+    // past the end once the padding is stripped
+    app_script_image_reset(&test_image);
+    HOST_CHECK(app_script_compile(&test_image, jump_row, 7) == APP_SCRIPT_INVALID_OFFSET);
+    HOST_CHECK(test_image.used == 0);
+}
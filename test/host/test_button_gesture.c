@@ -0,0 +1,200 @@
+/*
+ * button_gesture tests: recorded contact bounce traces are replayed the
+ * way the io hardware task feeds them (every edge, plus a poll whenever
+ * the gesture timeout expires) and the gestures that come out are
+ * compared with the expected ones.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "button_gesture.h"
+
+// one edge seen by the GPIO interrupt
+typedef struct
+{
+    uint32_t time_us;
+    uint8_t button;
+    uint8_t level;
+} test_edge_t;
+
+#define TEST_TRACE(edges) edges, sizeof(edges) / sizeof(edges[0])
+
+// A tactile switch: ~1.5 ms of bounce when pressed, ~2 ms when released
+static const test_edge_t test_short_press[] = {
+    {0, 0, 1}, {180, 0, 0}, {420, 0, 1}, {900, 0, 0}, {1500, 0, 1},
+    {85000, 0, 0}, {85300, 0, 1}, {85700, 0, 0}, {86600, 0, 1}, {87000, 0, 0},
+};
+
+// A worn switch bouncing for 12 ms: still a single press
+static const test_edge_t test_worn_press[] = {
+    {0, 0, 1}, {300, 0, 0}, {700, 0, 1}, {1900, 0, 0}, {2400, 0, 1}, {3800, 0, 0},
+    {4100, 0, 1}, {6000, 0, 0}, {6300, 0, 1}, {8800, 0, 0}, {9000, 0, 1}, {11700, 0, 0},
+    {12000, 0, 1},
+    {140000, 0, 0}, {140400, 0, 1}, {141000, 0, 0}, {143500, 0, 1}, {144000, 0, 0},
+};
+
+// A tap shorter than the debounce window: released when the window ends
+static const test_edge_t test_glitch[] = {
+    {0, 1, 1}, {200, 1, 0}, {600, 1, 1}, {5000, 1, 0},
+};
+
+// Held for 700 ms
+static const test_edge_t test_long_press[] = {
+    {0, 2, 1}, {400, 2, 0}, {800, 2, 1},
+    {700000, 2, 0}, {700500, 2, 1}, {701200, 2, 0},
+};
+
+// Two short presses 150 ms apart, then a third one: only one double press
+static const test_edge_t test_double_press[] = {
+    {0, 0, 1}, {250, 0, 0}, {600, 0, 1},
+    {90000, 0, 0}, {90800, 0, 1}, {91500, 0, 0},
+    {240000, 0, 1}, {240300, 0, 0}, {241000, 0, 1},
+    {330000, 0, 0}, {331000, 0, 1}, {331800, 0, 0},
+    {430000, 0, 1}, {430200, 0, 0}, {430900, 0, 1},
+    {520000, 0, 0},
+};
+
+// Two presses further apart than the double press time
+static const test_edge_t test_slow_presses[] = {
+    {0, 0, 1}, {400, 0, 0}, {900, 0, 1},
+    {80000, 0, 0}, {80600, 0, 1}, {81000, 0, 0},
+    {420000, 0, 1}, {420500, 0, 0}, {421000, 0, 1},
+    {500000, 0, 0},
+};
+
+// Button 3 pressed while 1 is held, both bouncing
+static const test_edge_t test_chord[] = {
+    {0, 1, 1}, {300, 1, 0}, {700, 1, 1},
+    {40000, 3, 1}, {40200, 3, 0}, {40900, 3, 1},
+    {200000, 1, 0}, {200400, 1, 1}, {200800, 1, 0},
+    {230000, 3, 0}, {231000, 3, 1}, {231500, 3, 0},
+    // a quick press of 1 right after doesn't make a double press
+    {300000, 1, 1}, {380000, 1, 0},
+};
+
+// Bounces of different buttons interleaved
+static const test_edge_t test_interleaved[] = {
+    {0, 0, 1}, {100, 4, 1}, {200, 0, 0}, {350, 4, 0}, {500, 0, 1}, {700, 4, 1},
+    {100000, 4, 0}, {100100, 0, 0}, {100300, 4, 1}, {100500, 0, 1}, {100800, 4, 0}, {101000, 0, 0},
+};
+
+static char test_log[512];
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void test_callback(void *ctx, const button_gesture_event_t *event);
+static void test_poll_until(button_gesture_t *gesture, uint32_t *now_us, uint32_t until_us);
+static const char *test_replay(const test_edge_t *edges, uint16_t count);
+static void test_timeout(void);
+
+// FUNCTION DEFINITIONS
+
+int main(void)
+{
+    // P = press, R = release, L = long press, D = double press, C = chord
+    // (with the buttons held), then the time in ms
+    HOST_CHECK_STR(test_replay(TEST_TRACE(test_short_press)), "P0@0 R0@85");
+    HOST_CHECK_STR(test_replay(TEST_TRACE(test_worn_press)), "P0@0 R0@140");
+    HOST_CHECK_STR(test_replay(TEST_TRACE(test_glitch)), "P1@0 R1@20");
+    HOST_CHECK_STR(test_replay(TEST_TRACE(test_long_press)), "P2@0 L2@600 R2@700");
+    HOST_CHECK_STR(test_replay(TEST_TRACE(test_double_press)),
+                   "P0@0 R0@90 P0@240 D0@240 R0@330 P0@430 R0@520");
+    HOST_CHECK_STR(test_replay(TEST_TRACE(test_slow_presses)), "P0@0 R0@80 P0@420 R0@500");
+    HOST_CHECK_STR(test_replay(TEST_TRACE(test_chord)),
+                   "P1@0 P3@40 C3:0a@40 R1@200 R3@230 P1@300 R1@380");
+    HOST_CHECK_STR(test_replay(TEST_TRACE(test_interleaved)), "P0@0 P4@0 C4:11@0 R4@100 R0@100");
+
+    test_timeout();
+
+    return HOST_TEST_RESULT();
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static void test_callback(void *ctx, const button_gesture_event_t *event)
+{
+    static const char types[] = {
+        [BUTTON_GESTURE_PRESS] = 'P',
+        [BUTTON_GESTURE_RELEASE] = 'R',
+        [BUTTON_GESTURE_LONG_PRESS] = 'L',
+        [BUTTON_GESTURE_DOUBLE_PRESS] = 'D',
+        [BUTTON_GESTURE_CHORD] = 'C',
+    };
+    size_t length = strlen(test_log);
+
+    if (event->type == BUTTON_GESTURE_CHORD)
+        snprintf(test_log + length, sizeof(test_log) - length, "%s%c%d:%02x@%u", length ? " " : "",
+                 types[event->type], event->button, event->buttons, event->time_us / 1000);
+    else
+        snprintf(test_log + length, sizeof(test_log) - length, "%s%c%d@%u", length ? " " : "",
+                 types[event->type], event->button, event->time_us / 1000);
+}
+
+// Polls whenever the timeout expires before 'until_us', like the io task
+// waking up from its queue
+static void test_poll_until(button_gesture_t *gesture, uint32_t *now_us, uint32_t until_us)
+{
+    uint32_t timeout_us;
+
+    while ((timeout_us = button_gesture_timeout_us(gesture, *now_us)) != BUTTON_GESTURE_NO_TIMEOUT &&
+           timeout_us <= until_us - *now_us)
+    {
+        *now_us += timeout_us;
+        button_gesture_poll(gesture, *now_us);
+    }
+}
+
+static const char *test_replay(const test_edge_t *edges, uint16_t count)
+{
+    button_gesture_t gesture;
+    uint32_t now_us = 0;
+    uint16_t i;
+
+    test_log[0] = '\0';
+    button_gesture_init(&gesture, 5, 0x00, test_callback, NULL);
+
+    for (i = 0; i < count; i++)
+    {
+        test_poll_until(&gesture, &now_us, edges[i].time_us);
+        now_us = edges[i].time_us;
+        button_gesture_input(&gesture, edges[i].button, edges[i].level, now_us);
+    }
+
+    // a second after the last edge nothing is pending any more
+    test_poll_until(&gesture, &now_us, now_us + 1000000);
+    HOST_CHECK(button_gesture_timeout_us(&gesture, now_us) == BUTTON_GESTURE_NO_TIMEOUT);
+    HOST_CHECK(gesture.stable == 0x00);
+
+    return test_log;
+}
+
+static void test_timeout(void)
+{
+    button_gesture_t gesture;
+
+    test_log[0] = '\0';
+    button_gesture_init(&gesture, 5, 0x00, test_callback, NULL);
+    HOST_CHECK(button_gesture_timeout_us(&gesture, 0) == BUTTON_GESTURE_NO_TIMEOUT);
+
+    // debounce window first, then the long press
+    button_gesture_input(&gesture, 0, 1, 1000);
+    HOST_CHECK(button_gesture_timeout_us(&gesture, 1000) == BUTTON_GESTURE_DEBOUNCE_MS * 1000);
+    HOST_CHECK(button_gesture_timeout_us(&gesture, 6000) == BUTTON_GESTURE_DEBOUNCE_MS * 1000 - 5000);
+    button_gesture_poll(&gesture, 1000 + BUTTON_GESTURE_DEBOUNCE_MS * 1000);
+    HOST_CHECK(button_gesture_timeout_us(&gesture, 1000 + BUTTON_GESTURE_DEBOUNCE_MS * 1000) ==
+               (BUTTON_GESTURE_LONG_PRESS_MS - BUTTON_GESTURE_DEBOUNCE_MS) * 1000);
+
+    // overdue
+    HOST_CHECK(button_gesture_timeout_us(&gesture, 1000 + BUTTON_GESTURE_LONG_PRESS_MS * 1000 + 1) == 0);
+
+    // buttons held at boot are not pressed until released, and the
+    // clock may wrap
+    test_log[0] = '\0';
+    button_gesture_init(&gesture, 5, 0x01, test_callback, NULL);
+    button_gesture_input(&gesture, 0, 0, UINT32_MAX - 5000);
+    button_gesture_poll(&gesture, 15000);
+    button_gesture_input(&gesture, 0, 1, 200000);
+    HOST_CHECK_STR(test_log, "R0@4294962 P0@200");
+}
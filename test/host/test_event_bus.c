@@ -0,0 +1,179 @@
+/*
+ * event_bus test: several publisher threads flood the bus at the same
+ * time while the dispatcher task (a pthread, see stub/freertos_host.c)
+ * delivers. A publisher retries when the pool is full, so every event
+ * must reach every matching subscriber exactly once, in the order its
+ * publisher sent it, and the counters must add up. Events nobody
+ * subscribes to are skipped without taking a slot.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "event_bus.h"
+
+#define TEST_PUBLISHERS 4
+#define TEST_EVENTS 100000 // per publisher
+
+typedef struct
+{
+    uint32_t received[TEST_PUBLISHERS];
+    uint32_t last[TEST_PUBLISHERS]; // sequence of the last event of each publisher
+    uint32_t out_of_order;
+    uint32_t wrong_type;
+    uint32_t total; // all events, published after the rest is updated
+} test_subscriber_t;
+
+typedef struct
+{
+    uint8_t id;
+    uint32_t attempts; // calls to event_bus_publish()
+} test_publisher_t;
+
+static test_subscriber_t test_input;  // EVENT_BUS_INPUT
+static test_subscriber_t test_all;    // EVENT_BUS_ALL
+static test_subscriber_t test_ota;    // EVENT_BUS_OTA, never published here
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void test_handler(void *ctx, const event_bus_event_t *event);
+static void *test_publisher(void *arg);
+static bool test_wait_delivered(uint32_t delivered);
+static void test_check_subscriber(const test_subscriber_t *subscriber);
+
+// FUNCTION DEFINITIONS
+
+int main(void)
+{
+    test_publisher_t publishers[TEST_PUBLISHERS];
+    pthread_t threads[TEST_PUBLISHERS];
+    event_bus_stats_t stats;
+    event_bus_event_t unheard = {.type = EVENT_BUS_INPUT};
+    uint32_t attempts = 0;
+    uint8_t i;
+
+    event_bus_init();
+
+    // no subscriber yet: skipped, the pool stays empty
+    for (i = 0; i < 2 * EVENT_BUS_POOL_SIZE; i++)
+        HOST_CHECK(event_bus_publish(&unheard));
+    event_bus_get_stats(&stats);
+    HOST_CHECK(stats.skipped == 2 * EVENT_BUS_POOL_SIZE);
+    HOST_CHECK(stats.published == 0 && stats.dropped == 0);
+
+    HOST_CHECK(event_bus_subscribe(EVENT_BUS_MASK(EVENT_BUS_INPUT), test_handler, &test_input));
+    HOST_CHECK(event_bus_subscribe(EVENT_BUS_ALL, test_handler, &test_all));
+    HOST_CHECK(event_bus_subscribe(EVENT_BUS_MASK(EVENT_BUS_OTA), test_handler, &test_ota));
+
+    for (i = 0; i < TEST_PUBLISHERS; i++)
+    {
+        publishers[i].id = i;
+        publishers[i].attempts = 0;
+        HOST_CHECK(pthread_create(&threads[i], NULL, test_publisher, &publishers[i]) == 0);
+    }
+    for (i = 0; i < TEST_PUBLISHERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        attempts += publishers[i].attempts;
+    }
+
+    // two subscribers for each event
+    HOST_CHECK(test_wait_delivered(2 * TEST_PUBLISHERS * TEST_EVENTS));
+    event_bus_get_stats(&stats);
+    printf("%u published, %u dropped (pool full), %u delivered\n", stats.published, stats.dropped,
+           stats.delivered);
+
+    HOST_CHECK(stats.published == TEST_PUBLISHERS * TEST_EVENTS);
+    HOST_CHECK(stats.published + stats.dropped == attempts);
+    HOST_CHECK(stats.delivered == 2 * stats.published);
+    HOST_CHECK(stats.skipped == 2 * EVENT_BUS_POOL_SIZE);
+
+    test_check_subscriber(&test_input);
+    test_check_subscriber(&test_all);
+    HOST_CHECK(__atomic_load_n(&test_ota.total, __ATOMIC_ACQUIRE) == 0);
+
+    // the subscriber table is bounded
+    for (i = 3; i < EVENT_BUS_MAX_SUBSCRIBERS; i++)
+        HOST_CHECK(event_bus_subscribe(EVENT_BUS_MASK(EVENT_BUS_OTA), test_handler, &test_ota));
+    HOST_CHECK(!event_bus_subscribe(EVENT_BUS_MASK(EVENT_BUS_OTA), test_handler, &test_ota));
+
+    return HOST_TEST_RESULT();
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+// Runs in the dispatcher task only
+static void test_handler(void *ctx, const event_bus_event_t *event)
+{
+    test_subscriber_t *subscriber = ctx;
+    uint8_t publisher = event->input.button;
+
+    if (event->type != EVENT_BUS_INPUT || publisher >= TEST_PUBLISHERS)
+    {
+        subscriber->wrong_type++;
+    }
+    else
+    {
+        if (event->input.time_us != subscriber->last[publisher] + 1)
+            subscriber->out_of_order++;
+        subscriber->last[publisher] = event->input.time_us;
+        subscriber->received[publisher]++;
+    }
+    __atomic_fetch_add(&subscriber->total, 1, __ATOMIC_RELEASE);
+}
+
+static void *test_publisher(void *arg)
+{
+    test_publisher_t *publisher = arg;
+    event_bus_event_t event = {.type = EVENT_BUS_INPUT};
+    uint32_t sequence;
+
+    event.input.type = BUTTON_GESTURE_PRESS;
+    event.input.button = publisher->id;
+
+    for (sequence = 1; sequence <= TEST_EVENTS; sequence++)
+    {
+        event.input.time_us = sequence;
+        for (;;)
+        {
+            publisher->attempts++;
+            if (event_bus_publish(&event))
+                break;
+            // pool full, give the dispatcher a chance
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static bool test_wait_delivered(uint32_t delivered)
+{
+    struct timespec delay = {.tv_sec = 0, .tv_nsec = 1000000};
+    uint32_t waited_ms;
+
+    for (waited_ms = 0; waited_ms < 10000; waited_ms++)
+    {
+        if (__atomic_load_n(&test_input.total, __ATOMIC_ACQUIRE) +
+                __atomic_load_n(&test_all.total, __ATOMIC_ACQUIRE) ==
+            delivered)
+            return true;
+        nanosleep(&delay, NULL);
+    }
+
+    return false;
+}
+
+static void test_check_subscriber(const test_subscriber_t *subscriber)
+{
+    uint8_t i;
+
+    HOST_CHECK(subscriber->out_of_order == 0);
+    HOST_CHECK(subscriber->wrong_type == 0);
+    HOST_CHECK(__atomic_load_n(&subscriber->total, __ATOMIC_ACQUIRE) == TEST_PUBLISHERS * TEST_EVENTS);
+    for (i = 0; i < TEST_PUBLISHERS; i++)
+        HOST_CHECK(subscriber->received[i] == TEST_EVENTS && subscriber->last[i] == TEST_EVENTS);
+}
@@ -0,0 +1,260 @@
+/*
+ * hid_keymap tests: every printable ASCII character on the US, IT and DE
+ * layouts against the keycaps of those keyboards, written out here
+ * independently of the tables in hid_keymap.c.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "hid_keymap.h"
+
+#define NONE 0x00
+#define SHIFT HID_KEYMAP_SHIFT
+#define ALTGR HID_KEYMAP_ALTGR
+
+// A key and the ASCII characters printed on it, 0 where there's none (or
+// it isn't ASCII, or it's a dead key)
+typedef struct
+{
+    uint8_t usage;
+    char plain;
+    char shift;
+    char altgr;
+    char altgr_shift;
+} test_keycap_t;
+
+// the letters (a..z on 0x04..0x1D, but for DE y/z), digits and space
+// are checked on their own
+static const test_keycap_t test_us_keys[] = {
+    {0x35, '`', '~'},
+    {0x1E, '1', '!'},
+    {0x1F, '2', '@'},
+    {0x20, '3', '#'},
+    {0x21, '4', '$'},
+    {0x22, '5', '%'},
+    {0x23, '6', '^'},
+    {0x24, '7', '&'},
+    {0x25, '8', '*'},
+    {0x26, '9', '('},
+    {0x27, '0', ')'},
+    {0x2D, '-', '_'},
+    {0x2E, '=', '+'},
+    {0x2F, '[', '{'},
+    {0x30, ']', '}'},
+    {0x31, '\\', '|'},
+    {0x33, ';', ':'},
+    {0x34, '\'', '"'},
+    {0x36, ',', '<'},
+    {0x37, '.', '>'},
+    {0x38, '/', '?'},
+};
+
+static const test_keycap_t test_it_keys[] = {
+    {0x35, '\\', '|'},
+    {0x1E, '1', '!'},
+    {0x1F, '2', '"'},
+    {0x20, '3', 0},    // pound sign
+    {0x21, '4', '$'},
+    {0x22, '5', '%'},
+    {0x23, '6', '&'},
+    {0x24, '7', '/'},
+    {0x25, '8', '('},
+    {0x26, '9', ')'},
+    {0x27, '0', '='},
+    {0x2D, '\'', '?'},
+    {0x2E, 0, '^'},    // i grave
+    {0x2F, 0, 0, '[', '{'}, // e grave, e acute
+    {0x30, '+', '*', ']', '}'},
+    {0x33, 0, 0, '@'}, // o grave, c cedilla
+    {0x34, 0, 0, '#'}, // a grave, degree
+    {0x64, '<', '>'},
+    {0x36, ',', ';'},
+    {0x37, '.', ':'},
+    {0x38, '-', '_'},
+};
+
+static const test_keycap_t test_de_keys[] = {
+    {0x1E, '1', '!'},
+    {0x1F, '2', '"'},
+    {0x20, '3', 0},    // section sign
+    {0x21, '4', '$'},
+    {0x22, '5', '%'},
+    {0x23, '6', '&'},
+    {0x24, '7', '/', '{'},
+    {0x25, '8', '(', '['},
+    {0x26, '9', ')', ']'},
+    {0x27, '0', '=', '}'},
+    {0x2D, 0, '?', '\\'}, // sharp s
+    {0x14, 0, 0, '@'},    // Q
+    {0x30, '+', '*', '~'},
+    {0x32, '#', '\''},
+    {0x64, '<', '>', '|'},
+    {0x36, ',', ';'},
+    {0x37, '.', ':'},
+    {0x38, '-', '_'},
+};
+
+typedef struct
+{
+    hid_keymap_layout_t layout;
+    const char *name;
+    const test_keycap_t *keys;
+    uint8_t keys_count;
+    const char *missing; // printable characters that can't be typed
+} test_layout_t;
+
+static const test_layout_t test_layouts[] = {
+    {HID_KEYMAP_US, "us", test_us_keys, sizeof(test_us_keys) / sizeof(test_keycap_t), ""},
+    {HID_KEYMAP_IT, "it", test_it_keys, sizeof(test_it_keys) / sizeof(test_keycap_t), "`~"},
+    {HID_KEYMAP_DE, "de", test_de_keys, sizeof(test_de_keys) / sizeof(test_keycap_t), "^`"},
+};
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static bool test_expected(const test_layout_t *layout, char c, uint8_t *usage, uint8_t *modifiers);
+static void test_printable(const test_layout_t *layout);
+static void test_control(const test_layout_t *layout);
+static void test_selection(void);
+
+// FUNCTION DEFINITIONS
+
+int main(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < sizeof(test_layouts) / sizeof(test_layouts[0]); i++)
+    {
+        test_printable(&test_layouts[i]);
+        test_control(&test_layouts[i]);
+    }
+    test_selection();
+
+    return HOST_TEST_RESULT();
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+// What typing 'c' takes on a real keyboard with that layout
+static bool test_expected(const test_layout_t *layout, char c, uint8_t *usage, uint8_t *modifiers)
+{
+    const test_keycap_t *key;
+    char letter = c | 0x20;
+    uint8_t i;
+
+    if (letter >= 'a' && letter <= 'z')
+    {
+        *usage = 0x04 + (letter - 'a');
+        if (layout->layout == HID_KEYMAP_DE && letter == 'y')
+            *usage = 0x1D;
+        else if (layout->layout == HID_KEYMAP_DE && letter == 'z')
+            *usage = 0x1C;
+        *modifiers = (c == letter) ? NONE : SHIFT;
+        return true;
+    }
+
+    if (c == ' ')
+    {
+        *usage = 0x2C;
+        *modifiers = NONE;
+        return true;
+    }
+
+    for (i = 0; i < layout->keys_count; i++)
+    {
+        key = &layout->keys[i];
+        *usage = key->usage;
+        if (c == key->plain)
+            *modifiers = NONE;
+        else if (c == key->shift)
+            *modifiers = SHIFT;
+        else if (c == key->altgr)
+            *modifiers = ALTGR;
+        else if (c == key->altgr_shift)
+            *modifiers = ALTGR | SHIFT;
+        else
+            continue;
+        return true;
+    }
+
+    return false;
+}
+
+static void test_printable(const test_layout_t *layout)
+{
+    uint8_t usage, modifiers;
+    uint8_t expected_usage, expected_modifiers;
+    uint16_t seen[256] = {0}; // (usage, modifiers) already typed by another character
+    bool found;
+    int c;
+
+    for (c = 0x20; c < 0x7F; c++)
+    {
+        usage = modifiers = 0xFF;
+        found = hid_keymap_lookup_layout(layout->layout, (char)c, &usage, &modifiers);
+
+        if (strchr(layout->missing, c) != NULL)
+        {
+            HOST_CHECK(!found);
+            if (found)
+                printf("%s: '%c' should not be typed\n", layout->name, c);
+            continue;
+        }
+
+        HOST_CHECK(test_expected(layout, (char)c, &expected_usage, &expected_modifiers));
+        HOST_CHECK(found && usage == expected_usage && modifiers == expected_modifiers);
+        if (!found || usage != expected_usage || modifiers != expected_modifiers)
+            printf("%s: '%c' is %02x/%02x, expected %02x/%02x\n", layout->name, c,
+                   found ? usage : 0, found ? modifiers : 0, expected_usage, expected_modifiers);
+
+        // no two characters on the same key and modifiers
+        if (found)
+        {
+            HOST_CHECK(!(seen[usage] & (1 << (modifiers >> 4 | (modifiers & 0x0F)))));
+            seen[usage] |= 1 << (modifiers >> 4 | (modifiers & 0x0F));
+        }
+    }
+}
+
+static void test_control(const test_layout_t *layout)
+{
+    uint8_t usage, modifiers;
+
+    HOST_CHECK(hid_keymap_lookup_layout(layout->layout, '\n', &usage, &modifiers) &&
+               usage == 0x28 && modifiers == NONE);
+    HOST_CHECK(hid_keymap_lookup_layout(layout->layout, '\t', &usage, &modifiers) &&
+               usage == 0x2B && modifiers == NONE);
+    HOST_CHECK(hid_keymap_lookup_layout(layout->layout, '\b', &usage, &modifiers) &&
+               usage == 0x2A && modifiers == NONE);
+
+    // neither the other control characters nor anything past ASCII
+    HOST_CHECK(!hid_keymap_lookup_layout(layout->layout, '\0', &usage, &modifiers));
+    HOST_CHECK(!hid_keymap_lookup_layout(layout->layout, 0x1B, &usage, &modifiers));
+    HOST_CHECK(!hid_keymap_lookup_layout(layout->layout, 0x7F, &usage, &modifiers));
+    HOST_CHECK(!hid_keymap_lookup_layout(layout->layout, (char)0xE8, &usage, &modifiers));
+}
+
+static void test_selection(void)
+{
+    uint8_t usage, modifiers;
+    uint8_t i;
+
+    HOST_CHECK(hid_keymap_selected() == HID_KEYMAP_US);
+
+    for (i = 0; i < sizeof(test_layouts) / sizeof(test_layouts[0]); i++)
+    {
+        HOST_CHECK_STR(hid_keymap_name(test_layouts[i].layout), test_layouts[i].name);
+        HOST_CHECK(hid_keymap_from_name(test_layouts[i].name) == test_layouts[i].layout);
+    }
+    HOST_CHECK(hid_keymap_from_name("fr") == HID_KEYMAP_LAYOUTS);
+    HOST_CHECK(!hid_keymap_lookup_layout(HID_KEYMAP_LAYOUTS, 'a', &usage, &modifiers));
+
+    // hid_keymap_lookup() follows the selection, unknown layouts are ignored
+    hid_keymap_select(HID_KEYMAP_DE);
+    HOST_CHECK(hid_keymap_lookup('z', &usage, &modifiers) && usage == 0x1C);
+    hid_keymap_select(HID_KEYMAP_LAYOUTS);
+    HOST_CHECK(hid_keymap_selected() == HID_KEYMAP_DE);
+    hid_keymap_select(HID_KEYMAP_US);
+    HOST_CHECK(hid_keymap_lookup('z', &usage, &modifiers) && usage == 0x1D);
+}
@@ -0,0 +1,192 @@
+/*
+ * input_ring stress test: a producer thread (the ISR) and a consumer
+ * thread (the io task) run flat out on millions of events. Every event
+ * carries its sequence number, the consumer checks that they come out in
+ * order and untorn, and at the end popped + dropped must equal pushed.
+ * With a retrying producer nothing may be lost, with a lossy producer and
+ * a lagging consumer the ring overflows most of the time.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#include "host_test.h"
+#include "input_ring.h"
+
+#define TEST_EVENTS 4000000
+
+// a payload that can't be confused with a stale slot
+#define TEST_BUTTON(sequence) ((uint8_t)((sequence) * 31 + 7))
+#define TEST_LEVEL(sequence) ((uint8_t)((sequence) >> 3 & 1))
+
+typedef struct
+{
+    input_ring_t ring;
+    bool retry;            // producer pushes again until the event fits
+    uint32_t consumer_lag; // busy loops before each pop, to force drops
+    uint32_t pushed;       // calls to input_ring_push()
+    uint32_t accepted;     // pushes that returned true
+    uint32_t done;         // set by the producer when finished
+    // consumer results
+    uint32_t popped;
+    uint32_t out_of_order;
+    uint32_t skipped; // gaps in the sequence
+    uint32_t torn;
+} test_stress_t;
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static void *test_producer(void *arg);
+static void *test_consumer(void *arg);
+static void test_stress(bool retry, uint32_t consumer_lag);
+static void test_wrap(void);
+
+// FUNCTION DEFINITIONS
+
+int main(void)
+{
+    test_wrap();
+
+    // retrying producer: nothing lost, even with a slow consumer
+    test_stress(true, 0);
+    test_stress(true, 100);
+    // ISR-like producer: the ring overflows and the drops are counted
+    test_stress(false, 0);
+    test_stress(false, 100);
+
+    return HOST_TEST_RESULT();
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+static void *test_producer(void *arg)
+{
+    test_stress_t *test = arg;
+    input_ring_event_t event;
+    uint32_t sequence;
+
+    for (sequence = 1; sequence <= TEST_EVENTS; sequence++)
+    {
+        event.time_us = sequence;
+        event.button = TEST_BUTTON(sequence);
+        event.level = TEST_LEVEL(sequence);
+        for (;;)
+        {
+            test->pushed++;
+            if (input_ring_push(&test->ring, &event))
+            {
+                test->accepted++;
+                break;
+            }
+            if (!test->retry)
+                break;
+            sched_yield();
+        }
+    }
+    __atomic_store_n(&test->done, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static void *test_consumer(void *arg)
+{
+    test_stress_t *test = arg;
+    input_ring_event_t event;
+    uint32_t last = 0;
+    volatile uint32_t lag;
+    uint32_t done;
+
+    for (;;)
+    {
+        // read 'done' first so the last pushes are seen by the pop after it
+        done = __atomic_load_n(&test->done, __ATOMIC_ACQUIRE);
+        for (lag = 0; lag < test->consumer_lag; lag++)
+            ;
+        if (!input_ring_pop(&test->ring, &event))
+        {
+            if (done)
+                break;
+            // let the producer run if both share a core
+            sched_yield();
+            continue;
+        }
+        test->popped++;
+        if (event.time_us <= last)
+            test->out_of_order++;
+        else if (event.time_us != last + 1)
+            test->skipped++;
+        if (event.button != TEST_BUTTON(event.time_us) || event.level != TEST_LEVEL(event.time_us))
+            test->torn++;
+        last = event.time_us;
+    }
+
+    return NULL;
+}
+
+static void test_stress(bool retry, uint32_t consumer_lag)
+{
+    static test_stress_t test;
+    pthread_t producer, consumer;
+
+    input_ring_init(&test.ring);
+    test.retry = retry;
+    test.consumer_lag = consumer_lag;
+    test.pushed = 0;
+    test.accepted = 0;
+    test.done = 0;
+    test.popped = 0;
+    test.out_of_order = 0;
+    test.skipped = 0;
+    test.torn = 0;
+
+    HOST_CHECK(pthread_create(&consumer, NULL, test_consumer, &test) == 0);
+    HOST_CHECK(pthread_create(&producer, NULL, test_producer, &test) == 0);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    printf("%s, lag %u: %u pushed, %u popped, %u dropped\n", retry ? "retry" : "lossy", consumer_lag,
+           test.pushed, test.popped, input_ring_dropped(&test.ring));
+
+    HOST_CHECK(test.out_of_order == 0);
+    HOST_CHECK(test.torn == 0);
+    HOST_CHECK(test.popped == test.accepted);
+    HOST_CHECK(test.popped + input_ring_dropped(&test.ring) == test.pushed);
+    if (retry)
+    {
+        // every sequence number made it through, one after the other
+        HOST_CHECK(test.popped == TEST_EVENTS);
+        HOST_CHECK(test.skipped == 0);
+    }
+    else
+    {
+        HOST_CHECK(test.pushed == TEST_EVENTS);
+        // each gap is made of dropped events only
+        HOST_CHECK(test.skipped <= input_ring_dropped(&test.ring));
+    }
+}
+
+// Indexes running free across 2^32, single threaded
+static void test_wrap(void)
+{
+    input_ring_t ring;
+    input_ring_event_t event = {0};
+    uint32_t i;
+
+    input_ring_init(&ring);
+    ring.head = ring.tail = UINT32_MAX - INPUT_RING_SIZE / 2;
+
+    for (i = 0; i < INPUT_RING_SIZE; i++)
+    {
+        event.time_us = i;
+        HOST_CHECK(input_ring_push(&ring, &event));
+    }
+    event.time_us = INPUT_RING_SIZE;
+    HOST_CHECK(!input_ring_push(&ring, &event));
+    HOST_CHECK(input_ring_dropped(&ring) == 1);
+
+    for (i = 0; i < INPUT_RING_SIZE; i++)
+        HOST_CHECK(input_ring_pop(&ring, &event) && event.time_us == i);
+    HOST_CHECK(!input_ring_pop(&ring, &event));
+    HOST_CHECK(ring.head == INPUT_RING_SIZE / 2 - 1);
+}
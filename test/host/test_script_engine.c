@@ -0,0 +1,385 @@
+/*
+ * Script engine tests on the recording transport: text typing (rollover,
+ * modifiers, CapsLock), the script opcodes (PRESS/RELEASE/WAIT, REPEAT,
+ * JUMP_IF_LED, CALL, TYPE_STRING), the mouse moves, the taps, the
+ * consumer keys and the virtual timing of the reports.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "app_script.h"
+#include "script_engine.h"
+#include "hid_keymap.h"
+#include "hid_dev.h"
+#include "recording_transport.h"
+
+static recording_transport_t test_recording;
+static script_engine_t test_engine;
+static char test_text[2048];
+static char test_times_text[512];
+
+// scripts for CALL, by id
+static const uint8_t test_call_a[] = {HID_KEY_A};
+static const uint8_t test_call_b[] = {APP_SCRIPT_OP_CALL, 1, HID_KEY_B};
+static const uint8_t test_call_self[] = {APP_SCRIPT_OP_CALL, 3, HID_KEY_A};
+static const uint8_t test_call_repeat[] = {APP_SCRIPT_OP_REPEAT, 2, 1, HID_KEY_C};
+
+// LOCAL FUNCTIONS PROTOTYPES
+
+static const char *test_type(const char *text, uint8_t rollover_keys, uint8_t leds);
+static const char *test_run(const uint8_t *script, uint8_t length, uint8_t leds);
+static const char *test_times(void);
+static void test_modifiers_released(void);
+static void test_rollover(void);
+static void test_timing(void);
+static void test_press_release_wait(void);
+static void test_repeat(void);
+static void test_jump_if_led(void);
+static void test_call(void);
+static void test_type_string(void);
+static void test_mouse_move(void);
+static void test_tap(void);
+static void test_consumer(void);
+static void test_caps_lock(void);
+
+// FUNCTION DEFINITIONS
+
+int main(void)
+{
+    test_modifiers_released();
+    test_rollover();
+    test_timing();
+    test_press_release_wait();
+    test_repeat();
+    test_jump_if_led();
+    test_call();
+    test_type_string();
+    test_mouse_move();
+    test_tap();
+    test_consumer();
+    test_caps_lock();
+
+    return HOST_TEST_RESULT();
+}
+
+// LOCAL FUNCTION DEFINITIONS
+
+// Types 'text' with TYPE_STRING, returns the reports as text
+static const char *test_type(const char *text, uint8_t rollover_keys, uint8_t leds)
+{
+    static const uint8_t script[] = {APP_SCRIPT_OP_TYPE_STRING, 0};
+    script_engine_config_t config;
+
+    recording_transport_init(&test_recording);
+    test_recording.strings[0] = text;
+    test_recording.leds = leds;
+
+    script_engine_init(&test_engine, &test_recording.transport);
+    config = test_engine.config;
+    config.rollover_keys = rollover_keys;
+    script_engine_set_config(&test_engine, &config);
+
+    recording_transport_run(&test_recording, &test_engine, script, sizeof(script));
+    recording_transport_format(&test_recording, test_text, sizeof(test_text));
+
+    return test_text;
+}
+
+// Runs 'script' with the CALL scripts above, returns the reports as text
+static const char *test_run(const uint8_t *script, uint8_t length, uint8_t leds)
+{
+    recording_transport_init(&test_recording);
+    test_recording.leds = leds;
+    test_recording.scripts[1] = test_call_a;
+    test_recording.scripts_length[1] = sizeof(test_call_a);
+    test_recording.scripts[2] = test_call_b;
+    test_recording.scripts_length[2] = sizeof(test_call_b);
+    test_recording.scripts[3] = test_call_self;
+    test_recording.scripts_length[3] = sizeof(test_call_self);
+    test_recording.scripts[4] = test_call_repeat;
+    test_recording.scripts_length[4] = sizeof(test_call_repeat);
+
+    script_engine_init(&test_engine, &test_recording.transport);
+    recording_transport_run(&test_recording, &test_engine, script, length);
+    recording_transport_format(&test_recording, test_text, sizeof(test_text));
+
+    return test_text;
+}
+
+// Virtual times of the last run's reports, e.g. "0,20,20"
+static const char *test_times(void)
+{
+    size_t length = 0;
+    uint32_t i;
+
+    test_times_text[0] = '\0';
+    for (i = 0; i < test_recording.count && length < sizeof(test_times_text); i++)
+        length += snprintf(test_times_text + length, sizeof(test_times_text) - length, i ? ",%u" : "%u",
+                           test_recording.reports[i].time_ms);
+
+    return test_times_text;
+}
+
+// Shift and AltGr must not stay held after the last character
+static void test_modifiers_released(void)
+{
+    HOST_CHECK_STR(test_type("abC", 6, 0), "[00:][00:04][00:04,05][00:][02:06][00:]");
+    HOST_CHECK_STR(test_type("C", 1, 0), "[00:][02:06][00:]");
+    HOST_CHECK_STR(test_type("Ab", 6, 0), "[00:][02:04][00:][00:05][00:]");
+
+    hid_keymap_select(HID_KEYMAP_DE);
+    HOST_CHECK_STR(test_type("a@", 6, 0), "[00:][00:04][00:][40:14][00:]"); // AltGr+Q
+    hid_keymap_select(HID_KEYMAP_US);
+}
+
+static void test_rollover(void)
+{
+    // up to 6 keys per report, a repeated key needs a release in between
+    HOST_CHECK_STR(test_type("abcdefg", 6, 0),
+                   "[00:][00:04][00:04,05][00:04,05,06][00:04,05,06,07][00:04,05,06,07,08]"
+                   "[00:04,05,06,07,08,09][00:][00:0a][00:]");
+    HOST_CHECK_STR(test_type("aab", 6, 0), "[00:][00:04][00:][00:04][00:04,05][00:]");
+
+    // one key at a time
+    HOST_CHECK_STR(test_type("ab", 1, 0), "[00:][00:04][00:][00:05][00:]");
+
+    // characters the layout doesn't have are skipped
+    HOST_CHECK_STR(test_type("a\x01" "b", 6, 0), "[00:][00:04][00:][00:05][00:]");
+}
+
+static void test_timing(void)
+{
+    const recorded_report_t *reports = test_recording.reports;
+
+    // press 20 ms, rolled over keys right away, release 0 ms
+    test_type("abC", 6, 0);
+    HOST_CHECK(test_recording.count == 6);
+    HOST_CHECK(reports[0].time_ms == 0);  // nothing held
+    HOST_CHECK(reports[1].time_ms == 0);  // a
+    HOST_CHECK(reports[2].time_ms == 0);  // a b
+    HOST_CHECK(reports[3].time_ms == 20); // released
+    HOST_CHECK(reports[4].time_ms == 20); // C
+    HOST_CHECK(reports[5].time_ms == 40); // released
+    HOST_CHECK(test_engine.stats.last_script_ms == 40);
+    HOST_CHECK(test_recording.finished == 1);
+}
+
+// PRESS and RELEASE send right away, WAIT sets the pace, whatever is
+// still held is released when the script ends
+static void test_press_release_wait(void)
+{
+    static const uint8_t press_release[] = {
+        APP_SCRIPT_OP_PRESS, HID_KEY_LEFT_SHIFT,
+        APP_SCRIPT_OP_PRESS, HID_KEY_A,
+        APP_SCRIPT_OP_WAIT, 30, 0,
+        APP_SCRIPT_OP_PRESS, HID_KEY_B,
+        APP_SCRIPT_OP_PRESS, HID_KEY_B, // already held
+        APP_SCRIPT_OP_RELEASE, HID_KEY_A,
+        APP_SCRIPT_OP_WAIT, 0x01, 0x01, // 257 ms, little endian
+        APP_SCRIPT_OP_RELEASE, APP_SCRIPT_KEY_ALL,
+        APP_SCRIPT_OP_WAIT, 5, 0,
+    };
+    static const uint8_t left_held[] = {
+        APP_SCRIPT_OP_PRESS, HID_KEY_LEFT_CTRL,
+        APP_SCRIPT_OP_PRESS, HID_KEY_C,
+        APP_SCRIPT_OP_WAIT, 10, 0,
+    };
+    static const uint8_t too_many[] = {
+        APP_SCRIPT_OP_PRESS, HID_KEY_A, APP_SCRIPT_OP_PRESS, HID_KEY_B, APP_SCRIPT_OP_PRESS, HID_KEY_C,
+        APP_SCRIPT_OP_PRESS, HID_KEY_D, APP_SCRIPT_OP_PRESS, HID_KEY_E, APP_SCRIPT_OP_PRESS, HID_KEY_F,
+        APP_SCRIPT_OP_PRESS, HID_KEY_G, APP_SCRIPT_OP_RELEASE, HID_KEY_C,
+    };
+
+    HOST_CHECK_STR(test_run(press_release, sizeof(press_release), 0),
+                   "[02:][02:04][02:04,05][02:04,05][02:05][00:]");
+    HOST_CHECK_STR(test_times(), "0,0,30,30,30,287");
+    HOST_CHECK(test_engine.stats.last_script_ms == 292);
+
+    HOST_CHECK_STR(test_run(left_held, sizeof(left_held), 0), "[01:][01:06][00:]");
+    HOST_CHECK_STR(test_times(), "0,0,10");
+    HOST_CHECK(test_recording.finished == 1);
+
+    // a 7th key doesn't fit in the report
+    HOST_CHECK_STR(test_run(too_many, sizeof(too_many), 0),
+                   "[00:04][00:04,05][00:04,05,06][00:04,05,06,07][00:04,05,06,07,08]"
+                   "[00:04,05,06,07,08,09][00:04,05,06,07,08,09][00:04,05,07,08,09][00:]");
+}
+
+static void test_repeat(void)
+{
+    static const uint8_t three_times[] = {
+        APP_SCRIPT_OP_REPEAT, 3, 1, HID_KEY_A,
+        HID_KEY_B,
+    };
+    static const uint8_t never[] = {
+        APP_SCRIPT_OP_REPEAT, 0, 4, HID_KEY_A, APP_SCRIPT_OP_WAIT, 100, 0,
+        HID_KEY_B,
+    };
+    static const uint8_t with_wait[] = {
+        APP_SCRIPT_OP_REPEAT, 2, 5, APP_SCRIPT_OP_PRESS, HID_KEY_A, APP_SCRIPT_OP_WAIT, 40, 0,
+        APP_SCRIPT_OP_RELEASE, HID_KEY_A,
+    };
+
+    HOST_CHECK_STR(test_run(three_times, sizeof(three_times), 0),
+                   "[00:04][00:][00:04][00:][00:04][00:][00:05][00:]");
+    HOST_CHECK_STR(test_times(), "0,20,20,40,40,60,60,80");
+
+    HOST_CHECK_STR(test_run(never, sizeof(never), 0), "[00:05][00:]");
+    HOST_CHECK_STR(test_times(), "0,20");
+
+    // the body ends on the WAIT, the RELEASE after it runs once
+    HOST_CHECK_STR(test_run(with_wait, sizeof(with_wait), 0), "[00:04][00:04][00:]");
+    HOST_CHECK_STR(test_times(), "0,40,80");
+}
+
+static void test_jump_if_led(void)
+{
+    static const uint8_t skip_a[] = {
+        APP_SCRIPT_OP_JUMP_IF_LED, APP_SCRIPT_LED_CAPS_LOCK, 1, HID_KEY_A,
+        HID_KEY_B,
+    };
+    // the jump goes to the end of the body, the loop goes on
+    static const uint8_t in_repeat[] = {
+        APP_SCRIPT_OP_REPEAT, 2, 5, APP_SCRIPT_OP_JUMP_IF_LED, APP_SCRIPT_LED_NUM_LOCK, 2, HID_KEY_A,
+        HID_KEY_C,
+        HID_KEY_B,
+    };
+    // to the end of the script
+    static const uint8_t to_end[] = {
+        APP_SCRIPT_OP_JUMP_IF_LED, APP_SCRIPT_LED_SCROLL_LOCK | APP_SCRIPT_LED_NUM_LOCK, 2, HID_KEY_A,
+        HID_KEY_B,
+    };
+
+    HOST_CHECK_STR(test_run(skip_a, sizeof(skip_a), APP_SCRIPT_LED_CAPS_LOCK), "[00:05][00:]");
+    HOST_CHECK_STR(test_run(skip_a, sizeof(skip_a), APP_SCRIPT_LED_NUM_LOCK), "[00:04][00:][00:05][00:]");
+
+    HOST_CHECK_STR(test_run(in_repeat, sizeof(in_repeat), APP_SCRIPT_LED_NUM_LOCK), "[00:05][00:]");
+    HOST_CHECK_STR(test_run(in_repeat, sizeof(in_repeat), 0),
+                   "[00:04][00:][00:06][00:][00:04][00:][00:06][00:][00:05][00:]");
+
+    HOST_CHECK_STR(test_run(to_end, sizeof(to_end), APP_SCRIPT_LED_SCROLL_LOCK), "");
+    HOST_CHECK(test_recording.finished == 1);
+    HOST_CHECK_STR(test_run(to_end, sizeof(to_end), APP_SCRIPT_LED_CAPS_LOCK), "[00:04][00:][00:05][00:]");
+}
+
+static void test_call(void)
+{
+    static const uint8_t nested[] = {APP_SCRIPT_OP_CALL, 2, HID_KEY_C};
+    // 3 calls itself: the third level is refused, each level types its A
+    static const uint8_t recursive[] = {APP_SCRIPT_OP_CALL, 3, HID_KEY_B};
+    // the REPEAT of the called script doesn't end the caller's one
+    static const uint8_t repeated[] = {APP_SCRIPT_OP_REPEAT, 2, 2, APP_SCRIPT_OP_CALL, 4, HID_KEY_B};
+    static const uint8_t unknown[] = {APP_SCRIPT_OP_CALL, 7, APP_SCRIPT_OP_CALL, 200, HID_KEY_B};
+
+    HOST_CHECK_STR(test_run(nested, sizeof(nested), 0), "[00:04][00:][00:05][00:][00:06][00:]");
+    HOST_CHECK_STR(test_times(), "0,20,20,40,40,60");
+    HOST_CHECK(test_engine.call_depth == 0);
+
+    HOST_CHECK_STR(test_run(recursive, sizeof(recursive), 0), "[00:04][00:][00:04][00:][00:05][00:]");
+    HOST_CHECK(test_recording.finished == 1);
+
+    HOST_CHECK_STR(test_run(repeated, sizeof(repeated), 0),
+                   "[00:06][00:][00:06][00:][00:06][00:][00:06][00:][00:05][00:]");
+
+    HOST_CHECK_STR(test_run(unknown, sizeof(unknown), 0), "[00:05][00:]");
+}
+
+static void test_type_string(void)
+{
+    static const uint8_t strings[] = {
+        APP_SCRIPT_OP_TYPE_STRING, 5, // unknown, skipped
+        APP_SCRIPT_OP_TYPE_STRING, 0,
+        HID_KEY_C,
+    };
+
+    recording_transport_init(&test_recording);
+    test_recording.strings[0] = "ab";
+
+    script_engine_init(&test_engine, &test_recording.transport);
+    recording_transport_run(&test_recording, &test_engine, strings, sizeof(strings));
+    recording_transport_format(&test_recording, test_text, sizeof(test_text));
+
+    HOST_CHECK_STR(test_text, "[00:][00:04][00:04,05][00:][00:06][00:]");
+    HOST_CHECK_STR(test_times(), "0,0,0,20,20,40");
+}
+
+// X and Y are int16, little endian, the whole move goes in one report
+static void test_mouse_move(void)
+{
+    static const uint8_t moves[] = {
+        APP_SCRIPT_OP_MOUSE_MOVE, 0x2c, 0x01, 0x38, 0xff, // 300, -200
+        APP_SCRIPT_OP_MOUSE_MOVE, 0xff, 0x7f, 0x00, 0x80, // 32767, -32768
+        APP_SCRIPT_OP_MOUSE_MOVE, 0xff, 0xff, 0x01, 0x00, // -1, 1
+        APP_SCRIPT_OP_MOUSE_LEFT,
+        APP_SCRIPT_OP_MOUSE_MOVE, 0x00, 0x00, 0x80, 0x00, // 0, 128
+    };
+
+    HOST_CHECK_STR(test_run(moves, sizeof(moves), 0),
+                   "{0,300,-200,0,0}{0,32767,-32768,0,0}{0,-1,1,0,0}{1,0,0,0,0}{0,0,0,0,0}{0,0,128,0,0}");
+    HOST_CHECK_STR(test_times(), "0,0,0,0,50,50");
+    HOST_CHECK(test_engine.stats.reports_sent == 6);
+}
+
+// X% and Y% become 0..10000, the finger is lifted after mouse_click_ms
+static void test_tap(void)
+{
+    static const uint8_t taps[] = {
+        APP_SCRIPT_OP_TAP, 25, 50,
+        APP_SCRIPT_OP_TAP, 0, 100,
+        APP_SCRIPT_OP_TAP, 101, 255, // past the edge, on the edge
+        HID_KEY_A,
+    };
+    script_engine_config_t config;
+
+    HOST_CHECK_STR(test_run(taps, sizeof(taps), 0),
+                   "(2500,5000)(-)(0,10000)(-)(10000,10000)(-)[00:04][00:]");
+    HOST_CHECK_STR(test_times(), "0,50,50,100,100,150,150,170");
+
+    // with another click time
+    recording_transport_init(&test_recording);
+    script_engine_init(&test_engine, &test_recording.transport);
+    config = test_engine.config;
+    config.mouse_click_ms = 80;
+    config.key_release_ms = 5;
+    script_engine_set_config(&test_engine, &config);
+    HOST_CHECK(recording_transport_run(&test_recording, &test_engine, taps, 3) == 85);
+    recording_transport_format(&test_recording, test_text, sizeof(test_text));
+    HOST_CHECK_STR(test_text, "(2500,5000)(-)");
+    HOST_CHECK_STR(test_times(), "0,80");
+}
+
+// Pressed and released like a keyboard key
+static void test_consumer(void)
+{
+    static const uint8_t keys[] = {
+        APP_SCRIPT_OP_CONSUMER, HID_CONSUMER_MUTE,
+        APP_SCRIPT_OP_CONSUMER, HID_CONSUMER_VOLUME_UP,
+        HID_KEY_A,
+        APP_SCRIPT_OP_CONSUMER, HID_CONSUMER_PLAY_PAUSE,
+    };
+
+    HOST_CHECK_STR(test_run(keys, sizeof(keys), 0), "<226+><226-><233+><233->[00:04][00:]<205+><205->");
+    HOST_CHECK_STR(test_times(), "0,20,20,40,40,60,60,80");
+    HOST_CHECK(test_engine.stats.last_script_ms == 80);
+
+    // a transport without consumer reports skips them
+    recording_transport_init(&test_recording);
+    test_recording.transport.send_consumer = NULL;
+    script_engine_init(&test_engine, &test_recording.transport);
+    recording_transport_run(&test_recording, &test_engine, keys, sizeof(keys));
+    recording_transport_format(&test_recording, test_text, sizeof(test_text));
+    HOST_CHECK_STR(test_text, "[00:04][00:]");
+}
+
+// With the host CapsLock on it's turned off before typing and on again
+// when the script ends
+static void test_caps_lock(void)
+{
+    HOST_CHECK_STR(test_type("aB", 6, APP_SCRIPT_LED_CAPS_LOCK),
+                   "[00:39][00:][00:04][00:][02:05][00:][00:39][00:]");
+
+    // no letters, nothing to do
+    HOST_CHECK_STR(test_type("12", 6, APP_SCRIPT_LED_CAPS_LOCK), "[00:][00:1e][00:1e,1f][00:]");
+}